@@ -0,0 +1,705 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+#include "../Utils/BatchDispatcher.hpp"
+#include "../Utils/Channel.hpp"
+#include "../Utils/EventBus.hpp"
+#include "../Utils/EventNormal.hpp"
+#include "../Utils/InplaceFunction.hpp"
+#include "../Utils/LatencyHistogram.hpp"
+#include "../Utils/SharedEventRing.hpp"
+#include "../Utils/WorkStealingPool.hpp"
+#include "EventMicrobenchmarks.hpp"
+
+#ifndef _WIN32
+#include <sched.h>
+#endif
+
+/**
+ * ¼ַܻ׼
+ * ÿвѽӡ׼ main аã
+ * Ż벢ȹ EventMicrobenchmarks ׼еʵ
+ */
+namespace EventBenchmarks {
+    namespace Detail {
+        using EventMicrobenchmarks::Detail::Consume;
+
+        /**
+         * õ̳߳أ̹߳һĶ
+         */
+        class MutexQueuePool {
+        public:
+            explicit MutexQueuePool(size_t threadCount) {
+                for (size_t i = 0; i < threadCount; ++i) {
+                    _threads.emplace_back([this]() {
+                        for (;;) {
+                            std::function<void()> task;
+                            {
+                                std::unique_lock<std::mutex> lock(_mutex);
+                                _condition.wait(lock, [this] { return _stopping || !_tasks.empty(); });
+                                if (_tasks.empty()) return;
+                                task = std::move(_tasks.front());
+                                _tasks.pop_front();
+                            }
+                            task();
+                        }
+                    });
+                }
+            }
+
+            ~MutexQueuePool() {
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    _stopping = true;
+                }
+                _condition.notify_all();
+                for (auto& thread : _threads) thread.join();
+            }
+
+            template<typename F>
+            void operator()(F&& function) {
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    _tasks.emplace_back(std::forward<F>(function));
+                }
+                _condition.notify_one();
+            }
+
+        private:
+            std::vector<std::thread> _threads;
+            std::deque<std::function<void()>> _tasks;
+            std::mutex _mutex;
+            std::condition_variable _condition;
+            bool _stopping = false;
+        };
+
+        /**
+         * ȴ
+         */
+        inline void WaitFor(const std::atomic<size_t>& remaining) {
+            while (remaining.load() != 0) std::this_thread::yield();
+        }
+
+        /**
+         * ڵݹύֱ
+         */
+        template<typename TPool>
+        void Spawn(TPool& pool, std::atomic<size_t>& remaining, uint32_t depth) {
+            if (depth > 0) {
+                pool([&pool, &remaining, depth] { Spawn(pool, remaining, depth - 1); });
+                pool([&pool, &remaining, depth] { Spawn(pool, remaining, depth - 1); });
+            }
+            Consume(static_cast<int>(depth));
+            remaining.fetch_sub(1);
+        }
+
+        /**
+         * ȳصÿⲿ߳ύڵݹύ¼ 16 첽
+         */
+        template<typename TPool>
+        void MeasureFanOut(const char* name, TPool& pool, size_t taskCount, uint32_t treeDepth, size_t eventCount) {
+            using Clock = std::chrono::steady_clock;
+            std::atomic<size_t> remaining{ taskCount };
+            auto start = Clock::now();
+            for (size_t i = 0; i < taskCount; ++i) {
+                pool([&remaining, i] {
+                    Consume(static_cast<int>(i));
+                    remaining.fetch_sub(1);
+                });
+            }
+            WaitFor(remaining);
+            const double flat = taskCount / std::chrono::duration<double>(Clock::now() - start).count();
+
+            const size_t treeTasks = (size_t(2) << treeDepth) - 1;
+            remaining.store(treeTasks);
+            start = Clock::now();
+            pool([&pool, &remaining, treeDepth] { Spawn(pool, remaining, treeDepth); });
+            WaitFor(remaining);
+            const double tree = treeTasks / std::chrono::duration<double>(Clock::now() - start).count();
+
+            constexpr size_t HandlerCount = 16;
+            ThreadSafeEventNormal<int> event;
+            for (size_t i = 0; i < HandlerCount; ++i) {
+                event += [&remaining](int value) {
+                    Consume(value);
+                    remaining.fetch_sub(1);
+                };
+            }
+            remaining.store(eventCount * HandlerCount);
+            start = Clock::now();
+            for (size_t i = 0; i < eventCount; ++i) event.Async(pool, static_cast<int>(i));
+            WaitFor(remaining);
+            const double fanOut = eventCount * HandlerCount / std::chrono::duration<double>(Clock::now() - start).count();
+
+            std::cout << "Thread pool " << name << ": external " << static_cast<uint64_t>(flat)
+                << " tasks/sec, recursive " << static_cast<uint64_t>(tree) << " tasks/sec, event fan-out "
+                << static_cast<uint64_t>(fanOut) << " handlers/sec\n";
+        }
+
+        /**
+         * ѵǰ̰߳󶨵һ߼
+         * @param cpu ţWindows ֵֻ֧ǰǰ64
+         * @return Ƿɹ
+         */
+        inline bool PinCurrentThread(uint32_t cpu) {
+#ifdef _WIN32
+            if (cpu >= 64) return false;
+            return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) != 0;
+#elif defined(__linux__)
+            if (cpu >= CPU_SETSIZE) return false;
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(cpu, &cpus);
+            return sched_setaffinity(0, sizeof(cpus), &cpus) == 0;
+#else
+            return false;
+#endif
+        }
+
+        /**
+         * õͨ std::dequeӿ MpmcChannel ͬ
+         */
+        template<typename T>
+        class MutexChannel {
+        public:
+            typedef T value_type;
+
+            explicit MutexChannel(size_t capacity) : _capacity(capacity) {}
+
+            bool TryPush(T item) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (_items.size() >= _capacity) return false;
+                _items.push_back(std::move(item));
+                return true;
+            }
+
+            size_t TryPushN(T* items, size_t count) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                const size_t pushed = std::min(count, _capacity - _items.size());
+                for (size_t i = 0; i < pushed; ++i) _items.push_back(std::move(items[i]));
+                return pushed;
+            }
+
+            bool TryPop(T& item) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (_items.empty()) return false;
+                item = std::move(_items.front());
+                _items.pop_front();
+                return true;
+            }
+
+            size_t TryPopN(T* items, size_t maxCount) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                const size_t popped = std::min(maxCount, _items.size());
+                for (size_t i = 0; i < popped; ++i) {
+                    items[i] = std::move(_items.front());
+                    _items.pop_front();
+                }
+                return popped;
+            }
+
+        private:
+            std::deque<T> _items;
+            std::mutex _mutex;
+            const size_t _capacity;
+        };
+
+        /**
+         *  batch Ԫأʱóԣbatch Ϊ1ʱʹõԪؽӿ
+         */
+        template<typename TChannel>
+        void PushAll(TChannel& channel, uint64_t* items, size_t batch) {
+            if (batch == 1) {
+                while (!channel.TryPush(items[0])) std::this_thread::yield();
+                return;
+            }
+            for (size_t pushed = 0; pushed < batch;) {
+                const size_t count = channel.TryPushN(items + pushed, batch - pushed);
+                if (count == 0) std::this_thread::yield();
+                pushed += count;
+            }
+        }
+
+        /**
+         * ߸ threadCount ֱڸϣͨ count 
+         * @return ÿ봫ݵԪ
+         */
+        template<typename TChannel>
+        double MeasureChannelThroughput(size_t count, size_t batch, const std::vector<uint32_t>& producerCpus,
+            const std::vector<uint32_t>& consumerCpus) {
+            TChannel channel(1024);
+            const size_t producers = producerCpus.size();
+            const size_t perProducer = count / producers / batch * batch;
+            const size_t total = perProducer * producers;
+            std::atomic<size_t> consumed{ 0 };
+            std::atomic<size_t> ready{ 0 };
+            std::atomic<bool> start{ false };
+            std::vector<std::thread> threads;
+            for (uint32_t cpu : producerCpus) {
+                threads.emplace_back([&, cpu] {
+                    PinCurrentThread(cpu);
+                    std::vector<uint64_t> items(batch);
+                    ready.fetch_add(1);
+                    while (!start.load()) std::this_thread::yield();
+                    for (size_t i = 0; i < perProducer; i += batch) {
+                        for (size_t k = 0; k < batch; ++k) items[k] = i + k;
+                        PushAll(channel, items.data(), batch);
+                    }
+                });
+            }
+            for (uint32_t cpu : consumerCpus) {
+                threads.emplace_back([&, cpu] {
+                    PinCurrentThread(cpu);
+                    std::vector<uint64_t> items(batch);
+                    ready.fetch_add(1);
+                    while (!start.load()) std::this_thread::yield();
+                    while (consumed.load(std::memory_order_relaxed) < total) {
+                        size_t count = batch == 1 ? (channel.TryPop(items[0]) ? 1 : 0) : channel.TryPopN(items.data(), batch);
+                        if (count == 0) {
+                            std::this_thread::yield();
+                            continue;
+                        }
+                        for (size_t k = 0; k < count; ++k) Consume(static_cast<int>(items[k]));
+                        consumed.fetch_add(count, std::memory_order_relaxed);
+                    }
+                });
+            }
+            while (ready.load() != threads.size()) std::this_thread::yield();
+            const auto begin = std::chrono::steady_clock::now();
+            start.store(true);
+            for (auto& thread : threads) thread.join();
+            return total / std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        }
+
+        /**
+         * ߳̾һͨʱ¼ӳ٣ʱһ룬룩
+         * ͬһʱѯóת
+         * @return ӳٷֲ
+         */
+        template<typename TChannel>
+        HistogramSnapshot MeasureChannelLatency(size_t roundTrips, uint32_t pingCpu, uint32_t pongCpu) {
+            TChannel ping(64), pong(64);
+            const bool shared = pingCpu == pongCpu;
+            auto poll = [shared] {
+                if (shared) std::this_thread::yield();
+            };
+            std::thread echo([&] {
+                PinCurrentThread(pongCpu);
+                uint64_t value;
+                for (size_t i = 0; i < roundTrips; ++i) {
+                    while (!ping.TryPop(value)) poll();
+                    while (!pong.TryPush(value)) poll();
+                }
+            });
+            PinCurrentThread(pingCpu);
+            LatencyHistogram histogram;
+            uint64_t value;
+            for (size_t i = 0; i < roundTrips; ++i) {
+                const auto sent = std::chrono::steady_clock::now();
+                while (!ping.TryPush(i)) poll();
+                while (!pong.TryPop(value)) poll();
+                histogram.Record(static_cast<uint64_t>(
+                    std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - sent).count() / 2));
+            }
+            echo.join();
+            HistogramSnapshot snapshot;
+            histogram.AddTo(snapshot);
+            return snapshot;
+        }
+
+        /**
+         *  MeasureChannelLatency ͬ˶ӿڣʱ futex 
+         */
+        template<typename TQueue>
+        HistogramSnapshot MeasureBlockingChannelLatency(size_t roundTrips, uint32_t pingCpu, uint32_t pongCpu) {
+            BlockingChannel<TQueue> ping(64), pong(64);
+            std::thread echo([&] {
+                PinCurrentThread(pongCpu);
+                uint64_t value;
+                while (ping.Pop(value)) pong.Push(value);
+            });
+            PinCurrentThread(pingCpu);
+            LatencyHistogram histogram;
+            uint64_t value;
+            for (size_t i = 0; i < roundTrips; ++i) {
+                const auto sent = std::chrono::steady_clock::now();
+                ping.Push(i);
+                pong.Pop(value);
+                histogram.Record(static_cast<uint64_t>(
+                    std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - sent).count() / 2));
+            }
+            ping.Close();
+            echo.join();
+            HistogramSnapshot snapshot;
+            histogram.AddTo(snapshot);
+            return snapshot;
+        }
+    }
+
+    /**
+     * ڴ¼ķʱȡ˵Ľ붪ʧԼ¼ĵӳ
+     * ȡдͬһ̵Ĳͬ߳У԰ӳ乲ڴΣô·ͬ
+     * @param count ÿ¼
+     * @param maxReaders Ķȡ0ʼμһ
+     * @param roundTrips ӳٲ
+     */
+    inline void RunSharedEventBenchmark(size_t count = 10000000, size_t maxReaders = 2, size_t roundTrips = 200000) {
+        struct Quote {
+            uint64_t sequence;
+            int64_t timestamp;
+            double price;
+            int32_t quantity;
+            char symbol[20];
+        };
+        using Clock = std::chrono::steady_clock;
+
+        for (size_t readerCount = 0; readerCount <= maxReaders; ++readerCount) {
+            SharedEventWriter<Quote> writer("EventBenchmarks.quotes", 4096);
+            std::atomic<size_t> ready{ 0 };
+            std::vector<uint64_t> received(readerCount), dropped(readerCount);
+            std::vector<std::thread> readers;
+            for (size_t i = 0; i < readerCount; ++i) {
+                readers.emplace_back([&, i] {
+                    SharedEventReader<Quote> reader("EventBenchmarks.quotes");
+                    ready.fetch_add(1);
+                    Quote quote;
+                    for (;;) {
+                        const bool closed = reader.IsClosed();
+                        if (reader.TryRead(quote)) {
+                            Detail::Consume(quote.quantity);
+                            ++received[i];
+                        }
+                        else if (closed) {
+                            break;
+                        }
+                        else {
+                            std::this_thread::yield();
+                        }
+                    }
+                    dropped[i] = reader.DroppedCount();
+                });
+            }
+            while (ready.load() != readerCount) std::this_thread::yield();
+
+            Quote quote{ 0, 0, 100.0, 1, "SYMBOL" };
+            const auto start = Clock::now();
+            for (size_t i = 0; i < count; ++i) {
+                quote.sequence = i;
+                quote.quantity = static_cast<int32_t>(i);
+                writer.Publish(quote);
+            }
+            const double publishNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / count;
+            writer.Close();
+            for (auto& thread : readers) thread.join();
+
+            std::cout << "Shared event ring, " << readerCount << " readers: publish " << publishNs << " ns/event";
+            for (size_t i = 0; i < readerCount; ++i) {
+                std::cout << ", reader " << i << " received " << received[i] << " dropped " << dropped[i];
+            }
+            std::cout << "\n";
+        }
+
+        // ȡֻ֮󷢲¼ȴٿʼ
+        SharedEventWriter<Quote> ping("EventBenchmarks.ping", 64), pong("EventBenchmarks.pong", 64);
+        SharedEventReader<Quote> pingReader("EventBenchmarks.ping"), reader("EventBenchmarks.pong");
+        std::thread echo([&] {
+            Quote quote;
+            for (size_t i = 0; i < roundTrips; ++i) {
+                while (!pingReader.TryRead(quote)) std::this_thread::yield();
+                pong.Publish(quote);
+            }
+        });
+        LatencyHistogram histogram;
+        Quote quote{ 0, 0, 100.0, 1, "SYMBOL" };
+        for (size_t i = 0; i < roundTrips; ++i) {
+            const auto sent = Clock::now();
+            quote.sequence = i;
+            ping.Publish(quote);
+            while (!reader.TryRead(quote)) std::this_thread::yield();
+            histogram.Record(static_cast<uint64_t>(std::chrono::duration<double, std::nano>(Clock::now() - sent).count() / 2));
+        }
+        echo.join();
+        HistogramSnapshot snapshot;
+        histogram.AddTo(snapshot);
+        std::cout << "Shared event ring one-way latency: p50 " << snapshot.Percentile(0.5) << " ns, p99 "
+            << snapshot.Percentile(0.99) << " ns\n";
+    }
+
+    /**
+     * ؼ̳߳ʱؼӷʼִеӳ٣΢룩
+     * ÿ¼ slowHandlers ʱ slowWork ķദһĵĹؼ
+     * ¼ burst һ첽ÿִٷһ
+     * ֱȫΪͨȼ˳Ŷӣؼȡ Criticalȡ Background 
+     * @param threadCount ߳0 ʾʹӲ
+     * @param eventCount ¼
+     * @param slowHandlers ÿ¼
+     * @param slowWork ĺʱ
+     * @param burst ÿ¼
+     */
+    inline void RunPriorityDispatchBenchmark(size_t threadCount = 0, size_t eventCount = 20000, size_t slowHandlers = 8,
+        std::chrono::microseconds slowWork = std::chrono::microseconds(20), size_t burst = 16) {
+        using Clock = std::chrono::steady_clock;
+        if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+        for (bool prioritized : { false, true }) {
+            WorkStealingPool pool(threadCount);
+            ThreadSafeEventNormal<Clock::time_point> event;
+            std::mutex histogramMutex;
+            LatencyHistogram critical;
+            std::atomic<size_t> remaining{ 0 };
+
+            DispatchOptions slowOptions;
+            if (prioritized) slowOptions.priority = DispatchPriority::Background;
+            for (size_t i = 0; i < slowHandlers; ++i) {
+                event.Subscribe([&remaining, slowWork](Clock::time_point) {
+                    const auto until = Clock::now() + slowWork;
+                    while (Clock::now() < until) Detail::Consume(1);
+                    remaining.fetch_sub(1);
+                }, slowOptions);
+            }
+            DispatchOptions criticalOptions;
+            if (prioritized) criticalOptions.priority = DispatchPriority::Critical;
+            event.Subscribe([&](Clock::time_point published) {
+                const auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - published);
+                {
+                    std::lock_guard<std::mutex> lock(histogramMutex);
+                    critical.Record(static_cast<uint64_t>(latency.count()));
+                }
+                remaining.fetch_sub(1);
+            }, criticalOptions);
+
+            for (size_t sent = 0; sent < eventCount; sent += burst) {
+                const size_t count = std::min(burst, eventCount - sent);
+                remaining.store(count * (slowHandlers + 1));
+                for (size_t i = 0; i < count; ++i) event.Async(pool, Clock::now());
+                Detail::WaitFor(remaining);
+            }
+
+            HistogramSnapshot snapshot;
+            critical.AddTo(snapshot);
+            std::cout << "Priority dispatch " << (prioritized ? "critical/background" : "all normal")
+                << ": critical handler latency p50 " << snapshot.Percentile(0.5) / 1000.0 << " us, p99 "
+                << snapshot.Percentile(0.99) / 1000.0 << " us, max " << snapshot.max / 1000.0 << " us\n";
+        }
+    }
+
+    /**
+     * ͨڲ֮ͬӳ
+     * ÿ (0, i)SPSCMPMC 뻥еĵԪغ 64 ԪԪ/룩
+     * Լѯ futex ַʽĵӳٷλǶߡ MPMC 
+     * ֻһʱֻ (0, 0)˷ʱУҪӳл
+     * @param count ÿݵԪ
+     * @param roundTrips ÿӳٲ
+     */
+    inline void RunChannelBenchmark(size_t count = 10000000, size_t roundTrips = 200000) {
+        const uint32_t cpuCount = std::max(1u, std::thread::hardware_concurrency());
+        for (uint32_t cpu = cpuCount > 1 ? 1 : 0; cpu < cpuCount; ++cpu) {
+            const std::vector<uint32_t> producer{ 0 }, consumer{ cpu };
+            std::cout << "Channel cores 0->" << cpu << ": SPSC "
+                << static_cast<uint64_t>(Detail::MeasureChannelThroughput<SpscChannel<uint64_t>>(count, 1, producer, consumer))
+                << " / batch "
+                << static_cast<uint64_t>(Detail::MeasureChannelThroughput<SpscChannel<uint64_t>>(count, 64, producer, consumer))
+                << " items/sec, MPMC "
+                << static_cast<uint64_t>(Detail::MeasureChannelThroughput<MpmcChannel<uint64_t>>(count, 1, producer, consumer))
+                << " / batch "
+                << static_cast<uint64_t>(Detail::MeasureChannelThroughput<MpmcChannel<uint64_t>>(count, 64, producer, consumer))
+                << " items/sec, mutex "
+                << static_cast<uint64_t>(Detail::MeasureChannelThroughput<Detail::MutexChannel<uint64_t>>(count, 1, producer, consumer))
+                << " / batch "
+                << static_cast<uint64_t>(Detail::MeasureChannelThroughput<Detail::MutexChannel<uint64_t>>(count, 64, producer, consumer))
+                << " items/sec\n";
+
+            const HistogramSnapshot spin = Detail::MeasureChannelLatency<SpscChannel<uint64_t>>(roundTrips, 0, cpu);
+            const HistogramSnapshot blocking = Detail::MeasureBlockingChannelLatency<SpscChannel<uint64_t>>(roundTrips, 0, cpu);
+            std::cout << "Channel cores 0->" << cpu << " one-way latency: polling p50 " << spin.Percentile(0.5)
+                << " ns, p99 " << spin.Percentile(0.99) << " ns; futex p50 " << blocking.Percentile(0.5)
+                << " ns, p99 " << blocking.Percentile(0.99) << " ns\n";
+        }
+
+        for (uint32_t pairs = 1; pairs * 2 <= std::max(2u, cpuCount); pairs *= 2) {
+            std::vector<uint32_t> producers, consumers;
+            for (uint32_t i = 0; i < pairs; ++i) {
+                producers.push_back((i * 2) % cpuCount);
+                consumers.push_back((i * 2 + 1) % cpuCount);
+            }
+            std::cout << "Channel contention " << pairs << "x" << pairs << ": MPMC "
+                << static_cast<uint64_t>(Detail::MeasureChannelThroughput<MpmcChannel<uint64_t>>(count, 1, producers, consumers))
+                << " / batch "
+                << static_cast<uint64_t>(Detail::MeasureChannelThroughput<MpmcChannel<uint64_t>>(count, 64, producers, consumers))
+                << " items/sec, mutex "
+                << static_cast<uint64_t>(Detail::MeasureChannelThroughput<Detail::MutexChannel<uint64_t>>(count, 1, producers, consumers))
+                << " items/sec\n";
+        }
+    }
+
+    /**
+     * ¼ߵĵͬʱ룩밴 type_index ·ɵĶԱ
+     * ߶ͬһֶıһֻ·
+     * @param count 
+     */
+    inline void RunEventBusBenchmark(size_t count = 20000000) {
+        struct ConfigChanged { int value; };
+        struct CounterUpdated { int value; };
+        struct ConnectionClosed { int value; };
+        using Clock = std::chrono::steady_clock;
+
+        EventBus<ConfigChanged, CounterUpdated, ConnectionClosed> bus;
+        bus.Subscribe<CounterUpdated>([](const CounterUpdated& event) { Detail::Consume(event.value); });
+        auto start = Clock::now();
+        for (size_t i = 0; i < count; ++i) bus.Publish(CounterUpdated{ static_cast<int>(i) });
+        const double typed = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / count;
+
+        typedef SubscribeEvent<const void*> ErasedEvent;
+        std::unordered_map<std::type_index, ErasedEvent> topics;
+        topics[typeid(ConfigChanged)];
+        topics[typeid(ConnectionClosed)];
+        topics[typeid(CounterUpdated)].subscribe([](const void* event) {
+            Detail::Consume(static_cast<const CounterUpdated*>(event)->value);
+        });
+        start = Clock::now();
+        for (size_t i = 0; i < count; ++i) {
+            const CounterUpdated event{ static_cast<int>(i) };
+            auto it = topics.find(typeid(CounterUpdated));
+            if (it != topics.end()) it->second(&event);
+        }
+        const double erased = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / count;
+
+        std::cout << "Event bus publish: compile-time topic " << typed << " ns, type_index map " << erased << " ns\n";
+    }
+
+    /**
+     * ϲͶݶԴôͷʱӰ죺ͬһ·ֱ
+     *  64  1 봰ںϲÿ 1024  1 Ͷ
+     * @param count 
+     */
+    inline void RunBatchDispatchBenchmark(size_t count = 10000000) {
+        using Clock = std::chrono::steady_clock;
+        constexpr uint32_t KeyCount = 64;
+        std::atomic<uint64_t> calls{ 0 };
+
+        SubscribeEvent<uint32_t, uint64_t> direct;
+        direct.subscribe([&calls](uint32_t key, uint64_t value) {
+            Detail::Consume(static_cast<int>(key + value));
+            calls.fetch_add(1, std::memory_order_relaxed);
+        });
+        auto start = Clock::now();
+        for (size_t i = 0; i < count; ++i) direct(static_cast<uint32_t>(i % KeyCount), i);
+        const double directNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / count;
+        const uint64_t directCalls = calls.exchange(0);
+
+        BatchDispatcher dispatcher;
+        double coalescedNs, batchedNs;
+        uint64_t coalescedCalls, batchedCalls;
+        {
+            CoalescingEvent<uint32_t, uint64_t> coalescing(dispatcher, std::chrono::milliseconds(1));
+            coalescing.Subscribe([&calls](std::span<const std::pair<uint32_t, uint64_t>> changes) {
+                for (const auto& change : changes) Detail::Consume(static_cast<int>(change.first + change.second));
+                calls.fetch_add(1, std::memory_order_relaxed);
+            });
+            start = Clock::now();
+            for (size_t i = 0; i < count; ++i) coalescing.Publish(static_cast<uint32_t>(i % KeyCount), i);
+            coalescedNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / count;
+            coalescing.Flush();
+            coalescedCalls = calls.exchange(0);
+        }
+        {
+            BatchingEvent<uint64_t> batching(dispatcher, 1024, std::chrono::milliseconds(1));
+            std::atomic<size_t> delivered{ 0 };
+            batching.Subscribe([&calls, &delivered](std::span<const uint64_t> values) {
+                for (uint64_t value : values) Detail::Consume(static_cast<int>(value));
+                calls.fetch_add(1, std::memory_order_relaxed);
+                delivered.fetch_add(values.size());
+            });
+            start = Clock::now();
+            for (size_t i = 0; i < count; ++i) batching.Publish(i);
+            batchedNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / count;
+            while (delivered.load() < count) batching.Flush();
+            batchedCalls = calls.exchange(0);
+        }
+
+        std::cout << "Dispatch modes for " << count << " events: direct " << directCalls << " calls ("
+            << directNs << " ns/publish), coalescing " << coalescedCalls << " calls (" << coalescedNs
+            << " ns/publish), batching " << batchedCalls << " calls (" << batchedNs << " ns/publish)\n";
+    }
+
+    /**
+     * ȡ̳߳뵥̳߳ȳµԱ
+     * @param threadCount ߳0 ʾʹӲ
+     * @param taskCount ⲿ߳ύ
+     * @param treeDepth ݹύĶȣΪ 2^(depth+1)-1
+     * @param eventCount 첽¼ÿ¼ 16 
+     */
+    inline void RunThreadPoolBenchmark(size_t threadCount = 0, size_t taskCount = 1000000, uint32_t treeDepth = 20,
+        size_t eventCount = 100000) {
+        if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+        {
+            WorkStealingPool pool(threadCount);
+            Detail::MeasureFanOut("work-stealing", pool, taskCount, treeDepth, eventCount);
+        }
+        {
+            Detail::MutexQueuePool pool(threadCount);
+            Detail::MeasureFanOut("mutex-queue", pool, taskCount, treeDepth, eventCount);
+        }
+    }
+
+    /**
+     * 洢͵Ŀ룩std::functionInplaceFunction  FunctionRef Ĺӵá
+     * ൱Լ 1 nsһμӵãڹ죬 4 ָʱ std::function Ҫѷ
+     * @param count ÿĴ
+     */
+    inline void RunHandlerDispatchBenchmark(size_t count = 20000000) {
+        using namespace EventMicrobenchmarks::Detail;
+        const double functionBuild = ConstructAndCall<std::function<void(int)>>(count) / count;
+        const double inplaceBuild = ConstructAndCall<InplaceFunction<void(int), 48>>(count) / count;
+
+        int offset = 1;
+        auto lambda = [&offset](int value) { Consume(value + offset); };
+        std::function<void(int)> function(lambda);
+        InplaceFunction<void(int)> inplace(lambda);
+        FunctionRef<void(int)> reference(lambda);
+        const double functionCall = Call(function, count) / count;
+        const double inplaceCall = Call(inplace, count) / count;
+        const double referenceCall = Call(reference, count) / count;
+
+        std::cout << "Handler construct+call: std::function " << functionBuild << " ns, InplaceFunction "
+            << inplaceBuild << " ns; call: std::function " << functionCall << " ns, InplaceFunction "
+            << inplaceCall << " ns, FunctionRef " << referenceCall << " ns\n";
+    }
+
+    /**
+     * ̲߳ʱ ThreadSafeEventNormal ķٶȣ/룩
+     * ÿִ߳ͬʱʼԷ fireCount Σ̵ܷ߳ĺʱ
+     * @param fireCount ÿ̵߳ķ
+     * @param maxThreads 󷢲߳0 ʾʹӲ߳1ʼη
+     */
+    inline void RunEventFireBenchmark(size_t fireCount = 2000000, size_t maxThreads = 0) {
+        if (maxThreads == 0) maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+        for (size_t handlerCount : { 1, 2, 4, 8, 16 }) {
+            ThreadSafeEventNormal<int> event;
+            for (size_t i = 0; i < handlerCount; ++i) event += [](int value) { Detail::Consume(value); };
+
+            for (size_t threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+                const double seconds = EventMicrobenchmarks::Detail::RunConcurrently(threadCount,
+                    [&] { EventMicrobenchmarks::Detail::Call(event, fireCount); }) / 1e9;
+
+                const double fires = static_cast<double>(fireCount * threadCount);
+                std::cout << "Event fire: " << handlerCount << " handlers, " << threadCount << " threads, "
+                    << static_cast<uint64_t>(fires / seconds) << " fires/sec, "
+                    << seconds * 1e9 * threadCount / fires << " ns/fire per thread\n";
+            }
+        }
+    }
+}
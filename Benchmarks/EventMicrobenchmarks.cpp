@@ -0,0 +1,45 @@
+﻿// EventMicrobenchmarks.cpp : 事件分发微基准套件的入口，结果以 JSON 写到标准输出或指定文件
+// 用法：EventMicrobenchmarks [--iterations N] [--repetitions N] [--threads N] [--output 文件]
+//
+
+// 本翻译单元替换全局 operator new/delete 以统计分配次数，因此套件单独成为一个程序，不链接进服务端
+#define EVENT_MICROBENCHMARKS_COUNT_ALLOCATIONS
+#include "EventMicrobenchmarks.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+int main(int argc, char* argv[])
+{
+    EventMicrobenchmarks::Options options;
+    std::string output;
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (hasValue && std::strcmp(argv[i], "--iterations") == 0) options.iterations = std::stoull(argv[++i]);
+        else if (hasValue && std::strcmp(argv[i], "--repetitions") == 0) options.repetitions = std::stoull(argv[++i]);
+        else if (hasValue && std::strcmp(argv[i], "--threads") == 0) options.maxThreads = std::stoull(argv[++i]);
+        else if (hasValue && std::strcmp(argv[i], "--output") == 0) output = argv[++i];
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--iterations N] [--repetitions N] [--threads N] [--output file]\n";
+            return 1;
+        }
+    }
+    if (options.iterations == 0) {
+        std::cerr << "--iterations must be positive\n";
+        return 1;
+    }
+
+    if (output.empty()) {
+        EventMicrobenchmarks::RunAll(std::cout, options);
+        return 0;
+    }
+    std::ofstream file(output);
+    if (!file) {
+        std::cerr << "Cannot open " << output << "\n";
+        return 1;
+    }
+    EventMicrobenchmarks::RunAll(file, options);
+    return file ? 0 : 1;
+}
@@ -0,0 +1,465 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "../Utils/EventNormal.hpp"
+#include "../Utils/EventSubscribe.hpp"
+#include "../Utils/InplaceFunction.hpp"
+#include "../Utils/WorkStealingPool.hpp"
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/**
+ * ¼ַص΢׼׼ JSON ÿÿ¼ڴ
+ * ͨ滻ȫ operator new ͳƣҽһ뵥Ԫȶ
+ * EVENT_MICROBENCHMARKS_COUNT_ALLOCATIONS ٰļδʱ JSON зΪ null
+ * EventMicrobenchmarks.cppе EventMicrobenchmarks Ŀڣõ JSON 
+ */
+namespace EventMicrobenchmarks {
+    /**
+     * ׼ѡ
+     */
+    struct Options {
+        size_t iterations = 1000000; // ÿ̲߳¼ı첽ַ
+        size_t repetitions = 5;      // ÿظȡλСֵ
+        size_t maxThreads = 0;       // 첽ַ߳0 ʾʹӲ
+    };
+
+    namespace Detail {
+        /**
+         * ȫ operator new ĵôֻڶ EVENT_MICROBENCHMARKS_COUNT_ALLOCATIONS ʱ
+         */
+        inline std::atomic<uint64_t> Allocations{ 0 };
+
+        inline bool AllocationTracking() {
+#ifdef EVENT_MICROBENCHMARKS_COUNT_ALLOCATIONS
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        /**
+         * дֲֹ߳̾մŻ⴦֮û
+         */
+        inline thread_local int Sink = 0;
+
+        inline void Consume(int value) {
+            Sink += value;
+        }
+
+#ifdef _MSC_VER
+        inline const void* volatile EscapedObject = nullptr;
+#endif
+
+        /**
+         * ŻϣñΪ value ѱⲿȡд
+         * ܰѶĹ졢еĺָ򱻵õĿ۵ѭ
+         */
+        template<typename T>
+        inline void DoNotOptimize(T& value) {
+#ifdef _MSC_VER
+            EscapedObject = &value;
+            _ReadWriteBarrier();
+#else
+            asm volatile("" : "+m"(value) : : "memory");
+#endif
+        }
+
+        /**
+         * һĽ
+         */
+        struct Result {
+            std::string benchmark;                               // 
+            std::string subject;                                 // 
+            std::vector<std::pair<std::string, uint64_t>> params; // 紦߳
+            uint64_t iterations = 0;                             // ÿظ¼
+            double nsPerEvent = 0;                               // ظλ
+            double nsPerEventMin = 0;                            // ظСֵ
+            double allocationsPerEvent = 0;                      // ظƽ
+        };
+
+        /**
+         * ظִһ
+         * @param run ִ iterations ¼غʱĺ
+         */
+        template<typename Run>
+        Result Measure(std::string benchmark, std::string subject, std::vector<std::pair<std::string, uint64_t>> params,
+            size_t iterations, size_t repetitions, Run&& run) {
+            Result result{ std::move(benchmark), std::move(subject), std::move(params), iterations };
+            run(std::max<size_t>(iterations / 10, 1)); // Ԥ
+            std::vector<double> samples;
+            samples.reserve(std::max<size_t>(repetitions, 1)); // ķ
+            uint64_t allocations = 0;
+            for (size_t i = 0; i < std::max<size_t>(repetitions, 1); ++i) {
+                const uint64_t before = Allocations.load();
+                samples.push_back(run(iterations) / iterations);
+                allocations += Allocations.load() - before;
+            }
+            std::sort(samples.begin(), samples.end());
+            result.nsPerEvent = samples[samples.size() / 2];
+            result.nsPerEventMin = samples.front();
+            result.allocationsPerEvent = static_cast<double>(allocations) / (iterations * samples.size());
+            return result;
+        }
+
+        template<typename F>
+        double ElapsedNs(F&& function) {
+            const auto start = std::chrono::steady_clock::now();
+            function();
+            return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        /**
+         * 첢 iterations δ 4 ָС״̬ std::function СŻ
+         * 󾭹Żϣÿζ졢ָò
+         * @return ܺʱ
+         */
+        template<typename THandler>
+        double ConstructAndCall(size_t iterations) {
+            return ElapsedNs([&] {
+                for (size_t i = 0; i < iterations; ++i) {
+                    const intptr_t a = static_cast<intptr_t>(i), b = a + 1, c = a + 2, d = a + 3;
+                    THandler handler([a, b, c, d](int value) { Consume(value + static_cast<int>(a + b + c + d)); });
+                    DoNotOptimize(handler);
+                    handler(static_cast<int>(i));
+                }
+            });
+        }
+
+        /**
+         * ͬһ򷢲ͬһ¼ iterations ΣÿεǰŻϣ
+         * ͬ¼д洢Ĵ
+         * @return ܺʱ
+         */
+        template<typename TCallable>
+        double Call(TCallable& callable, size_t iterations) {
+            return ElapsedNs([&] {
+                for (size_t i = 0; i < iterations; ++i) {
+                    DoNotOptimize(callable);
+                    callable(static_cast<int>(i));
+                }
+            });
+        }
+
+        /**
+         *  threadCount ߳ͬʱִ body߳̾ٷУʱȫ߳̽
+         * @return ǽӺʱ
+         */
+        template<typename Body>
+        double RunConcurrently(size_t threadCount, Body&& body) {
+            std::atomic<size_t> ready{ 0 };
+            std::atomic<bool> start{ false };
+            std::vector<std::thread> threads;
+            for (size_t t = 0; t < threadCount; ++t) {
+                threads.emplace_back([&] {
+                    ready.fetch_add(1);
+                    while (!start.load()) std::this_thread::yield();
+                    body();
+                });
+            }
+            while (ready.load() != threadCount) std::this_thread::yield();
+            return ElapsedNs([&] {
+                start.store(true);
+                for (auto& thread : threads) thread.join();
+            });
+        }
+
+        /**
+         * ¼ĶȡĽӿڲͬͳһͬһʽ
+         */
+        template<typename THandler, typename TListener>
+        uint64_t Subscribe(BasicThreadSafeEventNormal<THandler, int>& event, TListener&& listener) {
+            return event += std::forward<TListener>(listener);
+        }
+
+        template<typename THandler>
+        void Unsubscribe(BasicThreadSafeEventNormal<THandler, int>& event, uint64_t id) {
+            event -= id;
+        }
+
+        template<typename THandler, typename TListener>
+        typename BasicSubscribeEvent<THandler, int>::Subscription Subscribe(BasicSubscribeEvent<THandler, int>& event,
+            TListener&& listener) {
+            return event.subscribe(std::forward<TListener>(listener));
+        }
+
+        template<typename THandler>
+        void Unsubscribe(BasicSubscribeEvent<THandler, int>& event,
+            const typename BasicSubscribeEvent<THandler, int>::Subscription& subscription) {
+            event.unsubscribe(subscription);
+        }
+
+        /**
+         * ̷߳η
+         */
+        template<typename TEvent>
+        void MeasureFire(std::vector<Result>& results, const char* subject, const Options& options) {
+            for (uint64_t handlerCount : { 0, 1, 2, 4, 8, 16, 32 }) {
+                TEvent event;
+                for (uint64_t i = 0; i < handlerCount; ++i) Subscribe(event, [](int value) { Consume(value); });
+                results.push_back(Measure("fire", subject, { { "handlers", handlerCount } }, options.iterations,
+                    options.repetitions, [&](size_t iterations) { return Call(event, iterations); }));
+            }
+        }
+
+        /**
+         * ߳ͬʱͬһ¼4ÿ̸߳ iterations Σ
+         * ÿ¼ΪǽʱԵ̵߳ķ߳̿ƽκʱ
+         */
+        template<typename TEvent>
+        void MeasureContention(std::vector<Result>& results, const char* subject, const Options& options, size_t maxThreads) {
+            TEvent event;
+            for (int i = 0; i < 4; ++i) Subscribe(event, [](int value) { Consume(value); });
+            for (uint64_t threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+                results.push_back(Measure("concurrent_fire", subject, { { "handlers", 4 }, { "threads", threadCount } },
+                    options.iterations, options.repetitions, [&](size_t iterations) {
+                        return RunConcurrently(threadCount, [&] { Call(event, iterations); });
+                    }));
+            }
+        }
+
+        /**
+         * ļȡһεĺʱдӣ
+         * Լһ̲߳ϵضıͬʱĵκʱķ̵߳ķ
+         */
+        template<typename TEvent>
+        void MeasureChurn(std::vector<Result>& results, const char* subject, const Options& options) {
+            for (uint64_t existing : { 0, 16, 256 }) {
+                TEvent event;
+                for (uint64_t i = 0; i < existing; ++i) Subscribe(event, [](int value) { Consume(value); });
+                results.push_back(Measure("subscribe_unsubscribe", subject, { { "existingHandlers", existing } },
+                    std::max<size_t>(options.iterations / 10, 1), options.repetitions, [&](size_t iterations) {
+                        return ElapsedNs([&] {
+                            for (size_t i = 0; i < iterations; ++i) {
+                                Unsubscribe(event, Subscribe(event, [](int value) { Consume(value); }));
+                            }
+                        });
+                    }));
+            }
+
+            TEvent event;
+            for (int i = 0; i < 4; ++i) Subscribe(event, [](int value) { Consume(value); });
+            results.push_back(Measure("fire_during_churn", subject, { { "handlers", 4 }, { "churnThreads", 1 } },
+                options.iterations, options.repetitions, [&](size_t iterations) {
+                    std::atomic<bool> done{ false };
+                    std::thread churn([&] {
+                        while (!done.load()) Unsubscribe(event, Subscribe(event, [](int value) { Consume(value); }));
+                    });
+                    const double elapsed = Call(event, iterations);
+                    done.store(true);
+                    churn.join();
+                    return elapsed;
+                }));
+        }
+
+        /**
+         * 洢ͣӵáãԼ֮Ϊ洢¼ķ
+         */
+        inline void MeasureCallables(std::vector<Result>& results, const Options& options) {
+            auto construct = [&](const char* subject, auto tag) {
+                typedef typename decltype(tag)::type THandler;
+                results.push_back(Measure("construct_and_call", subject, { { "captureBytes", 4 * sizeof(intptr_t) } },
+                    options.iterations, options.repetitions, [](size_t iterations) { return ConstructAndCall<THandler>(iterations); }));
+            };
+            construct("std::function", std::type_identity<std::function<void(int)>>());
+            construct("InplaceFunction", std::type_identity<InplaceFunction<void(int), 48>>());
+
+            int offset = 1;
+            auto lambda = [&offset](int value) { Consume(value + offset); };
+            auto call = [&](const char* subject, auto& handler) {
+                results.push_back(Measure("call", subject, {}, options.iterations, options.repetitions,
+                    [&](size_t iterations) { return Call(handler, iterations); }));
+            };
+            std::function<void(int)> function(lambda);
+            InplaceFunction<void(int)> inplace(lambda);
+            FunctionRef<void(int)> reference(lambda);
+            call("std::function", function);
+            call("InplaceFunction", inplace);
+            call("FunctionRef", reference);
+
+            auto fire = [&](const char* subject, auto& event) {
+                for (int i = 0; i < 4; ++i) event += [&offset](int value) { Consume(value + offset); };
+                results.push_back(Measure("fire_by_storage", subject, { { "handlers", 4 } }, options.iterations,
+                    options.repetitions, [&](size_t iterations) { return Call(event, iterations); }));
+            };
+            ThreadSafeEventNormal<int> functionEvent;
+            BasicThreadSafeEventNormal<InplaceFunction<void(int)>, int> inplaceEvent;
+            fire("ThreadSafeEventNormal<std::function>", functionEvent);
+            fire("ThreadSafeEventNormal<InplaceFunction>", inplaceEvent);
+        }
+
+        /**
+         *  WorkStealingPool 첽ַӷһ¼дִϣ¼ƽ
+         */
+        inline void MeasureAsync(std::vector<Result>& results, const Options& options, size_t maxThreads) {
+            const size_t iterations = std::max<size_t>(options.iterations / 10, 1);
+            for (uint64_t threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+                WorkStealingPool pool(threadCount);
+                for (uint64_t handlerCount : { 1, 4, 16 }) {
+                    std::atomic<size_t> remaining{ 0 };
+                    ThreadSafeEventNormal<int> event;
+                    for (uint64_t i = 0; i < handlerCount; ++i) {
+                        event += [&remaining](int value) {
+                            Consume(value);
+                            remaining.fetch_sub(1);
+                        };
+                    }
+                    results.push_back(Measure("async_fire", "ThreadSafeEventNormal+WorkStealingPool",
+                        { { "handlers", handlerCount }, { "threads", threadCount } }, iterations, options.repetitions,
+                        [&](size_t count) {
+                            remaining.store(count * handlerCount);
+                            return ElapsedNs([&] {
+                                for (size_t i = 0; i < count; ++i) event.Async(pool, static_cast<int>(i));
+                                while (remaining.load() != 0) std::this_thread::yield();
+                            });
+                        }));
+                }
+            }
+        }
+
+        inline void WriteString(std::ostream& out, const std::string& value) {
+            out << '"';
+            for (char c : value) {
+                if (c == '"' || c == '\\') out << '\\' << c;
+                else if (static_cast<unsigned char>(c) < 0x20) out << ' ';
+                else out << c;
+            }
+            out << '"';
+        }
+    }
+
+    /**
+     * ׼ѽ JSON д
+     *  {"suite": ..., "hardwareThreads": n, "allocationTracking": bool, "results": [...]}
+     * ÿ benchmarksubjectparamsiterationsnsPerEventλnsPerEventMin  allocationsPerEvent
+     * @param out 
+     * @param options ׼ѡ
+     */
+    inline void RunAll(std::ostream& out, const Options& options = Options()) {
+        const size_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+        const size_t maxThreads = options.maxThreads == 0 ? hardwareThreads : options.maxThreads;
+
+        std::vector<Detail::Result> results;
+        Detail::MeasureFire<ThreadSafeEventNormal<int>>(results, "ThreadSafeEventNormal", options);
+        Detail::MeasureFire<SubscribeEvent<int>>(results, "SubscribeEvent", options);
+        Detail::MeasureContention<ThreadSafeEventNormal<int>>(results, "ThreadSafeEventNormal", options, maxThreads);
+        Detail::MeasureContention<SubscribeEvent<int>>(results, "SubscribeEvent", options, maxThreads);
+        Detail::MeasureChurn<ThreadSafeEventNormal<int>>(results, "ThreadSafeEventNormal", options);
+        Detail::MeasureChurn<SubscribeEvent<int>>(results, "SubscribeEvent", options);
+        Detail::MeasureCallables(results, options);
+        Detail::MeasureAsync(results, options, maxThreads);
+
+        out << "{\n  \"suite\": \"event-dispatch\",\n  \"hardwareThreads\": " << hardwareThreads
+            << ",\n  \"allocationTracking\": " << (Detail::AllocationTracking() ? "true" : "false")
+            << ",\n  \"repetitions\": " << options.repetitions << ",\n  \"results\": [";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Detail::Result& result = results[i];
+            out << (i == 0 ? "\n" : ",\n") << "    {\"benchmark\": ";
+            Detail::WriteString(out, result.benchmark);
+            out << ", \"subject\": ";
+            Detail::WriteString(out, result.subject);
+            out << ", \"params\": {";
+            for (size_t p = 0; p < result.params.size(); ++p) {
+                if (p != 0) out << ", ";
+                Detail::WriteString(out, result.params[p].first);
+                out << ": " << result.params[p].second;
+            }
+            out << "}, \"iterations\": " << result.iterations << ", \"nsPerEvent\": " << result.nsPerEvent
+                << ", \"nsPerEventMin\": " << result.nsPerEventMin << ", \"allocationsPerEvent\": ";
+            if (Detail::AllocationTracking()) out << result.allocationsPerEvent;
+            else out << "null";
+            out << "}";
+        }
+        out << "\n  ]\n}\n";
+    }
+}
+
+#ifdef EVENT_MICROBENCHMARKS_COUNT_ALLOCATIONS
+// 滻ȫַ亯ͳƷֻһ뵥Ԫж
+#if defined(__GNUC__) && !defined(__clang__)
+// 滻 operator new/delete ÷ʱGCC  malloc/free Ϊ new/delete 
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void* operator new(std::size_t size) {
+    EventMicrobenchmarks::Detail::Allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* pointer = std::malloc(size == 0 ? 1 : size)) return pointer;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    EventMicrobenchmarks::Detail::Allocations.fetch_add(1, std::memory_order_relaxed);
+    const size_t align = static_cast<size_t>(alignment);
+#ifdef _WIN32
+    if (void* pointer = _aligned_malloc(size == 0 ? 1 : size, align)) return pointer;
+#else
+    if (void* pointer = std::aligned_alloc(align, (std::max<size_t>(size, 1) + align - 1) / align * align)) return pointer;
+#endif
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return ::operator new(size, alignment);
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept {
+#ifdef _WIN32
+    _aligned_free(pointer);
+#else
+    std::free(pointer);
+#endif
+}
+
+void operator delete[](void* pointer, std::align_val_t alignment) noexcept {
+    ::operator delete(pointer, alignment);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t alignment) noexcept {
+    ::operator delete(pointer, alignment);
+}
+
+void operator delete[](void* pointer, std::size_t, std::align_val_t alignment) noexcept {
+    ::operator delete(pointer, alignment);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../Utils/StateMachine.hpp"
+
+/**
+ * ״̬ܻ׼
+ * ÿвѽӡ׼ main а
+ */
+namespace StateMachineBenchmarks {
+    /**
+     * Ԥд־طٶȣת/룩
+     * ֱ TransitionLog ־ļڿ״̬ϼʱط
+     * @param keyCount 
+     * @param transitionCount ־еת¼
+     * @param path ʱ־ļ·Խɾ
+     */
+    inline void RunWalReplayBenchmark(size_t keyCount = 100000, size_t transitionCount = 5000000,
+        const std::string& path = "wal_replay_benchmark.log") {
+        using Clock = std::chrono::steady_clock;
+        std::remove(path.c_str());
+
+        const std::string states[] = { "Idle", "Processing", "Completed" };
+        const auto base = std::chrono::system_clock::now().time_since_epoch().count();
+        {
+            TransitionLogOptions options;
+            options.maxCommitLatency = std::chrono::microseconds(0);
+            TransitionLog<std::string, std::string> log(path, options);
+            for (size_t i = 0; i < transitionCount; ++i) {
+                const size_t key = i % keyCount;
+                const size_t round = i / keyCount;
+                log.Append("order-" + std::to_string(key), states[round % 3], states[(round + 1) % 3],
+                    base + static_cast<int64_t>(i), static_cast<uint32_t>(round % 3), "benchmark");
+            }
+            log.Flush();
+        }
+
+        StateMachine<std::string, std::string> stateMachine;
+        const auto start = Clock::now();
+        const size_t applied = stateMachine.ReplayWal(path);
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        std::remove(path.c_str());
+
+        std::cout << "WAL replay: " << applied << " transitions over " << keyCount << " keys in "
+            << seconds << " s, " << static_cast<uint64_t>(applied / seconds) << " transitions/sec\n";
+    }
+
+    /**
+     * ޶תĵκʱ룩·գļ·Ա
+     * ·ֿ
+     * ÷ʱÿתӳٻһ룬ȲдҲỽſ̣߳䲹ǲʱ
+     * Ǻʱ䲹ǵĺʱתƽ
+     * ˵ˡתдʱвǼſ̵߳Ŀ
+     * @param keyCount 
+     * @param transitionCount ÿ·ִеת
+     */
+    inline void RunFastTransitionBenchmark(size_t keyCount = 100000, size_t transitionCount = 5000000) {
+        using Clock = std::chrono::steady_clock;
+        StateMachine<uint64_t, uint32_t> stateMachine;
+        stateMachine.AddTransition(0, 1);
+        stateMachine.AddTransition(1, 0);
+        for (uint64_t key = 0; key < keyCount; ++key) stateMachine.InitializeState(key, 0);
+
+        // ÿֱмһΣִμ״̬л֤ÿתϷ
+        auto run = [&](auto&& transition) {
+            const auto start = Clock::now();
+            for (size_t i = 0; i < transitionCount; ++i) {
+                transition(static_cast<uint64_t>(i % keyCount), static_cast<uint32_t>((i / keyCount + 1) % 2));
+            }
+            return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / transitionCount;
+        };
+        // ӳٻΪ 1024Żſ߳
+        constexpr size_t BatchSize = 256;
+        double callerNs = 0, drainNs = 0;
+        for (size_t begin = 0; begin < transitionCount; begin += BatchSize) {
+            const size_t end = std::min(begin + BatchSize, transitionCount);
+            const auto start = Clock::now();
+            for (size_t i = begin; i < end; ++i) {
+                stateMachine.Transition(static_cast<uint64_t>(i % keyCount), static_cast<uint32_t>((i / keyCount + 1) % 2));
+            }
+            const auto stop = Clock::now();
+            stateMachine.FlushDeferredTransitions();
+            callerNs += std::chrono::duration<double, std::nano>(stop - start).count();
+            drainNs += std::chrono::duration<double, std::nano>(Clock::now() - stop).count();
+        }
+        // һֽʱ transitionCount ת֮״̬˵˲һֿʼ
+        const size_t rounds = transitionCount / keyCount;
+        const double fast = run([&](uint64_t key, uint32_t state) {
+            stateMachine.Transition(key, static_cast<uint32_t>(state ^ (rounds % 2)));
+        });
+        stateMachine.FlushDeferredTransitions();
+        const double locked = run([&](uint64_t key, uint32_t state) {
+            stateMachine.Transition(key, state, [](auto&&...) {});
+        });
+
+        std::cout << "No-action transition over " << keyCount << " keys: fast path caller "
+            << callerNs / transitionCount << " ns + deferred drain " << drainNs / transitionCount
+            << " ns, fast path end to end " << fast << " ns, locked path " << locked << " ns\n";
+    }
+
+    /**
+     * ٶȣ/룩ݵ BulkLoad  InitializeState Ա
+     * ַʽһµ״̬ͬһֻʱ״̬
+     * @param keyCount 
+     * @param threadCount ߳0 ʾʹӲ
+     */
+    inline void RunBulkLoadBenchmark(size_t keyCount = 10000000, size_t threadCount = 0) {
+        using Clock = std::chrono::steady_clock;
+        using Machine = StateMachine<uint64_t, uint32_t>;
+        std::vector<uint64_t> keys(keyCount);
+        std::vector<uint32_t> states(keyCount);
+        for (size_t i = 0; i < keyCount; ++i) {
+            keys[i] = i;
+            states[i] = static_cast<uint32_t>(i % 4);
+        }
+
+        double bulk;
+        {
+            Machine stateMachine;
+            Machine::BulkLoadColumns columns;
+            columns.keys = keys.data();
+            columns.states = states.data();
+            columns.count = keyCount;
+            const auto start = Clock::now();
+            stateMachine.BulkLoad(columns, threadCount);
+            bulk = std::chrono::duration<double>(Clock::now() - start).count();
+        }
+        double single;
+        {
+            Machine stateMachine;
+            const auto start = Clock::now();
+            for (size_t i = 0; i < keyCount; ++i) stateMachine.InitializeState(keys[i], states[i]);
+            single = std::chrono::duration<double>(Clock::now() - start).count();
+        }
+
+        std::cout << "Load " << keyCount << " keys: BulkLoad " << bulk << " s ("
+            << static_cast<uint64_t>(keyCount / bulk) << " keys/sec), InitializeState " << single << " s ("
+            << static_cast<uint64_t>(keyCount / single) << " keys/sec)\n";
+    }
+
+    /**
+     * ʷ鵵дɨٶȣд󰴱߻ȫתطŵʷ
+     * ÿ 24 ֽڣʱĸţδС
+     * @param keyCount 
+     * @param transitionCount дת
+     * @param path ʱ鵵ļ·Խɾ
+     */
+    inline void RunHistoryArchiveBenchmark(size_t keyCount = 100000, size_t transitionCount = 20000000,
+        const std::string& path = "history_archive_benchmark.bin") {
+        using Clock = std::chrono::steady_clock;
+        std::remove(path.c_str());
+
+        const std::string states[] = { "Idle", "Processing", "Completed" };
+        const std::string reasons[] = { "scheduled", "manual" };
+        const auto base = std::chrono::system_clock::now().time_since_epoch().count();
+        double writeSeconds;
+        {
+            std::vector<std::string> keys(keyCount);
+            for (size_t i = 0; i < keyCount; ++i) keys[i] = "order-" + std::to_string(i);
+            const auto start = Clock::now();
+            HistoryArchiveWriter<std::string, std::string> writer(path);
+            for (size_t i = 0; i < transitionCount; ++i) {
+                const size_t round = i / keyCount;
+                writer.Append(keys[i % keyCount], states[round % 3], states[(round + 1) % 3],
+                    base + static_cast<int64_t>(i) * 1000, reasons[i % 2]);
+            }
+            writer.Flush();
+            writeSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+        }
+        const auto fileSize = std::filesystem::file_size(path);
+
+        double scanSeconds, keySeconds;
+        size_t keyRows = 0;
+        {
+            HistoryArchiveReader<std::string, std::string> reader(path);
+            auto start = Clock::now();
+            const auto edges = reader.CountEdges();
+            scanSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+            start = Clock::now();
+            keyRows = reader.ScanKey("order-42", [](int64_t, const std::string&, const std::string&, const std::string&) {});
+            keySeconds = std::chrono::duration<double>(Clock::now() - start).count();
+        }
+        std::remove(path.c_str());
+
+        const double rawBytes = 24.0 * transitionCount;
+        std::cout << "History archive: " << transitionCount << " transitions, " << fileSize << " bytes ("
+            << static_cast<double>(fileSize) / transitionCount << " bytes/transition), write "
+            << static_cast<uint64_t>(transitionCount / writeSeconds) << " transitions/sec, CountEdges "
+            << rawBytes / scanSeconds / 1e9 << " GB/s, ScanKey " << keyRows << " rows in " << keySeconds << " s\n";
+    }
+}
@@ -86,9 +86,17 @@ int statetest() {
         std::this_thread::sleep_for(std::chrono::seconds(2));
         };
 
-    // 从 Idle 转换到 Processing
-    bool success = stateMachine.Transition(
-        key, "Processing", processingAction, "User requested processing");
+    // 定义异步状态转换动作（等待期间挂起协程，不占用线程）
+    auto asyncProcessingAction = [](const Key& k, const State& from, const State& to) -> Task<void> {
+        std::cout << "Performing async action for transition: " << from << " -> " << to
+            << " (Key: " << k << ")" << std::endl;
+        // 模拟异步 I/O
+        co_await TaskUtils::Delay(std::chrono::seconds(2));
+        };
+
+    // 从 Idle 转换到 Processing（异步动作）
+    bool success = TaskUtils::SyncWait(stateMachine.TransitionAsync(
+        key, "Processing", asyncProcessingAction, "User requested processing"));
 
     if (success) {
         std::cout << "Successfully transitioned to Processing state" << std::endl;
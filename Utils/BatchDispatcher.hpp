@@ -0,0 +1,379 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "EventSubscribe.hpp"
+
+class BatchDispatcher;
+
+/**
+ *  BatchDispatcher ֹʱˢ¼ͨ
+ * ͨڵһͶ¼ʱýֹʱ䲢ѵ̣֮߳ͬһڵ¼ֻͨۻ
+ */
+class DispatchChannel {
+    friend class BatchDispatcher;
+
+public:
+    DispatchChannel(const DispatchChannel&) = delete;
+    DispatchChannel& operator=(const DispatchChannel&) = delete;
+
+    /**
+     * ڵǰ߳ͶݴͶݵ¼̵߳Ͷݻ⣬Ͷ˳
+     */
+    virtual void Flush() = 0;
+
+protected:
+    static constexpr int64_t NoDeadline = std::numeric_limits<int64_t>::max();
+
+    explicit DispatchChannel(BatchDispatcher& dispatcher) : _dispatcher(dispatcher) {}
+    virtual ~DispatchChannel() = default;
+
+    static int64_t Now() {
+        return std::chrono::steady_clock::now().time_since_epoch().count();
+    }
+
+    /**
+     * ýֹʱ䲢ѵ̣߳ͨ
+     * @param deadline steady_clock 0 ʾͶ
+     */
+    inline void ArmLocked(int64_t deadline);
+
+    /**
+     * ֹʱ䣬ͨ
+     */
+    void DisarmLocked() {
+        _deadline.store(NoDeadline, std::memory_order_relaxed);
+    }
+
+    BatchDispatcher& _dispatcher;                        // 
+    std::atomic<int64_t> _deadline{ NoDeadline };        // һͶݵĽֹʱ
+    std::atomic<uint64_t> _publishCount{ 0 };            // ¼
+    std::atomic<uint64_t> _deliveryCount{ 0 };           // Ͷݵ
+};
+
+/**
+ * ϲͶݵĵһ̨̰߳ͨĽֹʱͶ¼
+ * ͬһͨĴڵ̣߳ Flush ̣߳ϴִУ
+ * пκͨ¼ܴͨ
+ * ͨڵ٣ʱͶԵǼǵͨдͶݵ¼
+ */
+class BatchDispatcher {
+    friend class DispatchChannel;
+
+public:
+    BatchDispatcher() {
+        _thread = std::thread(&BatchDispatcher::Run, this);
+    }
+
+    BatchDispatcher(const BatchDispatcher&) = delete;
+    BatchDispatcher& operator=(const BatchDispatcher&) = delete;
+
+    ~BatchDispatcher() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _wake.notify_one();
+        _thread.join();
+    }
+
+    /**
+     * Ǽͨͨʱ
+     */
+    void Register(DispatchChannel* channel) {
+        std::lock_guard<std::mutex> flushLock(_flushMutex);
+        std::lock_guard<std::mutex> lock(_mutex);
+        _channels.push_back(channel);
+    }
+
+    /**
+     * עͨͨʱãغ̲߳ٷʸͨ
+     */
+    void Unregister(DispatchChannel* channel) {
+        std::lock_guard<std::mutex> flushLock(_flushMutex);
+        std::lock_guard<std::mutex> lock(_mutex);
+        _channels.erase(std::remove(_channels.begin(), _channels.end(), channel), _channels.end());
+    }
+
+private:
+    /**
+     * ͨµĽֹʱ䣬ѵ߳¼ȴʱ
+     */
+    void Wake() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            ++_wakeSignal;
+        }
+        _wake.notify_one();
+    }
+
+    void Run() {
+        std::vector<DispatchChannel*> due;
+        std::unique_lock<std::mutex> lock(_mutex);
+        for (;;) {
+            const int64_t now = DispatchChannel::Now();
+            int64_t earliest = DispatchChannel::NoDeadline;
+            due.clear();
+            for (DispatchChannel* channel : _channels) {
+                const int64_t deadline = channel->_deadline.load(std::memory_order_relaxed);
+                if (deadline <= now || _stopping) due.push_back(channel);
+                else earliest = std::min(earliest, deadline);
+            }
+            if (!due.empty()) {
+                // Ͷڼ䲻 _mutex¼ʱԻѵ̣߳
+                // _flushMutex ֤Ͷڼͨע
+                lock.unlock();
+                {
+                    std::lock_guard<std::mutex> flushLock(_flushMutex);
+                    for (DispatchChannel* channel : due) {
+                        if (std::find(_channels.begin(), _channels.end(), channel) == _channels.end()) continue;
+                        if (channel->_deadline.load(std::memory_order_relaxed) != DispatchChannel::NoDeadline) {
+                            channel->Flush();
+                        }
+                    }
+                }
+                lock.lock();
+                if (_stopping) return;
+                continue;
+            }
+            if (_stopping) return;
+
+            const uint64_t signal = _wakeSignal;
+            auto woken = [&] { return _wakeSignal != signal || _stopping; };
+            if (earliest == DispatchChannel::NoDeadline) {
+                _wake.wait(lock, woken);
+            }
+            else {
+                const auto deadline = std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(earliest));
+                _wake.wait_until(lock, deadline, woken);
+            }
+        }
+    }
+
+    std::vector<DispatchChannel*> _channels; // Ǽǵͨ _mutex ޸ʱ _flushMutex
+    std::mutex _mutex;                       // ͨб뻽Ѽ
+    std::mutex _flushMutex;                  // ߳ͶڼУֹͨע
+    std::condition_variable _wake;           // ߳ڴ˵ȴĽֹʱ
+    uint64_t _wakeSignal = 0;                // Ѽ _mutex 
+    bool _stopping = false;                  // ֹͣ־ _mutex 
+    std::thread _thread;                     // ߳
+};
+
+inline void DispatchChannel::ArmLocked(int64_t deadline) {
+    if (deadline >= _deadline.load(std::memory_order_relaxed)) return;
+    _deadline.store(deadline, std::memory_order_relaxed);
+    _dispatcher.Wake();
+}
+
+/**
+ * ֵϲ¼ͬһʱ䴰ڶͬһĶηֻһΣ
+ * ڽʱѴڱ仯ļ״α仯˳һνߡ
+ * ڴϴͶݺĵһηʼʱʺñ״̬յֵֻ¼
+ * @tparam TKey ͣɹϣ
+ * @tparam TValue ֵ
+ */
+template<typename TKey, typename TValue>
+class CoalescingEvent : public DispatchChannel {
+public:
+    typedef std::pair<TKey, TValue> Entry;
+    typedef BasicSubscribeEvent<std::function<void(std::span<const Entry>)>, std::span<const Entry>> Subscribers;
+
+    /**
+     * @param dispatcher ¼
+     * @param window ϲ
+     */
+    CoalescingEvent(BatchDispatcher& dispatcher, std::chrono::microseconds window)
+        : DispatchChannel(dispatcher), _window(std::chrono::duration_cast<std::chrono::steady_clock::duration>(window).count()) {
+        _dispatcher.Register(this);
+    }
+
+    /**
+     * עͨδͶݵ¼Ҫʱȵ Flush
+     */
+    ~CoalescingEvent() override {
+        _dispatcher.Unregister(this);
+    }
+
+    /**
+     * ĺϲı
+     * @param handler  void(std::span<const std::pair<TKey, TValue>>) Ĵ
+     * @return ľ
+     */
+    typename Subscribers::Subscription Subscribe(std::function<void(std::span<const Entry>)> handler) {
+        return _subscribers.subscribe(std::move(handler));
+    }
+
+    /**
+     * ȡ
+     */
+    bool Unsubscribe(const typename Subscribers::Subscription& subscription) {
+        return _subscribers.unsubscribe(subscription);
+    }
+
+    /**
+     * һֵͬһڸüľֵ
+     */
+    void Publish(const TKey& key, TValue value) {
+        _publishCount.fetch_add(1, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _positions.find(key);
+        if (it != _positions.end()) {
+            _pending[it->second].second = std::move(value);
+            return;
+        }
+        _positions.emplace(key, _pending.size());
+        _pending.emplace_back(key, std::move(value));
+        if (_pending.size() == 1) ArmLocked(Now() + _window);
+    }
+
+    void Flush() override {
+        std::lock_guard<std::mutex> deliverLock(_deliverMutex);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            DisarmLocked();
+            if (_pending.empty()) return;
+            _delivering.clear();
+            _delivering.swap(_pending);
+            _positions.clear();
+        }
+        _deliveryCount.fetch_add(1, std::memory_order_relaxed);
+        _subscribers(std::span<const Entry>(_delivering));
+    }
+
+    /**
+     * ȡ
+     */
+    uint64_t PublishCount() const {
+        return _publishCount.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * ȡͶÿÿһΣ
+     */
+    uint64_t DeliveryCount() const {
+        return _deliveryCount.load(std::memory_order_relaxed);
+    }
+
+private:
+    const int64_t _window;                        // ϲڣsteady_clock 
+    Subscribers _subscribers;                     // 
+    std::mutex _mutex;                            // Ͷݵı
+    std::mutex _deliverMutex;                     // лͶ
+    std::vector<Entry> _pending;                  // Ͷݵı״α仯˳
+    std::unordered_map<TKey, size_t> _positions;  // ڴͶݱеλ
+    std::vector<Entry> _delivering;               // Ͷݵı _pending ڴ
+};
+
+/**
+ * Ͷݵ¼ۻ maxBatch һ¼ȴ maxDelay ʱ¼һν
+ * @tparam T ¼
+ */
+template<typename T>
+class BatchingEvent : public DispatchChannel {
+public:
+    typedef BasicSubscribeEvent<std::function<void(std::span<const T>)>, std::span<const T>> Subscribers;
+
+    /**
+     * @param dispatcher ¼
+     * @param maxBatch ÿ¼ﵽͶ
+     * @param maxDelay һ¼ĵȴʱ
+     */
+    BatchingEvent(BatchDispatcher& dispatcher, size_t maxBatch, std::chrono::microseconds maxDelay)
+        : DispatchChannel(dispatcher), _maxBatch(std::max<size_t>(maxBatch, 1)),
+        _maxDelay(std::chrono::duration_cast<std::chrono::steady_clock::duration>(maxDelay).count()) {
+        _pending.reserve(_maxBatch);
+        _dispatcher.Register(this);
+    }
+
+    /**
+     * עͨδͶݵ¼Ҫʱȵ Flush
+     */
+    ~BatchingEvent() override {
+        _dispatcher.Unregister(this);
+    }
+
+    /**
+     * ĳ¼
+     * @param handler  void(std::span<const T>) Ĵ
+     * @return ľ
+     */
+    typename Subscribers::Subscription Subscribe(std::function<void(std::span<const T>)> handler) {
+        return _subscribers.subscribe(std::move(handler));
+    }
+
+    /**
+     * ȡ
+     */
+    bool Unsubscribe(const typename Subscribers::Subscription& subscription) {
+        return _subscribers.unsubscribe(subscription);
+    }
+
+    /**
+     * һ¼
+     */
+    void Publish(T event) {
+        _publishCount.fetch_add(1, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(_mutex);
+        _pending.push_back(std::move(event));
+        if (_pending.size() >= _maxBatch) ArmLocked(0);
+        else if (_pending.size() == 1) ArmLocked(Now() + _maxDelay);
+    }
+
+    /**
+     * Ͷۻ¼ÿͶ maxBatch ʣһ
+     */
+    void Flush() override {
+        std::lock_guard<std::mutex> deliverLock(_deliverMutex);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            DisarmLocked();
+            if (_pending.empty()) return;
+            _delivering.clear();
+            if (_pending.size() <= _maxBatch) {
+                _delivering.swap(_pending);
+            }
+            else {
+                _delivering.assign(std::make_move_iterator(_pending.begin()),
+                    std::make_move_iterator(_pending.begin() + _maxBatch));
+                _pending.erase(_pending.begin(), _pending.begin() + _maxBatch);
+            }
+            if (!_pending.empty()) ArmLocked(_pending.size() >= _maxBatch ? 0 : Now() + _maxDelay);
+        }
+        _deliveryCount.fetch_add(1, std::memory_order_relaxed);
+        _subscribers(std::span<const T>(_delivering));
+    }
+
+    /**
+     * ȡ
+     */
+    uint64_t PublishCount() const {
+        return _publishCount.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * ȡͶÿÿһΣ
+     */
+    uint64_t DeliveryCount() const {
+        return _deliveryCount.load(std::memory_order_relaxed);
+    }
+
+private:
+    const size_t _maxBatch;     // ÿ¼
+    const int64_t _maxDelay;    // һ¼ĵȴʱ䣨steady_clock 
+    Subscribers _subscribers;   // 
+    std::mutex _mutex;          // Ͷݵ¼
+    std::mutex _deliverMutex;   // лͶ
+    std::vector<T> _pending;    // Ͷݵ¼
+    std::vector<T> _delivering; // Ͷݵ¼ _pending ڴ
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+/**
+ * նƱڿա־ȳ־ûʽ
+ * ƽƵͰԭʼֽд룻Ҫṩػ
+ * @tparam T 
+ */
+template<typename T, typename Enable = void>
+struct BinaryCodec {
+    static_assert(std::is_trivially_copyable<T>::value,
+        "BinaryCodec must be specialized for non trivially copyable types");
+
+    /**
+     * ֵ׷д뻺
+     * @param out 
+     * @param value ֵ
+     */
+    static void Write(std::string& out, const T& value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    /**
+     * ӻȡһֵ
+     * @param p ȡλãɹǰ
+     * @param end ĩβ
+     * @param value ڴ洢
+     * @return Ƿ
+     */
+    static bool Read(const char*& p, const char* end, T& value) {
+        if (static_cast<size_t>(end - p) < sizeof(T)) return false;
+        std::memcpy(&value, p, sizeof(T));
+        p += sizeof(T);
+        return true;
+    }
+};
+
+/**
+ * std::string ػ32λǰ׺ + ԭʼֽ
+ */
+template<>
+struct BinaryCodec<std::string> {
+    static void Write(std::string& out, const std::string& value) {
+        const uint32_t length = static_cast<uint32_t>(value.size());
+        out.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        out.append(value);
+    }
+
+    static bool Read(const char*& p, const char* end, std::string& value) {
+        uint32_t length;
+        if (!BinaryCodec<uint32_t>::Read(p, end, length)) return false;
+        if (static_cast<size_t>(end - p) < length) return false;
+        value.assign(p, length);
+        p += length;
+        return true;
+    }
+};
+
+namespace BinaryCodecUtils {
+    /**
+     * ȡһֵݲʱ׳쳣
+     * @param p ȡλãɹǰ
+     * @param end ĩβ
+     * @param what ʱ쳣ϢеԴ
+     * @return ȡֵ
+     */
+    template<typename T>
+    inline T ReadOrThrow(const char*& p, const char* end, const char* what) {
+        T value{};
+        if (!BinaryCodec<T>::Read(p, end, value)) {
+            throw std::runtime_error(std::string("Truncated data in ") + what);
+        }
+        return value;
+    }
+}
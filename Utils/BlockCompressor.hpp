@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * ѹٶȵ LZ77 ѹʽ LZ4 Ŀʽͬ
+ * ÿΪ [ֽ][չ][][u16 ƥƫ][չƥ䳤]
+ * ֽڸ4λΪȡ4λΪƥ䳤ȼ4ȡֵ15ʱֽڣÿֽۼӣ255 ʾ
+ * һֻѹõ·ϣƥ䣬׷ѹʣѹֻпͱ߽
+ */
+namespace BlockCompressor {
+    constexpr size_t MinMatch = 4;
+    constexpr size_t MaxOffset = 65535;
+    constexpr size_t HashBits = 14;
+    constexpr size_t TailLiterals = 8; // ĩβôֻֽ
+
+    namespace Detail {
+        inline uint32_t Read32(const uint8_t* p) {
+            uint32_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        inline uint32_t Hash(uint32_t sequence) {
+            return (sequence * 2654435761u) >> (32 - HashBits);
+        }
+
+        inline void PutLength(std::string& out, size_t length) {
+            while (length >= 255) {
+                out.push_back(static_cast<char>(255));
+                length -= 255;
+            }
+            out.push_back(static_cast<char>(length));
+        }
+
+        inline bool GetLength(const uint8_t*& p, const uint8_t* end, size_t& length) {
+            uint8_t byte;
+            do {
+                if (p == end) return false;
+                byte = *p++;
+                length += byte;
+            } while (byte == 255);
+            return true;
+        }
+
+        inline void PutSequence(std::string& out, const uint8_t* literals, size_t literalCount,
+            size_t offset, size_t matchLength) {
+            const size_t matchCode = matchLength ? matchLength - MinMatch : 0;
+            const uint8_t token = static_cast<uint8_t>(((literalCount < 15 ? literalCount : 15) << 4)
+                | (matchCode < 15 ? matchCode : 15));
+            out.push_back(static_cast<char>(token));
+            if (literalCount >= 15) PutLength(out, literalCount - 15);
+            out.append(reinterpret_cast<const char*>(literals), literalCount);
+            if (!matchLength) return;
+            out.push_back(static_cast<char>(offset & 0xFF));
+            out.push_back(static_cast<char>(offset >> 8));
+            if (matchCode >= 15) PutLength(out, matchCode - 15);
+        }
+    }
+
+    /**
+     * ѹһ
+     * @param data ԭʼ
+     * @param size ԭʼֽ
+     * @param out ѹ׷ĩβ
+     */
+    inline void Compress(const char* data, size_t size, std::string& out) {
+        using namespace Detail;
+        const uint8_t* input = reinterpret_cast<const uint8_t*>(data);
+        const uint8_t* anchor = input;
+        if (size > TailLiterals + MinMatch) {
+            std::vector<uint32_t> table(size_t(1) << HashBits, UINT32_MAX);
+            const uint8_t* limit = input + size - TailLiterals - MinMatch;
+            const uint8_t* p = input;
+            while (p < limit) {
+                const uint32_t sequence = Read32(p);
+                uint32_t& bucket = table[Hash(sequence)];
+                const uint32_t candidate = bucket;
+                bucket = static_cast<uint32_t>(p - input);
+                if (candidate == UINT32_MAX || static_cast<size_t>(p - input) - candidate > MaxOffset
+                    || Read32(input + candidate) != sequence) {
+                    ++p;
+                    continue;
+                }
+                const uint8_t* match = input + candidate;
+                size_t length = MinMatch;
+                const uint8_t* matchEnd = input + size - TailLiterals;
+                while (p + length < matchEnd && p[length] == match[length]) ++length;
+                PutSequence(out, anchor, static_cast<size_t>(p - anchor), static_cast<size_t>(p - match), length);
+                p += length;
+                anchor = p;
+            }
+        }
+        PutSequence(out, anchor, static_cast<size_t>(input + size - anchor), 0, 0);
+    }
+
+    /**
+     * ѹһ
+     * @param data ѹ
+     * @param size ѹֽ
+     * @param out λã rawSize ֽ
+     * @param rawSize ԭʼֽ
+     * @return ǷҽѹǡΪ rawSize ֽ
+     */
+    inline bool Decompress(const char* data, size_t size, char* out, size_t rawSize) {
+        using namespace Detail;
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+        const uint8_t* end = p + size;
+        uint8_t* dst = reinterpret_cast<uint8_t*>(out);
+        uint8_t* const dstBegin = dst;
+        uint8_t* const dstEnd = dst + rawSize;
+        while (p < end) {
+            const uint8_t token = *p++;
+            size_t literalCount = token >> 4;
+            if (literalCount == 15 && !GetLength(p, end, literalCount)) return false;
+            if (literalCount > static_cast<size_t>(end - p) || literalCount > static_cast<size_t>(dstEnd - dst)) return false;
+            std::memcpy(dst, p, literalCount);
+            dst += literalCount;
+            p += literalCount;
+            if (p == end) break; // һֻ
+
+            if (end - p < 2) return false;
+            const size_t offset = p[0] | (size_t(p[1]) << 8);
+            p += 2;
+            size_t length = token & 15;
+            if (length == 15 && !GetLength(p, end, length)) return false;
+            length += MinMatch;
+            if (offset == 0 || offset > static_cast<size_t>(dst - dstBegin) || length > static_cast<size_t>(dstEnd - dst)) {
+                return false;
+            }
+            const uint8_t* match = dst - offset;
+            if (offset >= length) {
+                std::memcpy(dst, match, length);
+                dst += length;
+            }
+            else {
+                // صƥ䣨ظĶģʽֻֽڸ
+                for (size_t i = 0; i < length; ++i) *dst++ = match[i];
+            }
+        }
+        return dst == dstEnd;
+    }
+}
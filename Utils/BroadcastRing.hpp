@@ -0,0 +1,162 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * ̶㲥λ
+ * дͨ fetch_add ȡţд󸲸ɵĿ
+ * Ķȡ߸ԳαѣӰ죬ܼⱻǣĿ
+ * @tparam TEntry ĿͣǿƽƵģֽڿд
+ */
+template<typename TEntry>
+class BroadcastRing {
+    static_assert(std::is_trivially_copyable<TEntry>::value, "BroadcastRing entry must be trivially copyable");
+
+    /**
+     * λ汾Ϊ 2n+1 ʾ n д룬2n+2 ʾ n ѷ
+     */
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> version{ 0 };
+        TEntry entry;
+    };
+
+public:
+    /**
+     * ȡα꣬ÿ߳һ
+     */
+    struct Cursor {
+        uint64_t next = 0;    // һȡ
+        uint64_t dropped = 0; // ȡǶʧĿ
+    };
+
+    /**
+     * 캯
+     * @param capacity λȡΪ2
+     */
+    explicit BroadcastRing(size_t capacity) {
+        if (capacity == 0) throw std::invalid_argument("capacity must be positive");
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        _mask = size - 1;
+        _slots.reset(new Slot[size]);
+    }
+
+    BroadcastRing(const BroadcastRing&) = delete;
+    BroadcastRing& operator=(const BroadcastRing&) = delete;
+
+    /**
+     * ׷һ¼дһȦʱŻ
+     * @param entry ¼
+     * @return ü¼
+     */
+    uint64_t Append(const TEntry& entry) {
+        const uint64_t seq = _head.fetch_add(1, std::memory_order_relaxed);
+        Slot& slot = _slots[seq & _mask];
+
+        // ȴһȦдɣ֤ͬһλд봮
+        const uint64_t previous = seq > _mask ? 2 * (seq - _mask - 1) + 2 : 0;
+        while (slot.version.load(std::memory_order_acquire) != previous) {
+            std::this_thread::yield();
+        }
+
+        slot.version.store(2 * seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&slot.entry, &entry, sizeof(TEntry));
+        slot.version.store(2 * seq + 2, std::memory_order_release);
+        return seq;
+    }
+
+    /**
+     * һӵǰɿɶĿʼα
+     */
+    Cursor OpenCursor() const {
+        Cursor cursor;
+        cursor.next = OldestSequence();
+        return cursor;
+    }
+
+    /**
+     * һֻȡ˺дĿα
+     */
+    Cursor OpenCursorAtEnd() const {
+        Cursor cursor;
+        cursor.next = _head.load(std::memory_order_acquire);
+        return cursor;
+    }
+
+    /**
+     * αλöȡѷĿӰȡ
+     * @param cursor ȡα꣬ȡǰ
+     * @param out ȡ׷ӵ
+     * @param maxCount ȡ
+     * @return ζȡ
+     */
+    size_t Read(Cursor& cursor, std::vector<TEntry>& out, size_t maxCount = SIZE_MAX) const {
+        size_t count = 0;
+        while (count < maxCount) {
+            const uint64_t head = _head.load(std::memory_order_acquire);
+            if (cursor.next >= head) break;
+
+            // αһȦϣǵĲ
+            const uint64_t oldest = head > _mask ? head - _mask - 1 : 0;
+            if (cursor.next < oldest) {
+                cursor.dropped += oldest - cursor.next;
+                cursor.next = oldest;
+            }
+
+            const Slot& slot = _slots[cursor.next & _mask];
+            const uint64_t expected = 2 * cursor.next + 2;
+            const uint64_t before = slot.version.load(std::memory_order_acquire);
+            if (before < expected) break; // дδ´ٶ
+            if (before == expected) {
+                TEntry entry;
+                std::memcpy(&entry, &slot.entry, sizeof(TEntry));
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.version.load(std::memory_order_relaxed) == expected) {
+                    out.push_back(entry);
+                    ++cursor.next;
+                    ++count;
+                    continue;
+                }
+            }
+            // ȡвλһȦǣΪʧ
+            ++cursor.dropped;
+            ++cursor.next;
+        }
+        return count;
+    }
+
+    /**
+     * ȡѷдĿ
+     */
+    uint64_t HeadSequence() const {
+        return _head.load(std::memory_order_acquire);
+    }
+
+    /**
+     * ȡǰԿɶȡ
+     */
+    uint64_t OldestSequence() const {
+        const uint64_t head = _head.load(std::memory_order_acquire);
+        return head > _mask ? head - _mask - 1 : 0;
+    }
+
+    /**
+     * ȡλ
+     */
+    size_t Capacity() const {
+        return _mask + 1;
+    }
+
+private:
+    std::unique_ptr<Slot[]> _slots;             // λ
+    size_t _mask = 0;                           // 
+    alignas(64) std::atomic<uint64_t> _head{ 0 }; // һ
+};
@@ -0,0 +1,585 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "Synchronization.lib")
+#endif
+#elif defined(__linux__)
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace ChannelDetail {
+    /**
+     * ȡ2ݣΪ2
+     */
+    inline size_t RoundUpCapacity(size_t capacity) {
+        size_t rounded = 2;
+        while (rounded < capacity) rounded <<= 1;
+        return rounded;
+    }
+
+    /**
+     * Ԫصδʼ洢
+     */
+    template<typename T>
+    struct Storage {
+        alignas(T) unsigned char bytes[sizeof(T)];
+
+        T* Get() {
+            return std::launder(reinterpret_cast<T*>(bytes));
+        }
+    };
+
+    /**
+     *  word Ե expected ʱߣֱѣٷأ÷¼
+     * Windows ʹ WaitOnAddressLinux ֱʹ futexƽ̨˻ std::atomic::wait
+     */
+    inline void WaitWhileEqual(std::atomic<uint32_t>& word, uint32_t expected) {
+#ifdef _WIN32
+        WaitOnAddress(reinterpret_cast<volatile VOID*>(&word), &expected, sizeof(expected), INFINITE);
+#elif defined(__linux__)
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+        word.wait(expected);
+#endif
+    }
+
+    /**
+     *  word ߵ߳
+     * @param all Ƿȫֻһ
+     */
+    inline void Wake(std::atomic<uint32_t>& word, bool all) {
+#ifdef _WIN32
+        if (all) WakeByAddressAll(&word);
+        else WakeByAddressSingle(&word);
+#elif defined(__linux__)
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE, all ? INT_MAX : 1, nullptr, nullptr, 0);
+#else
+        if (all) word.notify_all();
+        else word.notify_one();
+#endif
+    }
+}
+
+/**
+ * ߵн绷ζ
+ * дλøռһУÿһ˻ԶλãֻڻֵʾգʱŶȡԶ˵ĻУ
+ * ӿһηԪأֻдһλáֻһ߳롢һ߳ȡ
+ * @tparam T Ԫͣƶ
+ */
+template<typename T>
+class SpscChannel {
+public:
+    typedef T value_type;
+
+    /**
+     * @param capacity ȡ2
+     */
+    explicit SpscChannel(size_t capacity)
+        : _mask(ChannelDetail::RoundUpCapacity(capacity) - 1),
+          _slots(new ChannelDetail::Storage<T>[_mask + 1]) {}
+
+    SpscChannel(const SpscChannel&) = delete;
+    SpscChannel& operator=(const SpscChannel&) = delete;
+
+    ~SpscChannel() {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        for (size_t i = _head.load(std::memory_order_relaxed); i != tail; ++i) _slots[i & _mask].Get()->~T();
+    }
+
+    /**
+     * һԪأ̵ֻ߳
+     * @return Ƿ룬ʱ false Ҳƶ item
+     */
+    template<typename U>
+    bool TryPush(U&& item) {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _cachedHead > _mask) {
+            _cachedHead = _head.load(std::memory_order_acquire);
+            if (tail - _cachedHead > _mask) return false;
+        }
+        ::new (static_cast<void*>(_slots[tail & _mask].bytes)) T(std::forward<U>(item));
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * ˳뾡ܶԪزһη̵ֻ߳
+     * @param items Ԫ飬Ԫر
+     * @param count Ԫ
+     * @return Ԫ items бߵǰ׺
+     */
+    size_t TryPushN(T* items, size_t count) {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        size_t free = _mask + 1 - (tail - _cachedHead);
+        if (free < count) {
+            _cachedHead = _head.load(std::memory_order_acquire);
+            free = _mask + 1 - (tail - _cachedHead);
+        }
+        const size_t pushed = std::min(free, count);
+        for (size_t i = 0; i < pushed; ++i) {
+            ::new (static_cast<void*>(_slots[(tail + i) & _mask].bytes)) T(std::move(items[i]));
+        }
+        if (pushed != 0) _tail.store(tail + pushed, std::memory_order_release);
+        return pushed;
+    }
+
+    /**
+     * ȡһԪأ̵ֻ߳
+     * @param item Ԫ
+     * @return ǷȡΪʱ false
+     */
+    bool TryPop(T& item) {
+        const size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _cachedTail) {
+            _cachedTail = _tail.load(std::memory_order_acquire);
+            if (head == _cachedTail) return false;
+        }
+        T* slot = _slots[head & _mask].Get();
+        item = std::move(*slot);
+        slot->~T();
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * ˳ȡ maxCount Ԫزһͷſռ䣬̵ֻ߳
+     * @param items Ԫص
+     * @param maxCount ȡԪ
+     * @return ȡԪ
+     */
+    size_t TryPopN(T* items, size_t maxCount) {
+        const size_t head = _head.load(std::memory_order_relaxed);
+        if (_cachedTail - head < maxCount) _cachedTail = _tail.load(std::memory_order_acquire);
+        const size_t popped = std::min(_cachedTail - head, maxCount);
+        for (size_t i = 0; i < popped; ++i) {
+            T* slot = _slots[(head + i) & _mask].Get();
+            items[i] = std::move(*slot);
+            slot->~T();
+        }
+        if (popped != 0) _head.store(head + popped, std::memory_order_release);
+        return popped;
+    }
+
+    /**
+     * ȡеԪ޸ʱֻǽֵ
+     */
+    size_t Size() const {
+        const size_t head = _head.load(std::memory_order_acquire);
+        return _tail.load(std::memory_order_acquire) - head;
+    }
+
+    /**
+     * ȡ
+     */
+    size_t Capacity() const {
+        return _mask + 1;
+    }
+
+private:
+    alignas(64) std::atomic<size_t> _head{ 0 }; // λãд
+    size_t _cachedTail = 0;                     // ߻дλ
+    alignas(64) std::atomic<size_t> _tail{ 0 }; // дλãд
+    size_t _cachedHead = 0;                     // ߻Ķλ
+    alignas(64) const size_t _mask;             // һ
+    std::unique_ptr<ChannelDetail::Storage<T>[]> _slots; // Ԫش洢
+};
+
+/**
+ * ߶нУVyukov 㷨
+ * ÿλһţŵλʱλдλüһʱɶ߸ CAS ȡλã
+ * 쵽ֻ֮ԼĲλͬλõȡ
+ * ӿȷϴӵǰλĲλѾһ CAS ȡλã
+ * ѾĲλֻ쵽λõ̲߳ŻĶCAS ɹζ鱾߳
+ * @tparam T Ԫͣƶ
+ */
+template<typename T>
+class MpmcChannel {
+    struct Cell {
+        std::atomic<size_t> sequence;
+        ChannelDetail::Storage<T> storage;
+    };
+
+public:
+    typedef T value_type;
+
+    /**
+     * @param capacity ȡ2
+     */
+    explicit MpmcChannel(size_t capacity)
+        : _mask(ChannelDetail::RoundUpCapacity(capacity) - 1), _cells(new Cell[_mask + 1]) {
+        for (size_t i = 0; i <= _mask; ++i) _cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    MpmcChannel(const MpmcChannel&) = delete;
+    MpmcChannel& operator=(const MpmcChannel&) = delete;
+
+    ~MpmcChannel() {
+        const size_t tail = _enqueuePos.load(std::memory_order_relaxed);
+        for (size_t i = _dequeuePos.load(std::memory_order_relaxed); i != tail; ++i) {
+            _cells[i & _mask].storage.Get()->~T();
+        }
+    }
+
+    /**
+     * һԪ
+     * @return Ƿ룬ʱ false Ҳƶ item
+     */
+    template<typename U>
+    bool TryPush(U&& item) {
+        size_t pos = _enqueuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &_cells[pos & _mask];
+            const intptr_t diff = static_cast<intptr_t>(cell->sequence.load(std::memory_order_acquire) - pos);
+            if (diff == 0) {
+                if (_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            else if (diff < 0) {
+                return false;
+            }
+            else {
+                pos = _enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        ::new (static_cast<void*>(cell->storage.bytes)) T(std::forward<U>(item));
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * ˳뾡ܶԪأλһ CAS ȡ
+     * @param items Ԫ飬Ԫر
+     * @param count Ԫ
+     * @return Ԫ items бߵǰ׺
+     */
+    size_t TryPushN(T* items, size_t count) {
+        if (count == 0) return 0;
+        size_t pos = _enqueuePos.load(std::memory_order_relaxed);
+        size_t claimed;
+        for (;;) {
+            claimed = 0;
+            while (claimed < count && claimed <= _mask
+                && _cells[(pos + claimed) & _mask].sequence.load(std::memory_order_acquire) == pos + claimed) {
+                ++claimed;
+            }
+            if (claimed == 0) {
+                const intptr_t diff = static_cast<intptr_t>(_cells[pos & _mask].sequence.load(std::memory_order_acquire) - pos);
+                if (diff < 0) return 0;
+                pos = _enqueuePos.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (_enqueuePos.compare_exchange_weak(pos, pos + claimed, std::memory_order_relaxed)) break;
+        }
+        for (size_t i = 0; i < claimed; ++i) {
+            Cell& cell = _cells[(pos + i) & _mask];
+            ::new (static_cast<void*>(cell.storage.bytes)) T(std::move(items[i]));
+            cell.sequence.store(pos + i + 1, std::memory_order_release);
+        }
+        return claimed;
+    }
+
+    /**
+     * ȡһԪ
+     * @param item Ԫ
+     * @return ǷȡΪʱ false
+     */
+    bool TryPop(T& item) {
+        size_t pos = _dequeuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &_cells[pos & _mask];
+            const intptr_t diff = static_cast<intptr_t>(cell->sequence.load(std::memory_order_acquire) - (pos + 1));
+            if (diff == 0) {
+                if (_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            else if (diff < 0) {
+                return false;
+            }
+            else {
+                pos = _dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        T* slot = cell->storage.Get();
+        item = std::move(*slot);
+        slot->~T();
+        cell->sequence.store(pos + _mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * ˳ȡ maxCount Ԫأλһ CAS ȡ
+     * @param items Ԫص
+     * @param maxCount ȡԪ
+     * @return ȡԪ
+     */
+    size_t TryPopN(T* items, size_t maxCount) {
+        if (maxCount == 0) return 0;
+        size_t pos = _dequeuePos.load(std::memory_order_relaxed);
+        size_t claimed;
+        for (;;) {
+            claimed = 0;
+            while (claimed < maxCount && claimed <= _mask
+                && _cells[(pos + claimed) & _mask].sequence.load(std::memory_order_acquire) == pos + claimed + 1) {
+                ++claimed;
+            }
+            if (claimed == 0) {
+                const intptr_t diff = static_cast<intptr_t>(_cells[pos & _mask].sequence.load(std::memory_order_acquire) - (pos + 1));
+                if (diff < 0) return 0;
+                pos = _dequeuePos.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (_dequeuePos.compare_exchange_weak(pos, pos + claimed, std::memory_order_relaxed)) break;
+        }
+        for (size_t i = 0; i < claimed; ++i) {
+            Cell& cell = _cells[(pos + i) & _mask];
+            T* slot = cell.storage.Get();
+            items[i] = std::move(*slot);
+            slot->~T();
+            cell.sequence.store(pos + i + _mask + 1, std::memory_order_release);
+        }
+        return claimed;
+    }
+
+    /**
+     * ȡеԪ޸ʱֻǽֵ
+     */
+    size_t Size() const {
+        const size_t head = _dequeuePos.load(std::memory_order_acquire);
+        const size_t tail = _enqueuePos.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    /**
+     * ȡ
+     */
+    size_t Capacity() const {
+        return _mask + 1;
+    }
+
+private:
+    alignas(64) std::atomic<size_t> _enqueuePos{ 0 }; // һλ
+    alignas(64) std::atomic<size_t> _dequeuePos{ 0 }; // һȡλ
+    alignas(64) const size_t _mask;                   // һ
+    std::unique_ptr<Cell[]> _cells;                   // λ
+};
+
+/**
+ *  SpscChannel  MpmcChannel ȴر
+ * 루ȡʧʱԣʧߣWindows  WaitOnAddress  Linux  futex
+ * ԶֻߵǼʱŵŲѣûеȴʱ·ֻжһ޾Ķд
+ * ߻ߵԼײͬ
+ * @tparam TQueue ײ
+ */
+template<typename TQueue>
+class BlockingChannel {
+public:
+    typedef typename TQueue::value_type value_type;
+
+    /**
+     * @param capacity ȡ2
+     * @param spinCount ǰԴ
+     */
+    explicit BlockingChannel(size_t capacity, uint32_t spinCount = 64) : _queue(capacity), _spinCount(spinCount) {}
+
+    BlockingChannel(const BlockingChannel&) = delete;
+    BlockingChannel& operator=(const BlockingChannel&) = delete;
+
+    /**
+     * һԪأʱȴ
+     * @return Ƿ룬ͨѹرʱ false
+     */
+    template<typename U>
+    bool Push(U&& item) {
+        for (;;) {
+            if (_closed.load()) return false;
+            for (uint32_t spin = 0; spin <= _spinCount; ++spin) {
+                if (_queue.TryPush(std::forward<U>(item))) {
+                    Notify(_notEmpty, _popWaiters);
+                    return true;
+                }
+            }
+            const uint32_t signal = _notFull.load();
+            _pushWaiters.fetch_add(1);
+            // Ǽ֮һΣǼ֮ǰȡһ֮ܿȡһ
+            if (_closed.load()) {
+                _pushWaiters.fetch_sub(1);
+                return false;
+            }
+            if (_queue.TryPush(std::forward<U>(item))) {
+                _pushWaiters.fetch_sub(1);
+                Notify(_notEmpty, _popWaiters);
+                return true;
+            }
+            ChannelDetail::WaitWhileEqual(_notFull, signal);
+            _pushWaiters.fetch_sub(1);
+        }
+    }
+
+    /**
+     * ȫԪأпռ䲻ʱֶεȴ
+     * @param items Ԫ飬Ԫر
+     * @param count Ԫ
+     * @return ԪֻͨرʱС count
+     */
+    size_t PushN(value_type* items, size_t count) {
+        size_t pushed = 0;
+        while (pushed < count && !_closed.load()) {
+            const size_t batch = _queue.TryPushN(items + pushed, count - pushed);
+            if (batch != 0) {
+                pushed += batch;
+                Notify(_notEmpty, _popWaiters);
+                continue;
+            }
+            if (!Push(std::move(items[pushed]))) return pushed;
+            ++pushed;
+        }
+        return pushed;
+    }
+
+    /**
+     * ȡһԪأΪʱȴ
+     * @param item Ԫ
+     * @return ǷȡͨѹرҶΪʱ false
+     */
+    bool Pop(value_type& item) {
+        for (;;) {
+            for (uint32_t spin = 0; spin <= _spinCount; ++spin) {
+                if (_queue.TryPop(item)) {
+                    Notify(_notFull, _pushWaiters);
+                    return true;
+                }
+            }
+            const uint32_t signal = _notEmpty.load();
+            _popWaiters.fetch_add(1);
+            if (_queue.TryPop(item)) {
+                _popWaiters.fetch_sub(1);
+                Notify(_notFull, _pushWaiters);
+                return true;
+            }
+            if (_closed.load()) {
+                _popWaiters.fetch_sub(1);
+                // ر֮ǰɵڴ֮һɼ
+                if (!_queue.TryPop(item)) return false;
+                Notify(_notFull, _pushWaiters);
+                return true;
+            }
+            ChannelDetail::WaitWhileEqual(_notEmpty, signal);
+            _popWaiters.fetch_sub(1);
+        }
+    }
+
+    /**
+     * ȡ maxCount ԪأΪʱȴһ
+     * @param items Ԫص
+     * @param maxCount ȡԪ0
+     * @return ȡԪͨѹرҶΪʱΪ0
+     */
+    size_t PopN(value_type* items, size_t maxCount) {
+        const size_t popped = _queue.TryPopN(items, maxCount);
+        if (popped != 0) {
+            Notify(_notFull, _pushWaiters);
+            return popped;
+        }
+        if (!Pop(items[0])) return 0;
+        return 1 + TryPopN(items + 1, maxCount - 1);
+    }
+
+    /**
+     * ȴһԪ
+     * @return Ƿ룬ͨѹرʱ false
+     */
+    template<typename U>
+    bool TryPush(U&& item) {
+        if (_closed.load() || !_queue.TryPush(std::forward<U>(item))) return false;
+        Notify(_notEmpty, _popWaiters);
+        return true;
+    }
+
+    /**
+     * ȴȡһԪ
+     * @return Ƿȡ
+     */
+    bool TryPop(value_type& item) {
+        if (!_queue.TryPop(item)) return false;
+        Notify(_notFull, _pushWaiters);
+        return true;
+    }
+
+    /**
+     * ȴȡ maxCount Ԫ
+     * @return ȡԪ
+     */
+    size_t TryPopN(value_type* items, size_t maxCount) {
+        const size_t popped = _queue.TryPopN(items, maxCount);
+        if (popped != 0) Notify(_notFull, _pushWaiters);
+        return popped;
+    }
+
+    /**
+     * ر֮ͨʧܣȡڶſպʧܣеȴ̱߳
+     */
+    void Close() {
+        _closed.store(true);
+        _notEmpty.fetch_add(1);
+        _notFull.fetch_add(1);
+        ChannelDetail::Wake(_notEmpty, true);
+        ChannelDetail::Wake(_notFull, true);
+    }
+
+    /**
+     * ͨǷѹر
+     */
+    bool IsClosed() const {
+        return _closed.load();
+    }
+
+    /**
+     * ȡеԪ޸ʱֻǽֵ
+     */
+    size_t Size() const {
+        return _queue.Size();
+    }
+
+    /**
+     * ȡ
+     */
+    size_t Capacity() const {
+        return _queue.Capacity();
+    }
+
+private:
+    /**
+     * ԶߵǼʱŲһ
+     * öдȡǼȴĵǼҪô̶߳ǼǣҪôȴǼǺԿ޸
+     */
+    static void Notify(std::atomic<uint32_t>& signal, std::atomic<uint32_t>& waiters) {
+        if (waiters.fetch_add(0) == 0) return;
+        signal.fetch_add(1);
+        ChannelDetail::Wake(signal, false);
+    }
+
+    TQueue _queue;                                     // ײ
+    alignas(64) std::atomic<uint32_t> _notEmpty{ 0 };  // ţȡڴ
+    std::atomic<uint32_t> _popWaiters{ 0 };            // ߵǼǵȡ
+    alignas(64) std::atomic<uint32_t> _notFull{ 0 };   // ȡţ뷽ڴ
+    std::atomic<uint32_t> _pushWaiters{ 0 };           // ߵǼǵ뷽
+    alignas(64) std::atomic<bool> _closed{ false };    // Ƿѹر
+    const uint32_t _spinCount;                         // ǰԴ
+};
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include "NumaTopology.hpp"
+
+/**
+ * ±ֿ洢飬ֿη
+ * Ԫصַһ䲻ٸı䣬ѷԪصĶдֻз·ֿʱݼ
+ * ָ·ֿڵ NUMA ڵ
+ * @tparam T ԪͣĬϹ
+ * @tparam FirstChunkBits һֿĶ
+ */
+template<typename T, size_t FirstChunkBits = 10>
+class ChunkedArray {
+    static constexpr size_t FirstChunkSize = size_t(1) << FirstChunkBits;
+    static constexpr size_t MaxChunks = 33 - FirstChunkBits; // ȫ32λ±
+
+public:
+    ChunkedArray() = default;
+    ChunkedArray(const ChunkedArray&) = delete;
+    ChunkedArray& operator=(const ChunkedArray&) = delete;
+
+    ~ChunkedArray() {
+        for (size_t i = 0; i < MaxChunks; ++i) {
+            T* storage = _chunks[i].load(std::memory_order_relaxed);
+            if (!storage) continue;
+            if (_placedChunks & (uint64_t(1) << i)) {
+                std::destroy_n(storage, FirstChunkSize << i);
+                NumaTopology::Free(storage, (FirstChunkSize << i) * sizeof(T));
+            }
+            else {
+                delete[] storage;
+            }
+        }
+    }
+
+    /**
+     * ô˺·ķֿڵ NUMA ڵ㣬ѷķֿ鲻Ӱ죨 ForEachChunk Ǩƣ
+     * @param node ڵţ-1 ʾʹĬϷ
+     */
+    void SetNode(int node) {
+        std::lock_guard<std::mutex> lock(_growMutex);
+        _node = node;
+    }
+
+    /**
+     * ȷ±ڵķֿѷ
+     * @param index ±
+     * @return Ԫ
+     */
+    T& Ensure(size_t index) {
+        size_t chunk, offset;
+        Locate(index, chunk, offset);
+        T* storage = _chunks[chunk].load(std::memory_order_acquire);
+        if (!storage) {
+            std::lock_guard<std::mutex> lock(_growMutex);
+            storage = _chunks[chunk].load(std::memory_order_relaxed);
+            if (!storage) {
+                storage = AllocateChunkLocked(chunk);
+                _chunks[chunk].store(storage, std::memory_order_release);
+            }
+        }
+        return storage[offset];
+    }
+
+    /**
+     * ж±ڵķֿǷѷ
+     */
+    bool IsAllocated(size_t index) const {
+        size_t chunk, offset;
+        Locate(index, chunk, offset);
+        return _chunks[chunk].load(std::memory_order_acquire) != nullptr;
+    }
+
+    /**
+     * ѷԪأ÷豣֤±ͨ Ensure 
+     */
+    T& operator[](size_t index) {
+        size_t chunk, offset;
+        Locate(index, chunk, offset);
+        return _chunks[chunk].load(std::memory_order_acquire)[offset];
+    }
+
+    const T& operator[](size_t index) const {
+        size_t chunk, offset;
+        Locate(index, chunk, offset);
+        return _chunks[chunk].load(std::memory_order_acquire)[offset];
+    }
+
+    /**
+     * ѷķֿ
+     * @param callback  void(const T* data, size_t count) Ļص
+     */
+    template<typename Callback>
+    void ForEachChunk(Callback&& callback) const {
+        for (size_t i = 0; i < MaxChunks; ++i) {
+            const T* storage = _chunks[i].load(std::memory_order_acquire);
+            if (storage) callback(storage, FirstChunkSize << i);
+        }
+    }
+
+private:
+    /**
+     * һֿ鲢ֵʼȫԪأз
+     */
+    T* AllocateChunkLocked(size_t chunk) {
+        const size_t count = FirstChunkSize << chunk;
+        if (_node < 0) return new T[count]();
+        T* storage = static_cast<T*>(NumaTopology::Allocate(count * sizeof(T), _node));
+        try {
+            std::uninitialized_value_construct_n(storage, count);
+        }
+        catch (...) {
+            NumaTopology::Free(storage, count * sizeof(T));
+            throw;
+        }
+        _placedChunks |= uint64_t(1) << chunk;
+        return storage;
+    }
+
+    /**
+     * ±ڵķֿƫ
+     */
+    static void Locate(size_t index, size_t& chunk, size_t& offset) {
+        const size_t biased = index + FirstChunkSize;
+        const size_t highBit = static_cast<size_t>(std::bit_width(biased)) - 1;
+        chunk = highBit - FirstChunkBits;
+        offset = biased - (size_t(1) << highBit);
+        if (chunk >= MaxChunks) throw std::out_of_range("ChunkedArray index out of range");
+    }
+
+    std::atomic<T*> _chunks[MaxChunks] = {}; // ָֿ
+    std::mutex _growMutex;                   // ·ֿʱʹ
+    int _node = -1;                          // ·ֿڵ NUMA ڵ㣬 _growMutex 
+    uint64_t _placedChunks = 0;              // ڵķֿ飨λͼ _growMutex 
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include "ChunkedArray.hpp"
+
+/**
+ * ܱԭӼֿ
+ * ַһ䲻ٸı䣬д
+ */
+class CounterTable {
+public:
+    /**
+     * ȡŶӦļʱ
+     * @param id ܱ
+     * @return 
+     */
+    std::atomic<int64_t>& At(uint32_t id) {
+        return _counters.Ensure(id);
+    }
+
+    /**
+     * ȡֵδʱ 0
+     * @param id ܱ
+     * @return ֵ
+     */
+    int64_t Get(uint32_t id) const {
+        return _counters.IsAllocated(id) ? _counters[id].load(std::memory_order_relaxed) : 0;
+    }
+
+private:
+    ChunkedArray<std::atomic<int64_t>, 6> _counters; // ֿ
+};
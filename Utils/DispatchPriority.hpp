@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+/**
+ * ȼֵԽСԽ
+ */
+enum class DispatchPriority : uint8_t {
+    Critical = 0,   // ؼ·ؼ
+    High = 1,       // ͨ
+    Normal = 2,     // Ĭ
+    Background = 3, // ͳƷȿӺĹ
+};
+
+// ȼĸ
+constexpr size_t DispatchPriorityCount = 4;
+
+/**
+ * Ļύʱĵѡ
+ */
+struct DispatchOptions {
+    DispatchPriority priority = DispatchPriority::Normal; // ȼ
+    std::chrono::nanoseconds deadline{ 0 };               // ύʼִеʱޣ0 ʾ
+    bool dropExpired = false;                             // ʱ޲ִֵʱǷִ
+};
+
+namespace DispatchPriorityDetail {
+    /**
+     * ͬһȼڵʱԽԽǰʱ޵
+     */
+    inline int64_t DeadlineRank(const DispatchOptions& options) {
+        return options.deadline.count() > 0 ? options.deadline.count() : INT64_MAX;
+    }
+}
+
+/**
+ * ĵ˳Ȱȼٰʱޣͬʱֶ˳ȶ룩
+ */
+inline bool DispatchesBefore(const DispatchOptions& left, const DispatchOptions& right) {
+    if (left.priority != right.priority) return left.priority < right.priority;
+    return DispatchPriorityDetail::DeadlineRank(left) < DispatchPriorityDetail::DeadlineRank(right);
+}
+
+/**
+ * 񽻸ִִ֧ executor(task, options) WorkStealingPoolʱϵѡ
+ *  executor(task) ύȼֻύ˳
+ */
+template<typename TExecutor, typename TTask>
+void SubmitWithOptions(TExecutor& executor, TTask&& task, const DispatchOptions& options) {
+    if constexpr (std::is_invocable<TExecutor&, TTask, const DispatchOptions&>::value) {
+        executor(std::forward<TTask>(task), options);
+    }
+    else {
+        executor(std::forward<TTask>(task));
+    }
+}
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "ChunkedArray.hpp"
+
+namespace EpochDetail {
+    /**
+     * ̱߳ŷ߳˳ʱ黹Ź̸߳ãʹűֳ
+     */
+    class ThreadIndexRegistry {
+    public:
+        static ThreadIndexRegistry& Instance() {
+            static ThreadIndexRegistry instance;
+            return instance;
+        }
+
+        uint32_t Acquire() {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_free.empty()) return _next++;
+            const uint32_t index = _free.back();
+            _free.pop_back();
+            return index;
+        }
+
+        void Release(uint32_t index) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _free.push_back(index);
+        }
+
+    private:
+        std::mutex _mutex;
+        std::vector<uint32_t> _free;
+        uint32_t _next = 0;
+    };
+
+    /**
+     * ֲ߳̾ıų
+     */
+    struct ThreadIndex {
+        ThreadIndex() : value(ThreadIndexRegistry::Instance().Acquire()) {}
+        ~ThreadIndex() { ThreadIndexRegistry::Instance().Release(value); }
+        uint32_t value;
+    };
+
+    /**
+     * ȡǰ̵߳ĳܱ
+     */
+    inline uint32_t CurrentThreadIndex() {
+        thread_local ThreadIndex index;
+        return index.value;
+    }
+}
+
+/**
+ * ڼԪڴգEBRԭ滻ֻʵ RCU
+ *  Pin() ٽֻд̵߳ļԪۣ䣻
+ * д滻ָ Retire() ۾ɶ󣬵лԾ߽ٽʱļԪ
+ * ۼԪʱͷšٽӦСʱлƳлա
+ * д滻߶ȡָ붼ʹĬϵ˳һڴ
+ */
+class EpochReclaimer {
+    /**
+     * ÿ߳һԪۣռб֮α
+     */
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> epoch{ 0 }; // ٽʱȫּԪ0 ʾٽ
+        uint32_t depth = 0;               // Ƕȣ̷ֻ߳
+    };
+
+    /**
+     * ۡȴͷŵĶ
+     */
+    struct Retired {
+        void* pointer;
+        void (*deleter)(void*);
+        uint64_t epoch; // ۼԪ
+    };
+
+public:
+    /**
+     * ٽʱ˳ٽ
+     */
+    class Guard {
+    public:
+        explicit Guard(ReaderSlot* slot) : _slot(slot) {}
+        Guard(Guard&& other) noexcept : _slot(std::exchange(other._slot, nullptr)) {}
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+        Guard& operator=(Guard&&) = delete;
+
+        ~Guard() {
+            if (_slot && --_slot->depth == 0) _slot->epoch.store(0, std::memory_order_release);
+        }
+
+    private:
+        ReaderSlot* _slot;
+    };
+
+    EpochReclaimer() = default;
+    EpochReclaimer(const EpochReclaimer&) = delete;
+    EpochReclaimer& operator=(const EpochReclaimer&) = delete;
+
+    /**
+     * ʱͷδյĶ󣬵÷豣֤ûж
+     */
+    ~EpochReclaimer() {
+        for (auto& retired : _retired) retired.deleter(retired.pointer);
+    }
+
+    /**
+     * ٽصڼĿղᱻͷţǶ
+     * @return ٽ
+     */
+    Guard Pin() {
+        const uint32_t index = EpochDetail::CurrentThreadIndex();
+        ReaderSlot* slot = &_slots.Ensure(index);
+        if (slot->depth++ == 0) {
+            // û߿λٷԪɵ÷ȡָ
+            uint32_t count = _slotCount.load();
+            while (count <= index && !_slotCount.compare_exchange_weak(count, index + 1)) {}
+            slot->epoch.store(_globalEpoch.load());
+        }
+        return Guard(slot);
+    }
+
+    /**
+     * һѴӹָժµĶ󣬴пܳĶ뿪ͷ
+     * @tparam T 
+     * @param pointer  new Ķ
+     */
+    template<typename T>
+    void Retire(T* pointer) {
+        if (!pointer) return;
+        std::lock_guard<std::mutex> lock(_retireMutex);
+        const uint64_t epoch = _globalEpoch.fetch_add(1) + 1;
+        _retired.push_back(Retired{ const_cast<void*>(static_cast<const void*>(pointer)),
+            [](void* p) { delete static_cast<T*>(p); }, epoch });
+        CollectLocked();
+    }
+
+    /**
+     * ƽȫּԪ¼Ԫ Retire յԴɸõĲλ۱ǣ
+     * ԴժȡõļԪ SafeEpoch() ʱûжܷ
+     * @return ۼԪ
+     */
+    uint64_t Advance() {
+        return _globalEpoch.fetch_add(1) + 1;
+    }
+
+    /**
+     * ȡɰȫյļԪϽ磺ڵǰȫּԪҲκλԾ߽ٽʱļԪ
+     * @return ԪϽ
+     */
+    uint64_t SafeEpoch() const {
+        uint64_t safe = _globalEpoch.load();
+        const uint32_t count = _slotCount.load();
+        for (uint32_t i = 0; i < count; ++i) {
+            // ̱߳ڽڷ䣬ŽС߳δؽ
+            if (!_slots.IsAllocated(i)) continue;
+            const uint64_t epoch = _slots[i].epoch.load();
+            if (epoch != 0) safe = std::min(safe, epoch);
+        }
+        return safe;
+    }
+
+    /**
+     * ͷ۶
+     */
+    void Collect() {
+        std::lock_guard<std::mutex> lock(_retireMutex);
+        CollectLocked();
+    }
+
+    /**
+     * ȡδͷŵ۶
+     */
+    size_t PendingCount() {
+        std::lock_guard<std::mutex> lock(_retireMutex);
+        return _retired.size();
+    }
+
+private:
+    /**
+     * ͷۼԪлԾ߼ԪĶ
+     */
+    void CollectLocked() {
+        const uint64_t safe = SafeEpoch();
+        auto reclaimable = std::partition(_retired.begin(), _retired.end(),
+            [&](const Retired& retired) { return retired.epoch > safe; });
+        for (auto it = reclaimable; it != _retired.end(); ++it) it->deleter(it->pointer);
+        _retired.erase(reclaimable, _retired.end());
+    }
+
+    ChunkedArray<ReaderSlot, 6> _slots;       // ̱߳ļԪ
+    std::atomic<uint32_t> _slotCount{ 0 };    // ʹõļԪ
+    std::atomic<uint64_t> _globalEpoch{ 1 };  // ȫּԪ1ʼ
+    std::vector<Retired> _retired;            // ȴͷŵĶ
+    std::mutex _retireMutex;                  // бֻдʹ
+};
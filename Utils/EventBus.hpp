@@ -0,0 +1,261 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "EventSubscribe.hpp"
+#include "InplaceFunction.hpp"
+
+/**
+ * ¼ѡ
+ */
+struct EventBusOptions {
+    size_t queueCapacity = 4096; // ÿ첽ед Post ʧ
+    size_t drainBatch = 256;     // һſַ¼ύִⳤռù߳
+};
+
+namespace EventBusDetail {
+    /**
+     * беλãбʱΪб
+     */
+    template<typename T, typename... Ts>
+    constexpr size_t IndexOf() {
+        constexpr bool matches[] = { std::is_same<T, Ts>::value..., false };
+        for (size_t i = 0; i < sizeof...(Ts); ++i) {
+            if (matches[i]) return i;
+        }
+        return sizeof...(Ts);
+    }
+
+    /**
+     * бǷظ
+     */
+    template<typename... Ts>
+    constexpr bool HasDuplicates() {
+        constexpr size_t indices[] = { IndexOf<Ts, Ts...>()..., 0 };
+        for (size_t i = 0; i < sizeof...(Ts); ++i) {
+            if (indices[i] != i) return true;
+        }
+        return false;
+    }
+}
+
+/**
+ * ¼·ɵĽ¼
+ * ⼯ģڱȷ¼ڱڽΪԪеλã
+ * ֻȡӦĶıû type_index ңδǼǵ¼޷ͨ롣
+ * ÿĶıһ BasicSubscribeEventпɶġȡĻٷ
+ * Post ¼нУִ WorkStealingPoolϵſ˳ַ
+ * ͬһͬʱֻһſ첽ַ¼Ͷ˳
+ * ʱȴύſִǰֿ
+ * @tparam TEvents ¼ͣظ
+ */
+template<typename... TEvents>
+class EventBus {
+    static_assert(sizeof...(TEvents) > 0, "EventBus needs at least one event type");
+    static_assert(!EventBusDetail::HasDuplicates<TEvents...>(), "EventBus event types must be unique");
+
+    // ύִſ
+    typedef InplaceFunction<void(), 32> Task;
+
+public:
+    // еıţڳ
+    template<typename TEvent>
+    static constexpr size_t TopicIndex = EventBusDetail::IndexOf<TEvent, TEvents...>();
+
+    // Ķı
+    template<typename TEvent>
+    using TopicEvent = BasicSubscribeEvent<std::function<void(const TEvent&)>, const TEvent&>;
+
+    // Ķľ
+    template<typename TEvent>
+    using Subscription = typename TopicEvent<TEvent>::Subscription;
+
+private:
+    /**
+     * һ⣺ı첽
+     */
+    template<typename TEvent>
+    struct Topic {
+        TopicEvent<TEvent> handlers;         // ı
+        std::mutex queueMutex;               // 첽
+        std::deque<TEvent> queue;            // 첽
+        std::atomic<bool> draining{ false }; // Ƿſ
+        std::atomic<uint64_t> dropped{ 0 };  // ܾ¼
+    };
+
+    template<typename TEvent>
+    Topic<TEvent>& TopicOf() {
+        static_assert(TopicIndex<TEvent> < sizeof...(TEvents), "Event type is not registered in this EventBus");
+        return std::get<TopicIndex<TEvent>>(_topics);
+    }
+
+public:
+    /**
+     * ֻͬ¼
+     * @param options ѡ
+     */
+    explicit EventBus(const EventBusOptions& options = EventBusOptions()) : _options(options) {
+        if (_options.drainBatch == 0) _options.drainBatch = 1;
+    }
+
+    /**
+     * ֧첽ַ¼
+     * @param executor ִ executor(task) ύ޲ WorkStealingPoolñ
+     * @param options ѡ
+     */
+    template<typename TExecutor, typename = std::enable_if_t<!std::is_same<TExecutor, EventBusOptions>::value
+        && !std::is_same<TExecutor, EventBus>::value>>
+    explicit EventBus(TExecutor& executor, const EventBusOptions& options = EventBusOptions())
+        : EventBus(options) {
+        _executor = [&executor](Task task) { executor(std::move(task)); };
+    }
+
+    EventBus(const EventBus&) = delete;
+    EventBus& operator=(const EventBus&) = delete;
+
+    /**
+     * ȴύſ
+     */
+    ~EventBus() {
+        while (_activeDrains.load() != 0) std::this_thread::yield();
+    }
+
+    /**
+     * һ¼
+     * @param handler  void(const TEvent&) Ĵ
+     * @param priority ȼͬһиȼĴȱ
+     * @return ľ
+     */
+    template<typename TEvent, typename THandler>
+    Subscription<TEvent> Subscribe(THandler&& handler, DispatchPriority priority = DispatchPriority::Normal) {
+        return TopicOf<TEvent>().handlers.subscribe(std::forward<THandler>(handler), priority);
+    }
+
+    /**
+     * ȡ
+     * @param subscription ʱصľ
+     * @return ǷȻЧ
+     */
+    template<typename TEvent>
+    bool Unsubscribe(const Subscription<TEvent>& subscription) {
+        return TopicOf<TEvent>().handlers.unsubscribe(subscription);
+    }
+
+    /**
+     * ڵǰ߳ͬ¼ʱдִ
+     * @param event ¼
+     */
+    template<typename TEvent>
+    void Publish(const TEvent& event) {
+        TopicOf<TEvent>().handlers(event);
+    }
+
+    /**
+     * ¼нУִ첽ַ
+     * @param event ¼
+     * @return Ƿӣʱ false 붪
+     */
+    template<typename TEvent>
+    bool Post(TEvent event) {
+        if (!_executor) throw std::logic_error("EventBus has no executor for asynchronous posting");
+        Topic<TEvent>& topic = TopicOf<TEvent>();
+        {
+            std::lock_guard<std::mutex> lock(topic.queueMutex);
+            if (topic.queue.size() >= _options.queueCapacity) {
+                topic.dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            topic.queue.push_back(std::move(event));
+        }
+        ScheduleDrain(topic);
+        return true;
+    }
+
+    /**
+     * ȡδַ¼
+     */
+    template<typename TEvent>
+    size_t PendingCount() {
+        Topic<TEvent>& topic = TopicOf<TEvent>();
+        std::lock_guard<std::mutex> lock(topic.queueMutex);
+        return topic.queue.size();
+    }
+
+    /**
+     * ȡܾ¼
+     */
+    template<typename TEvent>
+    uint64_t DroppedCount() {
+        return TopicOf<TEvent>().dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    /**
+     * ûſʱύһ
+     */
+    template<typename TEvent>
+    void ScheduleDrain(Topic<TEvent>& topic) {
+        if (topic.draining.exchange(true)) return;
+        _activeDrains.fetch_add(1);
+        try {
+            _executor(Task([this, &topic] { Drain(topic); }));
+        }
+        catch (...) {
+            topic.draining.store(false);
+            _activeDrains.fetch_sub(1);
+            throw;
+        }
+    }
+
+    /**
+     * ſ񣺰˳ַ drainBatch ¼¼ʱύ˳
+     */
+    template<typename TEvent>
+    void Drain(Topic<TEvent>& topic) {
+        std::vector<TEvent> batch;
+        {
+            std::lock_guard<std::mutex> lock(topic.queueMutex);
+            const size_t count = std::min(topic.queue.size(), _options.drainBatch);
+            batch.reserve(count);
+            for (size_t i = 0; i < count; ++i) {
+                batch.push_back(std::move(topic.queue.front()));
+                topic.queue.pop_front();
+            }
+        }
+        for (const auto& event : batch) topic.handlers(event);
+
+        bool more;
+        {
+            std::lock_guard<std::mutex> lock(topic.queueMutex);
+            more = !topic.queue.empty();
+            // ڶ־˺ӵ¼һύµſ
+            if (!more) topic.draining.store(false);
+        }
+        if (more) {
+            try {
+                _executor(Task([this, &topic] { Drain(topic); }));
+                return;
+            }
+            catch (...) {
+                topic.draining.store(false);
+            }
+        }
+        _activeDrains.fetch_sub(1);
+    }
+
+    std::tuple<Topic<TEvents>...> _topics;   // ڱе
+    std::function<void(Task)> _executor;     // 첽ִַδʱΪ
+    EventBusOptions _options;                // ѡ
+    std::atomic<uint32_t> _activeDrains{ 0 }; // ύδſ
+};
@@ -1,69 +1,127 @@
 #pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <vector>
 #include <mutex>
+#include "DispatchPriority.hpp"
+#include "EpochReclaimer.hpp"
 
-template<typename... Args>
-class ThreadSafeEventNormal {
-    // 洢Ѷĵ¼
-    std::vector<std::function<void(Args...)>> handlers;
-    // handlersʵĻ
+// ̰߳ȫ¼THandlerΪĴ洢ͣΪstd::functionֻƶInplaceFunction
+template<typename THandler, typename... Args>
+class BasicThreadSafeEventNormal {
+    // ѶĵĴ䡢ڿ֮乲бʱҪɸ
+    struct HandlerEntry {
+        uint64_t id;                             // ı
+        std::shared_ptr<const THandler> handler; // 
+        DispatchOptions options;                 // ȼʱ
+    };
+    typedef std::vector<HandlerEntry> HandlerList;
+
+    // ǰĴбգ޸ģĺȡʱ滻
+    std::atomic<const HandlerList*> handlers{ new HandlerList() };
+    // лдߣġȡģ¼ʹ
     mutable std::mutex mtx;
+    // ձ滻ľɿգڷ߳뿪ͷ
+    mutable EpochReclaimer reclaimer;
+    // һıţmtx
+    uint64_t nextId = 1;
+
+    // ޸ĺĸ滻ǰգmtx
+    template<typename Modify>
+    void Update(Modify&& modify) {
+        const HandlerList* current = handlers.load();
+        auto next = new HandlerList(*current);
+        modify(*next);
+        handlers.store(next);
+        reclaimer.Retire(current);
+    }
+
 public:
-    // ¼
+    // ıţȡ
+    typedef uint64_t HandlerId;
+
+    BasicThreadSafeEventNormal() = default;
+    BasicThreadSafeEventNormal(const BasicThreadSafeEventNormal&) = delete;
+    BasicThreadSafeEventNormal& operator=(const BasicThreadSafeEventNormal&) = delete;
+
+    // ʱӦ߳ڷ¼
+    ~BasicThreadSafeEventNormal() {
+        delete handlers.load();
+    }
+
+    // ¼ʹͨȼʱ
     // handlerǷǩĿɵö纯lambdaʽ
-    // ֤ͨڶ̻߳Ӵʱ̰߳ȫ
-    // Էֹ߳ͬʱ޸handlersʧЧ
-    void operator+=(const std::function<void(Args...)>& handler) {
+    // дʱƣڸƵǰб׷Ӻԭ滻бӳͷ
+    // ĵĿ洦Դ˻ȡʱ޸
+    // ضıţȡ
+    HandlerId operator+=(THandler handler) {
+        return Subscribe(std::move(handler), DispatchOptions());
+    }
+
+    // ȼʱ޶¼
+    // бȼٰʱޣԽԽǰͬʱֶ˳
+    // ͬ˳ãĴصȴǰ
+    // 첽˳ύִֵ֧ѡʱWorkStealingPoolһ𴫵
+    // ضıţȡ
+    HandlerId Subscribe(THandler handler, const DispatchOptions& options) {
+        auto shared = std::make_shared<const THandler>(std::move(handler));
         std::lock_guard<std::mutex> lock(mtx);
-        handlers.push_back(handler);
+        const HandlerId id = nextId++;
+        Update([&](HandlerList& list) {
+            auto position = std::upper_bound(list.begin(), list.end(), options,
+                [](const DispatchOptions& value, const HandlerEntry& entry) { return DispatchesBefore(value, entry.options); });
+            list.insert(position, HandlerEntry{ id, std::move(shared), options });
+        });
+        return id;
     }
 
     // ¼жĵĴ
     // argsǴݸĲﰴֵݣܲ
-    // ֤ͨڶ̻߳·handlers̰߳ȫ
-    // ȴhandlersıظִдĳʱ
+    // ֻĶٽȡǰգơ䣬
+    // ߳̿ͬʱڼĶıһηʼЧ
+    // ִڼƳپɿյͷţʱϳĴӦʹAsync
     // ׳쳣ִ
     void operator()(Args... args) const {
-        std::lock_guard<std::mutex> lock(mtx);
-
-        // ʱִ֤ڼhandlers߳޸
-        auto localHandlers = handlers;
-
-        // ִдʱʱ
-        lock.unlock();
-
-        for (const auto& h : localHandlers) {
-            h(args...);
+        auto guard = reclaimer.Pin();
+        for (const auto& entry : *handlers.load()) {
+            (*entry.handler)(args...);
         }
     }
 
-    // ȡĺڴѶĵĴбƳָĴ
-    // ֤ͨڶ̻߳Ƴʱ̰߳ȫ
-    // ĿǰֻԤӿڣδʵ־ĲҺƳ߼ֱӷtrue
-    bool operator-=(const std::function<void(Args...)>& handler) {
+    // ȡĺıŴӴбƳӦĴ
+    // 붩ͬڸбƳԭ滻ڽеķԻһαƳĴ
+    // һĿջ첽ͷź
+    // ضǷ
+    bool operator-=(HandlerId id) {
         std::lock_guard<std::mutex> lock(mtx);
-        // Ӧʵ־ĲҺƳ߼ǰֻռλ
+        const HandlerList& current = *handlers.load();
+        auto matches = [id](const HandlerEntry& entry) { return entry.id == id; };
+        if (std::none_of(current.begin(), current.end(), matches)) return false;
+        Update([&](HandlerList& list) { list.erase(std::remove_if(list.begin(), list.end(), matches), list.end()); });
         return true;
     }
 
     // 첽¼ʹִָexec첽ִѶĵĴ
-    // execһִ첽ִд
+    // execһִ첽ִдֱӴWorkStealingPool
+    // ִ֧exec(task, options)ʱĵȼʱ޵ȣֻȼ˳ύ
     // argsǴݸĲֵ
-    // ֤ͨڶ̻߳·handlers̰߳ȫ
-    // ȴhandlersıظʹִ첽ִд
+    // ڿͷźſִУύִдĹ
     template<typename Executor>
     void Async(Executor&& exec, Args... args) const {
-        std::lock_guard<std::mutex> lock(mtx);
-        auto localHandlers = handlers;
-        lock.unlock();
-
-        for (const auto& h : localHandlers) {
-            exec([=] { h(args...); });
+        auto guard = reclaimer.Pin();
+        for (const auto& entry : *handlers.load()) {
+            SubmitWithOptions(exec, [handler = entry.handler, args...] { (*handler)(args...); }, entry.options);
         }
     }
 };
 
+// std::function洢¼
+template<typename... Args>
+using ThreadSafeEventNormal = BasicThreadSafeEventNormal<std::function<void(Args...)>, Args...>;
+
 //// ʾ1÷
 //void BasicUsage() {
 //    ThreadSafeEventNormal<int> intEvent;
@@ -86,8 +144,9 @@ public:
 //    // Received (lambda): 42
 //    // Received (functor): 84
 //
-//// ȡģҪʵoperator-=
-//// intEvent -= Printer();
+//// ȡģʹöʱصıţ
+//// auto id = intEvent += Printer();
+//// intEvent -= id;
 //}
 //
 //// ʾ2̰߳ȫ֤
@@ -1,78 +1,169 @@
 #pragma once
+#include <atomic>
+#include <cstdint>
+#include <deque>
 #include <functional>
 #include <vector>
 #include <mutex>
-#include <algorithm>
-#include <memory>
+#include <optional>
+#include <set>
+#include <utility>
+#include "ChunkedArray.hpp"
+#include "DispatchPriority.hpp"
+#include "EpochReclaimer.hpp"
 
 /**
  * ̰߳ȫ¼ķϵͳ
- * ֧͵¼ʹָΪ
- * ṩ̰߳ȫĶġȡĺ¼
+ * ֧͵¼ĴڲλУԴľʶȡΪ O(1)
+ * ¼лλ̶ַ߽Ķٽ󰴲λ״̬ȡ
+ * ߳̿ͬʱпԶġȡĻٴηͬһ¼
+ * ÿηֻ÷ʼǰɵĶģŽضϣڼĶĴһηʼЧ
+ * ڼ䱻ȡĶٱáȡĲλۼԪȴ
+ * ܶķ߶뿪֮Ķı򷢲ͷŴòλصзͬʱС
+ * ĿɴȼڶȼʱȼӸߵͷֵãͬһȼڰλ˳
+ * @tparam THandler Ĵ洢ͣΪ std::function ֻƶ InplaceFunction
  */
-template<typename... Args>
-class SubscribeEvent {
-    // ڲʵֽṹ
-    struct SubscriptionImpl {
-        std::function<void(Args...)> handler; // ¼
-        std::shared_ptr<void> token;          // Ψһʶĵָ
-    };
+template<typename THandler, typename... Args>
+class BasicSubscribeEvent {
+    // λ״̬
+    static constexpr uint32_t FreeSlot = 0;    // Уɸ
+    static constexpr uint32_t ActiveSlot = 1;  // Ѷ
+    static constexpr uint32_t RemovedSlot = 2; // ȡȴ˳ͷ
 
-    mutable std::mutex mtx;                   // бĻ
-    std::vector<SubscriptionImpl> subscriptions; // б
+    // Ĳλ
+    struct Slot {
+        std::atomic<uint32_t> state{ FreeSlot }; // λ״̬߰жǷ
+        std::atomic<uint64_t> sequence{ 0 };     // ʱĶţڷʼĶ
+        uint32_t generation = 0;                 // λĸôܻ
+        DispatchPriority priority = DispatchPriority::Normal; // ȼֻ״̬ΪѶʱ߶ȡ
+        std::optional<THandler> handler;         // ¼ֻ״̬ΪѶʱ߶ȡ
+    };
 
 public:
-    using Subscription = std::shared_ptr<void>;  // Ͷ
+    /**
+     * ľλúɾʧЧ
+     */
+    struct Subscription {
+        uint32_t index = UINT32_MAX; // λ
+        uint32_t generation = 0;     // ʱλĴ
+
+        explicit operator bool() const {
+            return index != UINT32_MAX;
+        }
+    };
+
+    BasicSubscribeEvent() = default;
+    BasicSubscribeEvent(const BasicSubscribeEvent&) = delete;
+    BasicSubscribeEvent& operator=(const BasicSubscribeEvent&) = delete;
 
     /**
      * ¼
      * @param handler ¼ʱõĴ
-     * @return ΨһĶƣȡ
+     * @param priority ȼʱȼĴڵȼĵ
+     * @return ľȡ
      *
-     * ̰߳ȫʹûб
+     * ȸñСͷŲλĸλڼĶĶһηʼЧ
      */
-    Subscription subscribe(const std::function<void(Args...)>& handler) {
+    Subscription subscribe(THandler handler, DispatchPriority priority = DispatchPriority::Normal) {
         std::lock_guard lock(mtx);
-        // ΨһĹָΪ
-        auto token = std::make_shared<void>();
-        // ӵб
-        subscriptions.push_back({ handler, token });
-        return token;
+        ReleaseRetiredLocked();
+        uint32_t index;
+        if (!freeSlots.empty()) {
+            index = *freeSlots.begin();
+            freeSlots.erase(freeSlots.begin());
+        }
+        else {
+            index = slotCount.load(std::memory_order_relaxed);
+            slots.Ensure(index);
+        }
+        Slot& slot = slots[index];
+        slot.handler.emplace(std::move(handler));
+        slot.priority = priority;
+        const uint64_t sequence = subscribeSequence.load(std::memory_order_relaxed) + 1;
+        slot.sequence.store(sequence, std::memory_order_relaxed);
+        if (priorityCounts[static_cast<size_t>(priority)]++ == 0) {
+            activePriorities.store(activePriorities.load(std::memory_order_relaxed) | (1u << static_cast<uint32_t>(priority)));
+        }
+        slot.state.store(ActiveSlot, std::memory_order_release);
+        if (index >= slotCount.load(std::memory_order_relaxed)) slotCount.store(index + 1, std::memory_order_release);
+        // д룺߶СʱһҲܿλѼ
+        subscribeSequence.store(sequence, std::memory_order_release);
+        return Subscription{ index, slot.generation };
     }
 
     /**
      * ȡ
-     * @param token ʱص
+     * @param subscription ʱصľ
+     * @return ǷȻЧ
      *
-     * ̰߳ȫʹûб
+     * λۼԪͷŶУпܶķ뿪òλ
      */
-    void unsubscribe(const Subscription& token) {
+    bool unsubscribe(const Subscription& subscription) {
         std::lock_guard lock(mtx);
-        // ʹerase-remove÷ƳƥĶ
-        subscriptions.erase(
-            std::remove_if(subscriptions.begin(), subscriptions.end(),
-                [&](const SubscriptionImpl& sub) {
-                    return sub.token == token;
-                }),
-            subscriptions.end());
+        if (subscription.index >= slotCount.load(std::memory_order_relaxed)) return false;
+        Slot& slot = slots[subscription.index];
+        if (slot.generation != subscription.generation || slot.state.load(std::memory_order_relaxed) != ActiveSlot) {
+            return false;
+        }
+        ++slot.generation;
+        if (--priorityCounts[static_cast<size_t>(slot.priority)] == 0) {
+            activePriorities.store(activePriorities.load(std::memory_order_relaxed) & ~(1u << static_cast<uint32_t>(slot.priority)));
+        }
+        // ȱȡƽԪ֮ٽķ߶ܿȡ
+        slot.state.store(RemovedSlot);
+        retiredSlots.emplace_back(reclaimer.Advance(), subscription.index);
+        hasRetired.store(true, std::memory_order_relaxed);
+        ReleaseRetiredLocked();
+        return true;
     }
 
     /**
      * ¼жĵĴ
-     * @param args ݸĲ֧ת
+     * @param args ݸĲֵֵÿ
      *
-     * ̰߳ȫʹûб
+     * лпԶġȡĻٴη
      * 쳣ȫ쳣Ӱ
      */
-    void operator()(Args&&... args) const {
-        std::lock_guard lock(mtx);
-        // жĲô
-        for (auto& sub : subscriptions) {
+    void operator()(Args... args) const {
+        {
+            auto guard = reclaimer.Pin();
+            const uint64_t sequence = subscribeSequence.load(std::memory_order_acquire);
+            const uint32_t count = slotCount.load(std::memory_order_acquire);
+            const uint32_t priorities = activePriorities.load(std::memory_order_relaxed);
+            if ((priorities & (priorities - 1)) == 0) {
+                // ֻһȼʱ
+                InvokeSlots<false>(count, sequence, DispatchPriority::Normal, args...);
+            }
+            else {
+                for (uint32_t priority = 0; priority < DispatchPriorityCount; ++priority) {
+                    if (priorities & (1u << priority)) InvokeSlots<true>(count, sequence, static_cast<DispatchPriority>(priority), args...);
+                }
+            }
+        }
+        // 뿪ٽ˳ͷ޷߿ɼĲλռʱĶı֮ķ
+        if (hasRetired.load(std::memory_order_relaxed)) {
+            std::unique_lock lock(mtx, std::try_to_lock);
+            if (lock.owns_lock()) ReleaseRetiredLocked();
+        }
+    }
+
+private:
+    /**
+     * ε÷ʼǰѶĵĴ
+     * @tparam FilterPriority ǷָֻȼĴ
+     * @param sequence ʼʱĶţĲλβ
+     */
+    template<bool FilterPriority>
+    void InvokeSlots(uint32_t count, uint64_t sequence, DispatchPriority priority, Args&... args) const {
+        for (uint32_t i = 0; i < count; ++i) {
+            Slot& slot = slots[i];
+            if (slot.state.load() != ActiveSlot) continue;
+            if (slot.sequence.load(std::memory_order_relaxed) > sequence) continue;
+            if (FilterPriority && slot.priority != priority) continue;
             try {
-                // תֲֵֵ/ֵ
-                sub.handler(std::forward<Args>(args)...);
+                (*slot.handler)(args...);
             }
-            catch (const std::exception& e) {
+            catch (const std::exception&) {
                 // ֪쳣ɸչ
             }
             catch (...) {
@@ -80,12 +171,53 @@ public:
             }
         }
     }
+
+    /**
+     * ۼԪѰȫĲλеĴ黹λл
+     * ۼԪȡ˳һԿܱ߶ȡĲλֹͣ
+     * ĩβĿвλ漴Ƴɨ跶Χ߱ռڼѹĲλͷź󣬷Ŀ֮
+     */
+    void ReleaseRetiredLocked() const {
+        if (retiredSlots.empty()) return;
+        const uint64_t safeEpoch = reclaimer.SafeEpoch();
+        while (!retiredSlots.empty() && retiredSlots.front().first <= safeEpoch) {
+            Slot& slot = slots[retiredSlots.front().second];
+            slot.handler.reset();
+            slot.state.store(FreeSlot, std::memory_order_relaxed);
+            freeSlots.insert(retiredSlots.front().second);
+            retiredSlots.pop_front();
+        }
+        hasRetired.store(!retiredSlots.empty(), std::memory_order_relaxed);
+        uint32_t count = slotCount.load(std::memory_order_relaxed);
+        while (!freeSlots.empty() && *freeSlots.rbegin() == count - 1) {
+            freeSlots.erase(std::prev(freeSlots.end()));
+            --count;
+        }
+        slotCount.store(count, std::memory_order_release);
+    }
+
+    mutable std::mutex mtx;                          // ġȡλ
+    mutable ChunkedArray<Slot, 4> slots;             // Ĳλ̶ַ
+    mutable std::atomic<uint32_t> slotCount{ 0 };    // ɨ跶Χķǿвλżһ
+    std::atomic<uint64_t> subscribeSequence{ 0 };    // һζĵţʼʱȡΪضϵ
+    mutable std::set<uint32_t> freeSlots;            // ɸõĲλԱջĩβĿвλ
+    mutable std::deque<std::pair<uint64_t, uint32_t>> retiredSlots; // ȡȴ뿪ĲλۼԪ
+    mutable std::atomic<bool> hasRetired{ false };   // ǷеȴͷŵĲλ
+    mutable EpochReclaimer reclaimer;                // ߵĶٽж۲λʱٿɼ
+    uint32_t priorityCounts[DispatchPriorityCount]{}; // ȼЧܻ
+    std::atomic<uint32_t> activePriorities{ 0 };      // жĵȼλͼʱݴ˾Ƿ
 };
 
+/**
+ *  std::function 洢¼ķϵͳ
+ */
+template<typename... Args>
+using SubscribeEvent = BasicSubscribeEvent<std::function<void(Args...)>, Args...>;
+
 //// ¼󣨽intstring
 //SubscribeEvent<int, std::string> logger;
 //
-//// ¼ضƣ
+//// ¼ضľ
 //auto sub1 = logger.subscribe([](int code, const std::string& msg) {
 //    std::cout << "[Log1] Code: " << code << ", Msg: " << msg << std::endl;
 //    });
@@ -94,7 +226,7 @@ public:
 //    std::cout << "[Log2] Code: " << code << ", Msg: " << std::move(msg) << std::endl;
 //    });
 //
-//// ¼ᱻת
+//// ¼ֵ룩
 //logger(200, "Request successful");
 //
 //// ȡڶ
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include "EpochReclaimer.hpp"
+#include "NumaTopology.hpp"
+
+/**
+ * Ѱַ̽⣩ĹϣѼĹϣӳ䵽ⲿ洢еĲλ
+ * ÿͰһԭ֣32λϣ + λżһ8ֽڣɵ÷ţȽʱͨصʣ
+ * ̻̽ĻڡɾʹλĹ
+ * дɵ÷⣻Find д÷账 EpochReclaimer ٽڣ
+ * ҿݻɾλ©飬᷵شĲλ©ʱ÷Ӧز
+ */
+class FlatHashIndex {
+    /**
+     * Ͱ飺ͰֵΪ 0 ʾգ32λΪϣ32λΪλżһ
+     */
+    struct Table {
+        Table(size_t capacity, int node) : mask(capacity - 1), node(node) {
+            if (node < 0) {
+                buckets = new std::atomic<uint64_t>[capacity]();
+                return;
+            }
+            buckets = static_cast<std::atomic<uint64_t>*>(
+                NumaTopology::Allocate(capacity * sizeof(std::atomic<uint64_t>), node));
+            std::uninitialized_value_construct_n(buckets, capacity);
+        }
+        Table(const Table&) = delete;
+        Table& operator=(const Table&) = delete;
+        ~Table() {
+            if (node < 0) delete[] buckets;
+            else NumaTopology::Free(buckets, (mask + 1) * sizeof(std::atomic<uint64_t>));
+        }
+        size_t mask;
+        int node;                          // Ͱڵ NUMA ڵ㣬-1 ʾĬϷ
+        std::atomic<uint64_t>* buckets;
+    };
+
+public:
+    FlatHashIndex() = default;
+    FlatHashIndex(const FlatHashIndex&) = delete;
+    FlatHashIndex& operator=(const FlatHashIndex&) = delete;
+
+    ~FlatHashIndex() {
+        delete _table.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * ݺͰĻδʱͰͷţʱ
+     * @param reclaimer Ԫ
+     */
+    void SetReclaimer(EpochReclaimer* reclaimer) {
+        _reclaimer = reclaimer;
+    }
+
+    /**
+     * ô˺½Ͱڵ NUMA ڵ㣬ɵ÷д⣻Ͱ´ݻ Relocate ʱǨ
+     * @param node ڵţ-1 ʾʹĬϷ
+     */
+    void SetNode(int node) {
+        _node = node;
+    }
+
+    /**
+     * ǰ SetNode ָĽڵؽͰ飬ɵ÷д⣬Ҳ
+     */
+    void Relocate() {
+        const Table* table = _table.load(std::memory_order_relaxed);
+        if (table && table->node != _node) Rehash(table->mask + 1);
+    }
+
+    /**
+     * ϣѹΪʹõ32λϣ
+     */
+    static uint32_t Fold(size_t hash) {
+        const uint64_t h = static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ull;
+        return static_cast<uint32_t>(h >> 32);
+    }
+
+    /**
+     * Ҳλ
+     * @param hash Fold Ĺϣ
+     * @param equals  bool(uint32_t slot) ĻصжϲλеļǷΪĿ
+     * @param slot ڴ洢
+     * @return Ƿҵ
+     */
+    template<typename Equals>
+    bool Find(uint32_t hash, Equals&& equals, uint32_t& slot) const {
+        const Table* table = _table.load(std::memory_order_acquire);
+        if (!table) return false;
+        for (size_t i = hash & table->mask;; i = (i + 1) & table->mask) {
+            const uint64_t bucket = table->buckets[i].load(std::memory_order_acquire);
+            if (bucket == 0) return false;
+            if (static_cast<uint32_t>(bucket >> 32) == hash) {
+                const uint32_t candidate = static_cast<uint32_t>(bucket) - 1;
+                if (equals(candidate)) {
+                    slot = candidate;
+                    return true;
+                }
+            }
+        }
+    }
+
+    /**
+     * һλ÷豣֤вڣҲλеļд
+     * @param hash Fold Ĺϣ
+     * @param slot λ
+     */
+    void Insert(uint32_t hash, uint32_t slot) {
+        const Table* table = _table.load(std::memory_order_relaxed);
+        if (!table || (_size + 1) * 4 > (table->mask + 1) * 3) {
+            Rehash(table ? (table->mask + 1) * 2 : 16);
+        }
+        Place(*_table.load(std::memory_order_relaxed), hash, slot);
+        ++_size;
+    }
+
+    /**
+     * ɾӦͰͬصͰǰλԱ̽
+     * @param hash Fold Ĺϣ
+     * @param equals жϲλеļǷΪĿĻص
+     * @return Ƿɾ
+     */
+    template<typename Equals>
+    bool Erase(uint32_t hash, Equals&& equals) {
+        Table* table = _table.load(std::memory_order_relaxed);
+        if (!table) return false;
+        const size_t mask = table->mask;
+        auto& buckets = table->buckets;
+        size_t i = hash & mask;
+        while (true) {
+            const uint64_t bucket = buckets[i].load(std::memory_order_relaxed);
+            if (bucket == 0) return false;
+            if (static_cast<uint32_t>(bucket >> 32) == hash && equals(static_cast<uint32_t>(bucket) - 1)) break;
+            i = (i + 1) & mask;
+        }
+
+        size_t hole = i;
+        for (size_t j = (hole + 1) & mask;; j = (j + 1) & mask) {
+            const uint64_t bucket = buckets[j].load(std::memory_order_relaxed);
+            if (bucket == 0) break;
+            const size_t home = static_cast<uint32_t>(bucket >> 32) & mask;
+            // Ͱ j λò (hole, j] ʱն
+            const bool movable = hole <= j ? (home <= hole || home > j) : (home <= hole && home > j);
+            if (movable) {
+                buckets[hole].store(bucket, std::memory_order_release);
+                hole = j;
+            }
+        }
+        buckets[hole].store(0, std::memory_order_release);
+        --_size;
+        return true;
+    }
+
+    /**
+     * Ԥз
+     * @param count ԤԪ
+     */
+    void Reserve(size_t count) {
+        const Table* table = _table.load(std::memory_order_relaxed);
+        const size_t current = table ? table->mask + 1 : 0;
+        size_t capacity = current ? current : 16;
+        while (count * 4 > capacity * 3) capacity <<= 1;
+        if (capacity != current) Rehash(capacity);
+    }
+
+    /**
+     * ȡԪ
+     */
+    size_t Size() const {
+        return _size;
+    }
+
+    /**
+     * ȡռõֽ
+     */
+    size_t MemoryBytes() const {
+        const Table* table = _table.load(std::memory_order_relaxed);
+        return table ? (table->mask + 1) * sizeof(uint64_t) : 0;
+    }
+
+private:
+    /**
+     * Ͱ鲢Ͱ齻ڲҵĶԿɰȫ
+     */
+    void Rehash(size_t capacity) {
+        Table* old = _table.load(std::memory_order_relaxed);
+        Table* table = new Table(capacity, _node);
+        if (old) {
+            for (size_t i = 0; i <= old->mask; ++i) {
+                const uint64_t bucket = old->buckets[i].load(std::memory_order_relaxed);
+                if (bucket != 0) Place(*table, static_cast<uint32_t>(bucket >> 32), static_cast<uint32_t>(bucket) - 1);
+            }
+        }
+        _table.store(table);
+        if (!old) return;
+        if (_reclaimer) _reclaimer->Retire(old);
+        else delete old;
+    }
+
+    static void Place(Table& table, uint32_t hash, uint32_t slot) {
+        size_t i = hash & table.mask;
+        while (table.buckets[i].load(std::memory_order_relaxed) != 0) i = (i + 1) & table.mask;
+        table.buckets[i].store((uint64_t(hash) << 32) | (uint64_t(slot) + 1), std::memory_order_release);
+    }
+
+    std::atomic<Table*> _table{ nullptr };   // ǰͰ飬Ϊ2
+    size_t _size = 0;                        // Ԫ
+    EpochReclaimer* _reclaimer = nullptr;    // Ͱ
+    int _node = -1;                          // ½Ͱڵ NUMA ڵ
+};
@@ -0,0 +1,681 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "BinaryCodec.hpp"
+#include "BlockCompressor.hpp"
+#include "MappedFile.hpp"
+
+/**
+ * ״̬ʷ鵵дѡ
+ */
+struct HistoryArchiveOptions {
+    size_t blockRows = 65536; // ÿݿд
+    bool compress = true;     // ǷԸ LZ ѹѹ󲻸Саԭţ
+};
+
+/**
+ * ״̬ʷ鵵ļʽ
+ * ļ8ֽħͷ֡[u32 س][u32 У][]ֽΪ֡͡
+ * ״̬ԭһֵֻ䣬Ŀֵ֡д״ǵݿ֮ǰ
+ * ݿ鰴дһתʱΪһ֮ zigzag 䳤Դ״̬Ŀ״̬ԭΪֵŵı䳤
+ * ÿеѹɨʱֻõСͷ¼ʱ䷶Χͼŵλͼʱɨʱ
+ */
+namespace HistoryArchiveFormat {
+    constexpr char Magic[8] = { 'S', 'M', 'H', 'I', 'S', 'T', '0', '1' };
+    constexpr size_t FrameHeaderSize = 8;
+
+    // ֡
+    constexpr uint8_t KeyDictionary = 1;    // ֵ䣺[u32 ׸][u32 ][...]
+    constexpr uint8_t StateDictionary = 2;  // ״ֵ̬䣬ʽͬ
+    constexpr uint8_t ReasonDictionary = 3; // ԭֵ䣬ʽͬ
+    constexpr uint8_t Block = 4;            // ݿ
+    constexpr uint8_t Gap = 5;              // ȱڣ[u64 ʧת]
+
+    // ݿ
+    constexpr size_t TimeColumn = 0;
+    constexpr size_t KeyColumn = 1;
+    constexpr size_t FromColumn = 2;
+    constexpr size_t ToColumn = 3;
+    constexpr size_t ReasonColumn = 4;
+    constexpr size_t ColumnCount = 5;
+
+    constexpr size_t FilterWords = 4; // 64λ256λ
+
+    /**
+     * ݿͷ֮Ǹе [u32 ԭʼֽ][u32 洢ֽ][u8 Ƿѹ][]
+     */
+    struct BlockHeader {
+        uint32_t rows;                   // 
+        int64_t minTime;                 // ʱ
+        int64_t maxTime;                 // ʱ
+        int64_t firstTime;               // ʱʱеĲֵӴ˿ʼ
+        uint64_t keyFilter[FilterWords]; // ŵλͼ
+    };
+
+    /**
+     * 8ֽһУͣʶдһβֽ֡ڵ FNV 
+     */
+    inline uint32_t Checksum(const char* data, size_t size) {
+        uint64_t hash = 0xCBF29CE484222325ull ^ size;
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8) {
+            uint64_t word;
+            std::memcpy(&word, data + i, sizeof(word));
+            hash = (hash ^ word) * 0x100000001B3ull;
+            hash ^= hash >> 29;
+        }
+        for (; i < size; ++i) hash = (hash ^ static_cast<uint8_t>(data[i])) * 0x100000001B3ull;
+        return static_cast<uint32_t>(hash ^ (hash >> 32));
+    }
+
+    /**
+     * ڹеλ
+     */
+    inline uint32_t FilterBit(uint32_t keyId) {
+        return (keyId * 2654435761u) >> 24;
+    }
+
+    inline uint64_t ZigZag(int64_t value) {
+        return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    }
+
+    inline int64_t UnZigZag(uint64_t value) {
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    inline void PutVarint(std::string& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    /**
+     * ȡһ䳤÷֤ı䳤β
+     */
+    inline uint64_t GetVarint(const uint8_t*& p) {
+        uint64_t value = *p++;
+        if (value < 0x80) return value;
+        value &= 0x7F;
+        for (uint32_t shift = 7;; shift += 7) {
+            const uint64_t byte = *p++;
+            value |= (byte & 0x7F) << shift;
+            if (byte < 0x80) return value;
+        }
+    }
+
+    /**
+     * һб䳤ǡð rows ֵ֮ GetVarint ɲټ߽
+     */
+    inline bool ValidateVarints(const char* data, size_t size, uint32_t rows) {
+        uint64_t terminators = 0;
+        for (size_t i = 0; i < size; ++i) terminators += static_cast<uint8_t>(data[i]) < 0x80;
+        return terminators == rows && (size == 0 || static_cast<uint8_t>(data[size - 1]) < 0x80);
+    }
+
+    /**
+     * Ϊ֡ͷ׷ӵ
+     */
+    inline void AppendFrame(std::string& out, const std::string& payload) {
+        BinaryCodec<uint32_t>::Write(out, static_cast<uint32_t>(payload.size()));
+        BinaryCodec<uint32_t>::Write(out, Checksum(payload.data(), payload.size()));
+        out.append(payload);
+    }
+
+    /**
+     * λصļеÿ֡дһУʧֹܵ֡ͣ
+     * @param callback  bool(uint8_t type, const char* payload, const char* end) Ļص false ʱֹͣ
+     * @return ֡ħռֽ
+     */
+    template<typename Callback>
+    size_t ForEachFrame(const char* data, size_t size, Callback&& callback) {
+        if (size < sizeof(Magic) || std::memcmp(data, Magic, sizeof(Magic)) != 0) return 0;
+        const char* p = data + sizeof(Magic);
+        const char* end = data + size;
+        size_t valid = sizeof(Magic);
+        while (static_cast<size_t>(end - p) >= FrameHeaderSize) {
+            uint32_t length = 0, checksum = 0;
+            BinaryCodec<uint32_t>::Read(p, end, length);
+            BinaryCodec<uint32_t>::Read(p, end, checksum);
+            if (length == 0 || static_cast<size_t>(end - p) < length || Checksum(p, length) != checksum) break;
+            const uint8_t type = static_cast<uint8_t>(*p);
+            if (!callback(type, p + 1, p + length)) break;
+            p += length;
+            valid = static_cast<size_t>(p - data);
+        }
+        return valid;
+    }
+
+    /**
+     * ֵ֡Ŀд valuesűĿν
+     */
+    template<typename T>
+    bool ReadDictionary(const char* p, const char* end, std::vector<T>& values) {
+        uint32_t first = 0, count = 0;
+        if (!BinaryCodec<uint32_t>::Read(p, end, first) || !BinaryCodec<uint32_t>::Read(p, end, count)) return false;
+        if (first != values.size()) return false;
+        for (uint32_t i = 0; i < count; ++i) {
+            T value{};
+            if (!BinaryCodec<T>::Read(p, end, value)) return false;
+            values.push_back(std::move(value));
+        }
+        return true;
+    }
+}
+
+/**
+ * ״̬ʷ鵵дˣ׷ӵļѴڵĹ鵵ڽص𻵵β׷
+ * ̰߳ȫģͨɵ鵵߳ʹ
+ * @tparam TKey ͣɹϣ֧ BinaryCodec
+ * @tparam TState ״̬ͣɹϣ֧ BinaryCodec
+ */
+template<typename TKey, typename TState>
+class HistoryArchiveWriter {
+public:
+    /**
+     * 򿪣򴴽鵵ļ
+     * @param path 鵵ļ·
+     * @param options дѡ
+     */
+    HistoryArchiveWriter(const std::string& path, const HistoryArchiveOptions& options = HistoryArchiveOptions())
+        : _path(path), _options(options) {
+        if (_options.blockRows == 0) _options.blockRows = 1;
+        size_t valid = 0;
+        if (std::filesystem::exists(path) && std::filesystem::file_size(path) > 0) valid = LoadExisting(path);
+        if (valid == 0) {
+            _file.open(path, std::ios::binary | std::ios::trunc);
+            _file.write(HistoryArchiveFormat::Magic, sizeof(HistoryArchiveFormat::Magic));
+        }
+        else {
+            std::filesystem::resize_file(path, valid);
+            _file.open(path, std::ios::binary | std::ios::app);
+        }
+        if (!_file) throw std::runtime_error("Failed to open history archive: " + path);
+    }
+
+    HistoryArchiveWriter(const HistoryArchiveWriter&) = delete;
+    HistoryArchiveWriter& operator=(const HistoryArchiveWriter&) = delete;
+
+    /**
+     * ʱдδݿ
+     */
+    ~HistoryArchiveWriter() {
+        try {
+            Flush();
+        }
+        catch (...) {}
+    }
+
+    /**
+     * ׷һ״̬ת
+     * @param key ״̬
+     * @param fromState Դ״̬
+     * @param toState Ŀ״̬
+     * @param timestamp תʱ䣨system_clock 
+     * @param reason תԭ
+     */
+    void Append(const TKey& key, const TState& fromState, const TState& toState, int64_t timestamp,
+        const std::string& reason) {
+        _times.push_back(timestamp);
+        _keys.push_back(Intern(_keyIds, _newKeys, key));
+        _froms.push_back(Intern(_stateIds, _newStates, fromState));
+        _tos.push_back(Intern(_stateIds, _newStates, toState));
+        _reasons.push_back(Intern(_reasonIds, _newReasons, reason));
+        if (_times.size() >= _options.blockRows) WriteBlock();
+    }
+
+    /**
+     * ¼һȱڣԴʧתȡ˿ɾݴжʷǷ
+     */
+    void RecordGap(uint64_t dropped) {
+        if (dropped == 0) return;
+        WriteBlock();
+        std::string payload(1, static_cast<char>(HistoryArchiveFormat::Gap));
+        BinaryCodec<uint64_t>::Write(payload, dropped);
+        WriteFrame(payload);
+    }
+
+    /**
+     * дδݿ鲢ˢļ
+     */
+    void Flush() {
+        WriteBlock();
+        _file.flush();
+        if (!_file) throw std::runtime_error("Failed to write history archive: " + _path);
+    }
+
+    /**
+     * ȡдתǰеģ
+     */
+    uint64_t RowCount() const {
+        return _rowCount + _times.size();
+    }
+
+private:
+    /**
+     * ȡй鵵ֵ
+     * @return ֽ֡ļЧʱΪ 0
+     */
+    size_t LoadExisting(const std::string& path) {
+        using namespace HistoryArchiveFormat;
+        MappedFile file(path);
+        std::vector<TKey> keys;
+        std::vector<TState> states;
+        std::vector<std::string> reasons;
+        const size_t valid = ForEachFrame(file.Data(), file.Size(), [&](uint8_t type, const char* p, const char* end) {
+            switch (type) {
+            case KeyDictionary: return ReadDictionary(p, end, keys);
+            case StateDictionary: return ReadDictionary(p, end, states);
+            case ReasonDictionary: return ReadDictionary(p, end, reasons);
+            case Block: {
+                BlockHeader header;
+                if (static_cast<size_t>(end - p) < sizeof(header)) return false;
+                std::memcpy(&header, p, sizeof(header));
+                _rowCount += header.rows;
+                return true;
+            }
+            case Gap: return true;
+            default: return false;
+            }
+        });
+        for (uint32_t i = 0; i < keys.size(); ++i) _keyIds.emplace(std::move(keys[i]), i);
+        for (uint32_t i = 0; i < states.size(); ++i) _stateIds.emplace(std::move(states[i]), i);
+        for (uint32_t i = 0; i < reasons.size(); ++i) _reasonIds.emplace(std::move(reasons[i]), i);
+        return valid;
+    }
+
+    template<typename T>
+    static uint32_t Intern(std::unordered_map<T, uint32_t>& ids, std::vector<T>& added, const T& value) {
+        auto it = ids.find(value);
+        if (it != ids.end()) return it->second;
+        const uint32_t id = static_cast<uint32_t>(ids.size());
+        ids.emplace(value, id);
+        added.push_back(value);
+        return id;
+    }
+
+    /**
+     * дһֵ֡ϴдĿ
+     */
+    template<typename T>
+    void WriteDictionary(uint8_t type, const std::unordered_map<T, uint32_t>& ids, std::vector<T>& added) {
+        if (added.empty()) return;
+        std::string payload(1, static_cast<char>(type));
+        BinaryCodec<uint32_t>::Write(payload, static_cast<uint32_t>(ids.size() - added.size()));
+        BinaryCodec<uint32_t>::Write(payload, static_cast<uint32_t>(added.size()));
+        for (const auto& value : added) BinaryCodec<T>::Write(payload, value);
+        WriteFrame(payload);
+        added.clear();
+    }
+
+    /**
+     * ѻбΪһݿ飬ͬõֵĿһд
+     */
+    void WriteBlock() {
+        using namespace HistoryArchiveFormat;
+        if (_times.empty()) return;
+        WriteDictionary(KeyDictionary, _keyIds, _newKeys);
+        WriteDictionary(StateDictionary, _stateIds, _newStates);
+        WriteDictionary(ReasonDictionary, _reasonIds, _newReasons);
+
+        BlockHeader header{};
+        header.rows = static_cast<uint32_t>(_times.size());
+        header.firstTime = _times.front();
+        header.minTime = *std::min_element(_times.begin(), _times.end());
+        header.maxTime = *std::max_element(_times.begin(), _times.end());
+
+        std::string columns[ColumnCount];
+        int64_t previous = header.firstTime;
+        for (size_t i = 0; i < _times.size(); ++i) {
+            PutVarint(columns[TimeColumn], ZigZag(_times[i] - previous));
+            previous = _times[i];
+            PutVarint(columns[KeyColumn], _keys[i]);
+            PutVarint(columns[FromColumn], _froms[i]);
+            PutVarint(columns[ToColumn], _tos[i]);
+            PutVarint(columns[ReasonColumn], _reasons[i]);
+            const uint32_t bit = FilterBit(_keys[i]);
+            header.keyFilter[bit / 64] |= uint64_t(1) << (bit % 64);
+        }
+
+        std::string payload(1, static_cast<char>(Block));
+        payload.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        std::string compressed;
+        for (const auto& column : columns) {
+            compressed.clear();
+            if (_options.compress) BlockCompressor::Compress(column.data(), column.size(), compressed);
+            const bool useCompressed = _options.compress && compressed.size() < column.size();
+            const std::string& stored = useCompressed ? compressed : column;
+            BinaryCodec<uint32_t>::Write(payload, static_cast<uint32_t>(column.size()));
+            BinaryCodec<uint32_t>::Write(payload, static_cast<uint32_t>(stored.size()));
+            BinaryCodec<uint8_t>::Write(payload, useCompressed ? 1 : 0);
+            payload.append(stored);
+        }
+        WriteFrame(payload);
+
+        _rowCount += _times.size();
+        _times.clear();
+        _keys.clear();
+        _froms.clear();
+        _tos.clear();
+        _reasons.clear();
+    }
+
+    void WriteFrame(const std::string& payload) {
+        _frame.clear();
+        HistoryArchiveFormat::AppendFrame(_frame, payload);
+        _file.write(_frame.data(), static_cast<std::streamsize>(_frame.size()));
+        if (!_file) throw std::runtime_error("Failed to write history archive: " + _path);
+    }
+
+    std::string _path;              // 鵵ļ·
+    HistoryArchiveOptions _options; // дѡ
+    std::ofstream _file;            // 鵵ļ
+    std::string _frame;             // ֡뻺
+    uint64_t _rowCount = 0;         // дݿ
+
+    std::unordered_map<TKey, uint32_t> _keyIds;          // ֵ
+    std::unordered_map<TState, uint32_t> _stateIds;      // ״ֵ̬
+    std::unordered_map<std::string, uint32_t> _reasonIds; // ԭֵ
+    std::vector<TKey> _newKeys;          // δдļֵĿ
+    std::vector<TState> _newStates;      // δд״ֵ̬Ŀ
+    std::vector<std::string> _newReasons; // δдԭֵĿ
+
+    // ǰݿĸ
+    std::vector<int64_t> _times;
+    std::vector<uint32_t> _keys;
+    std::vector<uint32_t> _froms;
+    std::vector<uint32_t> _tos;
+    std::vector<uint32_t> _reasons;
+};
+
+/**
+ * ߻ܵת
+ */
+template<typename TState>
+struct ArchivedEdgeCount {
+    TState fromState;   // Դ״̬
+    TState toState;     // Ŀ״̬
+    uint64_t count = 0; // ת
+};
+
+/**
+ * ״̬ʷ鵵Ķȡˣӳļʱֵֻͷɨʱݿõ
+ * ȡ˶̰߳ȫ
+ * @tparam TKey ͣдһ
+ * @tparam TState ״̬ͣдһ
+ */
+template<typename TKey, typename TState>
+class HistoryArchiveReader {
+    /**
+     * ݿеһ
+     */
+    struct ColumnRef {
+        const char* data;    // 洢
+        uint32_t rawSize;    // ԭʼֽ
+        uint32_t storedSize; // 洢ֽ
+        bool compressed;     // Ƿѹ
+    };
+
+    /**
+     * һݿ
+     */
+    struct BlockRef {
+        HistoryArchiveFormat::BlockHeader header;
+        ColumnRef columns[HistoryArchiveFormat::ColumnCount];
+    };
+
+public:
+    /**
+     * 򿪹鵵ļ
+     * @param path 鵵ļ·
+     */
+    explicit HistoryArchiveReader(const std::string& path) : _file(path) {
+        using namespace HistoryArchiveFormat;
+        if (_file.Size() < sizeof(Magic) || std::memcmp(_file.Data(), Magic, sizeof(Magic)) != 0) {
+            throw std::runtime_error("Invalid history archive: " + path);
+        }
+        ForEachFrame(_file.Data(), _file.Size(), [&](uint8_t type, const char* p, const char* end) {
+            switch (type) {
+            case KeyDictionary: return ReadDictionary(p, end, _keys);
+            case StateDictionary: return ReadDictionary(p, end, _states);
+            case ReasonDictionary: return ReadDictionary(p, end, _reasonTexts);
+            case Block: return ParseBlock(p, end);
+            case Gap: {
+                uint64_t dropped = 0;
+                if (!BinaryCodec<uint64_t>::Read(p, end, dropped)) return false;
+                _droppedCount += dropped;
+                return true;
+            }
+            default: return false;
+            }
+        });
+    }
+
+    /**
+     * ȡ鵵еת
+     */
+    uint64_t RowCount() const {
+        return _rowCount;
+    }
+
+    /**
+     * ȡд˼¼ȱжʧת
+     */
+    uint64_t DroppedCount() const {
+        return _droppedCount;
+    }
+
+    /**
+     * ȡݿ
+     */
+    size_t BlockCount() const {
+        return _blocks.size();
+    }
+
+    /**
+     * д˳صһȫʷͷüݿ鲻
+     * @param key ״̬
+     * @param callback  void(int64_t timestamp, const TState& from, const TState& to, const std::string& reason) Ļص
+     * @return صת
+     */
+    template<typename Callback>
+    size_t ScanKey(const TKey& key, Callback&& callback) {
+        using namespace HistoryArchiveFormat;
+        if (_keyIndex.size() != _keys.size()) {
+            _keyIndex.clear();
+            for (uint32_t i = 0; i < _keys.size(); ++i) _keyIndex.emplace(_keys[i], i);
+        }
+        auto it = _keyIndex.find(key);
+        if (it == _keyIndex.end()) return 0;
+        const uint32_t keyId = it->second;
+        const uint32_t bit = FilterBit(keyId);
+
+        size_t count = 0;
+        std::vector<uint32_t> rows;
+        for (const auto& block : _blocks) {
+            if (!(block.header.keyFilter[bit / 64] & (uint64_t(1) << (bit % 64)))) continue;
+            const uint8_t* p = Column(block, KeyColumn);
+            rows.clear();
+            for (uint32_t row = 0; row < block.header.rows; ++row) {
+                if (GetVarint(p) == keyId) rows.push_back(row);
+            }
+            if (rows.empty()) continue;
+
+            const uint8_t* times = Column(block, TimeColumn);
+            const uint8_t* froms = Column(block, FromColumn);
+            const uint8_t* tos = Column(block, ToColumn);
+            const uint8_t* reasons = Column(block, ReasonColumn);
+            int64_t time = block.header.firstTime;
+            size_t next = 0;
+            for (uint32_t row = 0; row < block.header.rows && next < rows.size(); ++row) {
+                time += UnZigZag(GetVarint(times));
+                const uint32_t from = static_cast<uint32_t>(GetVarint(froms));
+                const uint32_t to = static_cast<uint32_t>(GetVarint(tos));
+                const uint32_t reason = static_cast<uint32_t>(GetVarint(reasons));
+                if (row != rows[next]) continue;
+                ++next;
+                callback(time, StateAt(from), StateAt(to), ReasonAt(reason));
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    /**
+     * ʱ䷶ΧÿߵתȫڷΧڵݿֻԴĿ״̬
+     * @param fromTime ʼʱ䣨system_clock 
+     * @param toTime ʱ䣨
+     * @return ԴĿ״̬ĸߴ
+     */
+    std::vector<ArchivedEdgeCount<TState>> CountEdges(int64_t fromTime = std::numeric_limits<int64_t>::min(),
+        int64_t toTime = std::numeric_limits<int64_t>::max()) {
+        using namespace HistoryArchiveFormat;
+        // ״̬ͨ٣óܾÿһιϣ
+        const size_t stateCount = _states.size();
+        std::vector<uint64_t> counts(stateCount * stateCount);
+        for (const auto& block : _blocks) {
+            if (block.header.maxTime < fromTime || block.header.minTime > toTime) continue;
+            const uint8_t* froms = Column(block, FromColumn);
+            const uint8_t* tos = Column(block, ToColumn);
+            const bool whole = block.header.minTime >= fromTime && block.header.maxTime <= toTime;
+            const uint8_t* times = whole ? nullptr : Column(block, TimeColumn);
+            int64_t time = block.header.firstTime;
+            for (uint32_t row = 0; row < block.header.rows; ++row) {
+                const uint64_t from = GetVarint(froms);
+                const uint64_t to = GetVarint(tos);
+                if (!whole) {
+                    time += UnZigZag(GetVarint(times));
+                    if (time < fromTime || time > toTime) continue;
+                }
+                if (from < stateCount && to < stateCount) ++counts[from * stateCount + to];
+            }
+        }
+
+        std::vector<ArchivedEdgeCount<TState>> edges;
+        for (size_t i = 0; i < counts.size(); ++i) {
+            if (!counts[i]) continue;
+            ArchivedEdgeCount<TState> edge;
+            edge.fromState = _states[i / stateCount];
+            edge.toState = _states[i % stateCount];
+            edge.count = counts[i];
+            edges.push_back(std::move(edge));
+        }
+        return edges;
+    }
+
+    /**
+     * д˳صȫת
+     * @param callback  void(int64_t timestamp, const TKey& key, const TState& from, const TState& to, const std::string& reason) Ļص
+     * @return صת
+     */
+    template<typename Callback>
+    size_t ForEach(Callback&& callback) {
+        using namespace HistoryArchiveFormat;
+        size_t count = 0;
+        for (const auto& block : _blocks) {
+            const uint8_t* times = Column(block, TimeColumn);
+            const uint8_t* keys = Column(block, KeyColumn);
+            const uint8_t* froms = Column(block, FromColumn);
+            const uint8_t* tos = Column(block, ToColumn);
+            const uint8_t* reasons = Column(block, ReasonColumn);
+            int64_t time = block.header.firstTime;
+            for (uint32_t row = 0; row < block.header.rows; ++row) {
+                time += UnZigZag(GetVarint(times));
+                const uint32_t key = static_cast<uint32_t>(GetVarint(keys));
+                const uint32_t from = static_cast<uint32_t>(GetVarint(froms));
+                const uint32_t to = static_cast<uint32_t>(GetVarint(tos));
+                const uint32_t reason = static_cast<uint32_t>(GetVarint(reasons));
+                callback(time, KeyAt(key), StateAt(from), StateAt(to), ReasonAt(reason));
+                ++count;
+            }
+        }
+        return count;
+    }
+
+private:
+    /**
+     * ͷλãֻУĿż
+     */
+    bool ParseBlock(const char* p, const char* end) {
+        using namespace HistoryArchiveFormat;
+        BlockRef block;
+        if (static_cast<size_t>(end - p) < sizeof(block.header)) return false;
+        std::memcpy(&block.header, p, sizeof(block.header));
+        p += sizeof(block.header);
+        for (auto& column : block.columns) {
+            uint8_t compressed = 0;
+            if (!BinaryCodec<uint32_t>::Read(p, end, column.rawSize) ||
+                !BinaryCodec<uint32_t>::Read(p, end, column.storedSize) ||
+                !BinaryCodec<uint8_t>::Read(p, end, compressed) ||
+                static_cast<size_t>(end - p) < column.storedSize) return false;
+            column.data = p;
+            column.compressed = compressed != 0;
+            p += column.storedSize;
+        }
+        _rowCount += block.header.rows;
+        _blocks.push_back(block);
+        return true;
+    }
+
+    /**
+     * ȡһнݣδѹֱָӳļѹнѹеĻС
+     * 䳤ĸʱΪ𻵣׳쳣
+     */
+    const uint8_t* Column(const BlockRef& block, size_t index) {
+        const ColumnRef& column = block.columns[index];
+        const char* data = column.data;
+        if (!column.compressed) {
+            if (column.rawSize != column.storedSize) throw std::runtime_error("Corrupted history archive block");
+        }
+        else {
+            std::string& buffer = _columnBuffers[index];
+            buffer.resize(column.rawSize);
+            if (!BlockCompressor::Decompress(column.data, column.storedSize, &buffer[0], column.rawSize)) {
+                throw std::runtime_error("Corrupted history archive block");
+            }
+            data = buffer.data();
+        }
+        if (!HistoryArchiveFormat::ValidateVarints(data, column.rawSize, block.header.rows)) {
+            throw std::runtime_error("Corrupted history archive block");
+        }
+        return reinterpret_cast<const uint8_t*>(data);
+    }
+
+    const TKey& KeyAt(uint32_t id) const {
+        return id < _keys.size() ? _keys[id] : _unknownKey;
+    }
+
+    const TState& StateAt(uint32_t id) const {
+        return id < _states.size() ? _states[id] : _unknownState;
+    }
+
+    const std::string& ReasonAt(uint32_t id) const {
+        return id < _reasonTexts.size() ? _reasonTexts[id] : _unknownReason;
+    }
+
+    MappedFile _file;                       // ӳĹ鵵ļ
+    std::vector<TKey> _keys;                // ֵ
+    std::vector<TState> _states;            // ״ֵ̬
+    std::vector<std::string> _reasonTexts;  // ԭֵ
+    std::unordered_map<TKey, uint32_t> _keyIndex; // ţ״ΰɨʱ
+    std::vector<BlockRef> _blocks;          // ݿ
+    std::string _columnBuffers[HistoryArchiveFormat::ColumnCount]; // еĽ뻺
+    uint64_t _rowCount = 0;                 // ת
+    uint64_t _droppedCount = 0;             // ȱжʧת
+    TKey _unknownKey{};
+    TState _unknownState{};
+    std::string _unknownReason;
+};
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template<typename Signature, size_t Capacity = 32>
+class InplaceFunction;
+
+/**
+ * ֻƶڴĿɵöװ÷ std::function ͬ
+ * Ŀܷ洢С Capacity벻 max_align_tƶ첻쳣
+ * ʧܶ˻ضѷ䡣ֻһκָ룬
+ * εõĿ std::function ൱ͬΪһμӵãʡµǲ񳬳 std::function С󻺳ʱĶѷ䡣
+ * նĵָָ׳ std::bad_function_call ĺ·ûпշ֧
+ * ƽƵĿ꣨޲ָֻ롢 lambdaָ룩ƶʱֱӸƴ洢
+ * @tparam R 
+ * @tparam Args 
+ * @tparam Capacity 洢ֽ
+ */
+template<typename R, typename... Args, size_t Capacity>
+class InplaceFunction<R(Args...), Capacity> {
+    typedef R (*Invoker)(void*, Args&&...);
+    typedef void (*Manager)(void* destination, void* source); // source Ϊʱ destinationƶ
+
+    template<typename F>
+    static constexpr bool Fits = sizeof(F) <= Capacity && alignof(F) <= alignof(std::max_align_t)
+        && std::is_nothrow_move_constructible<F>::value;
+
+    template<typename F>
+    static constexpr bool Trivial = std::is_trivially_copyable<F>::value && std::is_trivially_destructible<F>::value;
+
+public:
+    InplaceFunction() noexcept = default;
+
+    InplaceFunction(std::nullptr_t) noexcept {}
+
+    /**
+     * װɵö󣻿յĺָõն
+     * @param callable ɰ R(Args...) õĶ
+     */
+    template<typename F, typename Target = std::decay_t<F>,
+        typename = std::enable_if_t<!std::is_same<Target, InplaceFunction>::value
+            && std::is_invocable_r<R, Target&, Args...>::value>>
+    InplaceFunction(F&& callable) {
+        static_assert(Fits<Target>, "Callable does not fit the inline storage of InplaceFunction");
+        if constexpr (std::is_pointer<Target>::value || std::is_member_pointer<Target>::value) {
+            if (callable == nullptr) return;
+        }
+        ::new (static_cast<void*>(_storage)) Target(std::forward<F>(callable));
+        _invoke = [](void* object, Args&&... args) -> R {
+            return std::invoke(*static_cast<Target*>(object), std::forward<Args>(args)...);
+        };
+        if constexpr (!Trivial<Target>) {
+            _manage = [](void* destination, void* source) {
+                if (source) ::new (destination) Target(std::move(*static_cast<Target*>(source)));
+                else static_cast<Target*>(destination)->~Target();
+            };
+        }
+    }
+
+    InplaceFunction(InplaceFunction&& other) noexcept {
+        MoveFrom(other);
+    }
+
+    InplaceFunction& operator=(InplaceFunction&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            MoveFrom(other);
+        }
+        return *this;
+    }
+
+    InplaceFunction& operator=(std::nullptr_t) noexcept {
+        Reset();
+        return *this;
+    }
+
+    template<typename F, typename = std::enable_if_t<!std::is_same<std::decay_t<F>, InplaceFunction>::value>>
+    InplaceFunction& operator=(F&& callable) {
+        return *this = InplaceFunction(std::forward<F>(callable));
+    }
+
+    InplaceFunction(const InplaceFunction&) = delete;
+    InplaceFunction& operator=(const InplaceFunction&) = delete;
+
+    ~InplaceFunction() {
+        Reset();
+    }
+
+    /**
+     * Ŀ std::function һconst Ҳ const Ŀ
+     */
+    R operator()(Args... args) const {
+        return _invoke(_storage, std::forward<Args>(args)...);
+    }
+
+    /**
+     * ǷװĿ
+     */
+    explicit operator bool() const noexcept {
+        return _invoke != &EmptyInvoke;
+    }
+
+    friend bool operator==(const InplaceFunction& function, std::nullptr_t) noexcept {
+        return !function;
+    }
+
+    friend bool operator!=(const InplaceFunction& function, std::nullptr_t) noexcept {
+        return static_cast<bool>(function);
+    }
+
+private:
+    static R EmptyInvoke(void*, Args&&...) {
+        throw std::bad_function_call();
+    }
+
+    void MoveFrom(InplaceFunction& other) noexcept {
+        if (other._manage) other._manage(_storage, other._storage);
+        else std::memcpy(_storage, other._storage, Capacity);
+        _invoke = other._invoke;
+        _manage = other._manage;
+        other.Reset();
+    }
+
+    void Reset() noexcept {
+        if (_manage) _manage(_storage, nullptr);
+        _invoke = &EmptyInvoke;
+        _manage = nullptr;
+    }
+
+    Invoker _invoke = &EmptyInvoke; // Ŀ
+    Manager _manage = nullptr;      // ƶĿ󣬿ƽƵĿΪ
+    alignas(std::max_align_t) mutable unsigned char _storage[Capacity]; // Ŀ洢
+};
+
+template<typename Signature>
+class FunctionRef;
+
+/**
+ * ӵĿĿɵãֻһָһָ룬ֵ
+ * ֻڵڼʹûصĲ÷豣֤Ŀʹڼ
+ * Ҫʱ lambda ʼ󱣴
+ * @tparam R 
+ * @tparam Args 
+ */
+template<typename R, typename... Args>
+class FunctionRef<R(Args...)> {
+public:
+    /**
+     * ÿɵö
+     * @param callable ɰ R(Args...) õĶ󣬲Ϊպָ
+     */
+    template<typename F, typename = std::enable_if_t<!std::is_same<std::decay_t<F>, FunctionRef>::value
+        && std::is_invocable_r<R, F&, Args...>::value>>
+    FunctionRef(F&& callable) noexcept {
+        if constexpr (std::is_function<std::remove_pointer_t<std::decay_t<F>>>::value) {
+            // ָָ֮䲻ֲܿת
+            _target.function = reinterpret_cast<void (*)()>(static_cast<std::decay_t<F>>(callable));
+            _invoke = [](Target target, Args&&... args) -> R {
+                return std::invoke(reinterpret_cast<std::decay_t<F>>(target.function), std::forward<Args>(args)...);
+            };
+        }
+        else {
+            _target.object = const_cast<void*>(static_cast<const void*>(std::addressof(callable)));
+            _invoke = [](Target target, Args&&... args) -> R {
+                return std::invoke(*static_cast<std::remove_reference_t<F>*>(target.object), std::forward<Args>(args)...);
+            };
+        }
+    }
+
+    R operator()(Args... args) const {
+        return _invoke(_target, std::forward<Args>(args)...);
+    }
+
+private:
+    union Target {
+        void* object;
+        void (*function)();
+    };
+
+    Target _target;                   // Ŀ
+    R (*_invoke)(Target, Args&&...);  // Ŀ
+};
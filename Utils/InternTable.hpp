@@ -0,0 +1,132 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include "ChunkedArray.hpp"
+#include "FlatHashIndex.hpp"
+
+/**
+ * ֻפֵӳΪܵ32λ
+ * һı䡣밴ŷ
+ * ұֻĿѰַÿͰһԭ֣32λϣ + ţ
+ * ʱ±ԭ滻ɱפڴ治ձ
+ * @tparam T ֵͣɹϣɱȽϡĬϹ
+ */
+template<typename T>
+class InternTable {
+    /**
+     * ұͰֵΪ 0 ʾգ32λΪϣ32λΪżһ
+     */
+    struct Table {
+        explicit Table(size_t capacity) : mask(capacity - 1), buckets(new std::atomic<uint64_t>[capacity]()) {}
+        size_t mask;
+        std::unique_ptr<std::atomic<uint64_t>[]> buckets;
+    };
+
+public:
+    InternTable() {
+        _tables.emplace_back(new Table(64));
+        _table.store(_tables.back().get(), std::memory_order_release);
+    }
+
+    InternTable(const InternTable&) = delete;
+    InternTable& operator=(const InternTable&) = delete;
+
+    /**
+     * ȡֵӦıţʱ±ţʱ
+     * @param value פֵ
+     * @return ֵı
+     */
+    uint32_t Intern(const T& value) {
+        const uint32_t hash = FlatHashIndex::Fold(std::hash<T>{}(value));
+        uint32_t id;
+        if (Lookup(hash, value, id)) return id;
+
+        std::lock_guard<std::mutex> lock(_insertMutex);
+        if (Lookup(hash, value, id)) return id;
+
+        id = _count.load(std::memory_order_relaxed);
+        if (id == UINT32_MAX - 1) throw std::length_error("InternTable is full");
+        _values.Ensure(id) = value;
+        _hashes.push_back(hash);
+
+        Table* table = _table.load(std::memory_order_relaxed);
+        if ((size_t(id) + 1) * 2 > table->mask + 1) table = Grow(table);
+        Place(*table, hash, id);
+        _count.store(id + 1, std::memory_order_release);
+        return id;
+    }
+
+    /**
+     * ֵӦıţ䡢
+     * @param value ҵֵ
+     * @param id ڴ洢ŵ
+     * @return Ƿפ
+     */
+    bool TryGetId(const T& value, uint32_t& id) const {
+        return Lookup(FlatHashIndex::Fold(std::hash<T>{}(value)), value, id);
+    }
+
+    /**
+     * ŷֵ
+     * @param id  Intern صı
+     * @return ֵãڱڱЧ
+     */
+    const T& Resolve(uint32_t id) const {
+        if (id >= _count.load(std::memory_order_acquire)) throw std::out_of_range("Unknown intern id");
+        return _values[id];
+    }
+
+    /**
+     * ȡפֵ
+     */
+    size_t Size() const {
+        return _count.load(std::memory_order_acquire);
+    }
+
+private:
+    bool Lookup(uint32_t hash, const T& value, uint32_t& id) const {
+        const Table* table = _table.load(std::memory_order_acquire);
+        for (size_t i = hash & table->mask;; i = (i + 1) & table->mask) {
+            const uint64_t bucket = table->buckets[i].load(std::memory_order_acquire);
+            if (bucket == 0) return false;
+            if (static_cast<uint32_t>(bucket >> 32) == hash) {
+                const uint32_t candidate = static_cast<uint32_t>(bucket) - 1;
+                if (_values[candidate] == value) {
+                    id = candidate;
+                    return true;
+                }
+            }
+        }
+    }
+
+    static void Place(Table& table, uint32_t hash, uint32_t id) {
+        size_t i = hash & table.mask;
+        while (table.buckets[i].load(std::memory_order_relaxed) != 0) i = (i + 1) & table.mask;
+        table.buckets[i].store((uint64_t(hash) << 32) | (uint64_t(id) + 1), std::memory_order_release);
+    }
+
+    /**
+     * ±ɱڲҵĶʹ
+     */
+    Table* Grow(Table* old) {
+        _tables.emplace_back(new Table((old->mask + 1) * 2));
+        Table* table = _tables.back().get();
+        const uint32_t count = _count.load(std::memory_order_relaxed);
+        for (uint32_t id = 0; id < count; ++id) Place(*table, _hashes[id], id);
+        _table.store(table, std::memory_order_release);
+        return table;
+    }
+
+    ChunkedArray<T> _values;                  // Ŵ洢ֵ
+    std::vector<uint32_t> _hashes;            // Ŵ洢Ĺϣʱʹ
+    std::vector<std::unique_ptr<Table>> _tables; // ǰ۵ľɱ
+    std::atomic<Table*> _table{ nullptr };    // ǰұ
+    std::atomic<uint32_t> _count{ 0 };        // ѷı
+    std::mutex _insertMutex;                  // ±ʱʹ
+};
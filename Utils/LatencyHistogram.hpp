@@ -0,0 +1,120 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+/**
+ * ֱͼֻգɿ̺߳ϲ
+ * Ͱ-Ի֣ÿ2ٵȷΪ4ͰλͰϽƣ25%
+ */
+struct HistogramSnapshot {
+    static constexpr uint32_t SubBucketBits = 2;                                // ÿ2Ͱλ
+    static constexpr uint32_t SubBuckets = uint32_t(1) << SubBucketBits;        // ÿ2Ͱ
+    static constexpr uint32_t BucketCount = (64 - SubBucketBits + 1) * SubBuckets; // ȫ64λȡֵ
+
+    uint64_t count = 0; // 
+    uint64_t sum = 0;   // ܺ
+    uint64_t max = 0;   // 
+    std::array<uint64_t, BucketCount> buckets{}; // Ͱ
+
+    /**
+     * ȡȡֵڵͰ
+     */
+    static uint32_t BucketOf(uint64_t value) {
+        if (value < SubBuckets) return static_cast<uint32_t>(value);
+        const uint32_t exponent = static_cast<uint32_t>(std::bit_width(value)) - 1;
+        const uint32_t sub = static_cast<uint32_t>(value >> (exponent - SubBucketBits)) & (SubBuckets - 1);
+        return (exponent - SubBucketBits + 1) * SubBuckets + sub;
+    }
+
+    /**
+     * ȡͰڵȡֵ
+     */
+    static uint64_t UpperBoundOf(uint32_t bucket) {
+        if (bucket < SubBuckets) return bucket;
+        const uint32_t shift = bucket / SubBuckets - 1;
+        const uint64_t lower = uint64_t(SubBuckets + bucket % SubBuckets) << shift;
+        return lower + ((uint64_t(1) << shift) - 1);
+    }
+
+    /**
+     * ϲһ
+     */
+    void Merge(const HistogramSnapshot& other) {
+        count += other.count;
+        sum += other.sum;
+        max = std::max(max, other.max);
+        for (uint32_t i = 0; i < BucketCount; ++i) buckets[i] += other.buckets[i];
+    }
+
+    /**
+     * Ʒλ
+     * @param quantile λȡֵ [0, 1] 0.99
+     * @return λͰϽ磨ʱΪ 0
+     */
+    uint64_t Percentile(double quantile) const {
+        if (count == 0) return 0;
+        const double clamped = std::clamp(quantile, 0.0, 1.0);
+        const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(clamped * count)));
+        uint64_t seen = 0;
+        for (uint32_t i = 0; i < BucketCount; ++i) {
+            seen += buckets[i];
+            if (seen >= rank) return std::min(UpperBoundOf(i), max);
+        }
+        return max;
+    }
+
+    /**
+     * ƽֵʱΪ 0
+     */
+    double Mean() const {
+        return count ? static_cast<double>(sum) / static_cast<double>(count) : 0.0;
+    }
+};
+
+/**
+ * дֱͼֻ̼߳¼߳̿ʱȡϲΪ
+ * ¼ֻͨԭӶдûж--дָҲûп˾
+ */
+class LatencyHistogram {
+public:
+    /**
+     * д߼ۼӣֻɼ̵߳
+     */
+    static void Increment(std::atomic<uint64_t>& counter, uint64_t delta = 1) {
+        counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+    /**
+     * ¼һ
+     * @param value ֵ
+     */
+    void Record(uint64_t value) {
+        Increment(_buckets[HistogramSnapshot::BucketOf(value)]);
+        Increment(_sum, value);
+        if (value > _max.load(std::memory_order_relaxed)) _max.store(value, std::memory_order_relaxed);
+    }
+
+    /**
+     * ѵǰۼӵ
+     * @param snapshot Ŀ
+     */
+    void AddTo(HistogramSnapshot& snapshot) const {
+        for (uint32_t i = 0; i < HistogramSnapshot::BucketCount; ++i) {
+            const uint64_t count = _buckets[i].load(std::memory_order_relaxed);
+            snapshot.buckets[i] += count;
+            snapshot.count += count;
+        }
+        snapshot.sum += _sum.load(std::memory_order_relaxed);
+        snapshot.max = std::max(snapshot.max, _max.load(std::memory_order_relaxed));
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, HistogramSnapshot::BucketCount> _buckets{}; // Ͱ
+    std::atomic<uint64_t> _sum{ 0 }; // ܺ
+    std::atomic<uint64_t> _max{ 0 }; // 
+};
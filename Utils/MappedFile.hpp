@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * ֻڴӳļʱԶӳ
+ */
+class MappedFile {
+public:
+    /**
+     * ӳļ
+     * @param path ļ·
+     */
+    explicit MappedFile(const std::string& path) {
+#ifdef _WIN32
+        _file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (_file == INVALID_HANDLE_VALUE) throw std::runtime_error("Failed to open file: " + path);
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(_file, &size)) {
+            Close();
+            throw std::runtime_error("Failed to stat file: " + path);
+        }
+        _size = static_cast<size_t>(size.QuadPart);
+        if (_size == 0) return;
+        _mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!_mapping) {
+            Close();
+            throw std::runtime_error("Failed to map file: " + path);
+        }
+        _data = static_cast<const char*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!_data) {
+            Close();
+            throw std::runtime_error("Failed to map file: " + path);
+        }
+#else
+        _fd = ::open(path.c_str(), O_RDONLY);
+        if (_fd < 0) throw std::runtime_error("Failed to open file: " + path);
+        struct stat st;
+        if (::fstat(_fd, &st) != 0) {
+            Close();
+            throw std::runtime_error("Failed to stat file: " + path);
+        }
+        _size = static_cast<size_t>(st.st_size);
+        if (_size == 0) return;
+        void* data = ::mmap(nullptr, _size, PROT_READ, MAP_SHARED, _fd, 0);
+        if (data == MAP_FAILED) {
+            Close();
+            throw std::runtime_error("Failed to map file: " + path);
+        }
+        _data = static_cast<const char*>(data);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        Close();
+    }
+
+    /**
+     * ȡӳʼַ
+     */
+    const char* Data() const {
+        return _data;
+    }
+
+    /**
+     * ȡļС
+     */
+    size_t Size() const {
+        return _size;
+    }
+
+private:
+    /**
+     * ӳ䲢رļ
+     */
+    void Close() {
+#ifdef _WIN32
+        if (_data) UnmapViewOfFile(_data);
+        if (_mapping) CloseHandle(_mapping);
+        if (_file != INVALID_HANDLE_VALUE) CloseHandle(_file);
+        _mapping = nullptr;
+        _file = INVALID_HANDLE_VALUE;
+#else
+        if (_data) ::munmap(const_cast<char*>(_data), _size);
+        if (_fd >= 0) ::close(_fd);
+        _fd = -1;
+#endif
+        _data = nullptr;
+    }
+
+#ifdef _WIN32
+    HANDLE _file = INVALID_HANDLE_VALUE; // ļ
+    HANDLE _mapping = nullptr;           // ӳ
+#else
+    int _fd = -1;                        // ļ
+#endif
+    const char* _data = nullptr;         // ӳʼַ
+    size_t _size = 0;                    // ļС
+};
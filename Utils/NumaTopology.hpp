@@ -0,0 +1,262 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <new>
+#include <string>
+#include <type_traits>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#endif
+
+/**
+ * NUMA 밴ڵڴ
+ * Windows ʹ VirtualAllocExNuma 봦׺ԣLinux ֱӵ mbind/getcpu ϵͳòȡ sysfs
+ *  libnumaڵ֧ NUMA ϵͳк˻ΪͨΪڵΪ1ǰڵΪ0
+ * ڵ int ʾ-1 ʾָڵ
+ */
+class NumaTopology {
+public:
+    /**
+     * ȡϵͳ NUMA ڵ
+     */
+    static uint32_t NodeCount() {
+#ifdef _WIN32
+        ULONG highest = 0;
+        if (!GetNumaHighestNodeNumber(&highest)) return 1;
+        return static_cast<uint32_t>(highest) + 1;
+#else
+        uint32_t count = 1;
+        ForEachInList(ReadFirstLine("/sys/devices/system/node/online"), [&](uint32_t node) {
+            if (node + 1 > count) count = node + 1;
+        });
+        return count;
+#endif
+    }
+
+    /**
+     * ȡǰ߳ڴĽڵ
+     */
+    static uint32_t CurrentNode() {
+#ifdef _WIN32
+        PROCESSOR_NUMBER processor;
+        GetCurrentProcessorNumberEx(&processor);
+        USHORT node = 0;
+        if (!GetNumaProcessorNodeEx(&processor, &node)) return 0;
+        return node;
+#elif defined(__linux__)
+        unsigned cpu = 0;
+        unsigned node = 0;
+        if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) return 0;
+        return node;
+#else
+        return 0;
+#endif
+    }
+
+    /**
+     * ѵǰ̰߳󶨵ڵȫ
+     * @param node ڵ
+     * @return Ƿɹ
+     */
+    static bool BindCurrentThread(uint32_t node) {
+#ifdef _WIN32
+        GROUP_AFFINITY affinity{};
+        if (!GetNumaNodeProcessorMaskEx(static_cast<USHORT>(node), &affinity) || affinity.Mask == 0) return false;
+        return SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr) != 0;
+#elif defined(__linux__)
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        bool any = false;
+        ForEachInList(ReadFirstLine("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"),
+            [&](uint32_t cpu) {
+                if (cpu >= CPU_SETSIZE) return;
+                CPU_SET(cpu, &cpus);
+                any = true;
+            });
+        return any && sched_setaffinity(0, sizeof(cpus), &cpus) == 0;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * ҳڴ棬ҳȷָڵϣڵڴ治ʱϵͳ˻ڵ
+     * @param bytes ֽ
+     * @param node ڵţ-1 ʾָ
+     * @return ҳڴ棬ʧʱ׳ std::bad_alloc
+     */
+    static void* Allocate(size_t bytes, int node) {
+        if (bytes == 0) bytes = 1;
+#ifdef _WIN32
+        void* memory = node < 0
+            ? VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE)
+            : VirtualAllocExNuma(GetCurrentProcess(), nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE,
+                static_cast<DWORD>(node));
+        if (!memory) throw std::bad_alloc();
+#else
+        void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) throw std::bad_alloc();
+        // ʧʱϵͳĬϵ״ηʲ
+        if (node >= 0) SetPreferredNode(memory, bytes, node, false);
+#endif
+        return memory;
+    }
+
+    /**
+     * ͷ Allocate ڴ
+     * @param memory ڴʼַ
+     * @param bytes ʱֽ
+     */
+    static void Free(void* memory, size_t bytes) {
+        if (!memory) return;
+#ifdef _WIN32
+        (void)bytes;
+        VirtualFree(memory, 0, MEM_RELEASE);
+#else
+        munmap(memory, bytes == 0 ? 1 : bytes);
+#endif
+    }
+
+    /**
+     * ѷڴڵҳǨƵָڵ㣬ַ䣻ΧչҳͬҳһǨ
+     * Windows ûǨύҳĽӿڣʱ falseҳ汣ԭλ
+     * @param memory ڴʼַ
+     * @param bytes ֽ
+     * @param node Ŀڵ
+     * @return Ƿɹ
+     */
+    static bool Migrate(const void* memory, size_t bytes, int node) {
+#if defined(__linux__)
+        if (!memory || bytes == 0 || node < 0) return false;
+        const uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+        const uintptr_t begin = reinterpret_cast<uintptr_t>(memory) & ~(page - 1);
+        const uintptr_t end = (reinterpret_cast<uintptr_t>(memory) + bytes + page - 1) & ~(page - 1);
+        return SetPreferredNode(reinterpret_cast<void*>(begin), end - begin, node, true);
+#else
+        (void)memory;
+        (void)bytes;
+        (void)node;
+        return false;
+#endif
+    }
+
+private:
+#ifndef _WIN32
+    /**
+     * ȡ sysfs ļĵһУļʱؿմ
+     */
+    static std::string ReadFirstLine(const std::string& path) {
+        std::ifstream file(path);
+        std::string line;
+        std::getline(file, line);
+        return line;
+    }
+
+    /**
+     *  sysfs бʽ "0-3,8,10-11"еÿ
+     */
+    template<typename Callback>
+    static void ForEachInList(const std::string& list, Callback&& callback) {
+        size_t i = 0;
+        auto readNumber = [&](uint32_t& value) {
+            if (i >= list.size() || list[i] < '0' || list[i] > '9') return false;
+            value = 0;
+            while (i < list.size() && list[i] >= '0' && list[i] <= '9') value = value * 10 + (list[i++] - '0');
+            return true;
+        };
+        while (i < list.size()) {
+            uint32_t first;
+            if (!readNumber(first)) return;
+            uint32_t last = first;
+            if (i < list.size() && list[i] == '-') {
+                ++i;
+                if (!readNumber(last)) return;
+            }
+            for (uint32_t value = first; value <= last; ++value) callback(value);
+            if (i < list.size() && list[i] == ',') ++i;
+            else return;
+        }
+    }
+#endif
+
+#if defined(__linux__)
+    /**
+     *  mbind ҳķΧΪʹָڵ
+     * @param move ǷͬʱǨѷҳ
+     */
+    static bool SetPreferredNode(void* memory, size_t bytes, int node, bool move) {
+        constexpr int PreferredPolicy = 1;       // MPOL_PREFERRED
+        constexpr unsigned MoveFlag = 1u << 1;   // MPOL_MF_MOVE
+        constexpr size_t MaskBits = 1024;        // ֵ֧ڵ
+        constexpr size_t WordBits = sizeof(unsigned long) * 8;
+        if (static_cast<size_t>(node) >= MaskBits) return false;
+        unsigned long mask[MaskBits / WordBits] = {};
+        mask[node / WordBits] = 1ul << (node % WordBits);
+        // ں˰ maxnode һΪλ
+        return syscall(SYS_mbind, memory, bytes, PreferredPolicy, mask, MaskBits + 1, move ? MoveFlag : 0u) == 0;
+    }
+#endif
+};
+
+/**
+ * ڴָ NUMA ڵϵķڱ׼
+ * ڵΪ -1 ʱ std::allocator ͬҳ䣬ʺڴ棨簴λ洢飩
+ * ƶֵʱһ𴫵ݣڵͨ·
+ * @tparam T Ԫ
+ */
+template<typename T>
+class NumaAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    NumaAllocator() = default;
+
+    /**
+     * 캯
+     * @param node ڵţ-1 ʾָ
+     */
+    explicit NumaAllocator(int node) : _node(node) {}
+
+    template<typename U>
+    NumaAllocator(const NumaAllocator<U>& other) : _node(other.Node()) {}
+
+    T* allocate(size_t count) {
+        if (_node < 0) return static_cast<T*>(::operator new(count * sizeof(T)));
+        return static_cast<T*>(NumaTopology::Allocate(count * sizeof(T), _node));
+    }
+
+    void deallocate(T* pointer, size_t count) {
+        if (_node < 0) ::operator delete(pointer);
+        else NumaTopology::Free(pointer, count * sizeof(T));
+    }
+
+    /**
+     * ȡڵ
+     */
+    int Node() const {
+        return _node;
+    }
+
+    template<typename U>
+    bool operator==(const NumaAllocator<U>& other) const {
+        return _node == other.Node();
+    }
+
+private:
+    int _node = -1; // ڵ
+};
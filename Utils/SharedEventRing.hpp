@@ -0,0 +1,296 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include "SharedMemory.hpp"
+
+/**
+ * ¼Ĺ̶֣ͷΪ2ݵĲλ飬ÿλռ
+ * λͷǰ汾ţ¼ֽڿ汾Ϊ 2n+1 ʾ n д룬2n+2 ʾ n ѷ
+ * ֻͷ¼ĳߴ磬ָ룬ԭֶζģɿʹ
+ */
+namespace SharedEventLayout {
+    constexpr uint64_t Magic = 0x3130544E56454D53ull; // "SMEVNT01"
+    constexpr uint32_t Version = 1;
+
+    /**
+     * ͷдȫߴ ready Ϊ 1дλõռһ
+     */
+    struct Header {
+        uint64_t magic;          // ħ
+        uint32_t version;        // ְ汾
+        uint32_t eventBytes;     // ¼͵ֽ
+        uint32_t eventAlign;     // ¼͵Ķ
+        uint32_t slotBytes;      // λ
+        uint64_t capacity;       // λ2
+        uint64_t schemaId;       // ¼ʽʶʹ÷Լȡдһ
+        uint64_t slotsOffset;    // λƫ
+        uint64_t totalBytes;     // εֽ
+        std::atomic<uint32_t> ready;  // 1 ʾͷд
+        std::atomic<uint32_t> closed; // 1 ʾдѹرգ¼
+        alignas(64) std::atomic<uint64_t> head; // һ¼ţѷ¼
+    };
+
+    static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+        "shared event ring needs lock-free atomics");
+
+    inline uint64_t Align(uint64_t value) {
+        return (value + 63) & ~uint64_t(63);
+    }
+
+    /**
+     * ¼ڲλеƫƣ汾֮󡢰¼Ͷ
+     */
+    template<typename TEvent>
+    constexpr size_t PayloadOffset() {
+        return alignof(TEvent) > sizeof(uint64_t) ? alignof(TEvent) : sizeof(uint64_t);
+    }
+
+    template<typename TEvent>
+    constexpr uint32_t SlotBytes() {
+        return static_cast<uint32_t>((PayloadOffset<TEvent>() + sizeof(TEvent) + 63) & ~size_t(63));
+    }
+
+    /**
+     * ¼͵Լɰֽڿ̶ֹܿԭ
+     */
+    template<typename TEvent>
+    constexpr bool IsSharable() {
+        return std::is_trivially_copyable<TEvent>::value && std::is_standard_layout<TEvent>::value
+            && alignof(TEvent) <= 64;
+    }
+}
+
+/**
+ * ¼дˣд߹㲥д󸲸ɵ¼Ӳȴȡ
+ * һ¼ֻһ memcpy ԭдûϵͳãȡ˵ĽȲӰдˡ
+ * ֻһ̷߳ʱǹرղɾƣӳĶȡԿɶʣ¼
+ * @tparam TEvent ¼ͣƽΪ׼ָ֣ܺȽڵַ
+ */
+template<typename TEvent>
+class SharedEventWriter {
+    static_assert(SharedEventLayout::IsSharable<TEvent>(), "SharedEventWriter event must be trivially copyable with standard layout");
+
+public:
+    /**
+     * ڴβдͷ
+     * @param name 
+     * @param capacity λȡ2ݣȡ󳬹һȦ¼ᱻ
+     * @param schemaId ¼ʽʶ¼ṹ仯ʱӦȡ˾ݴ˾ܾݵĶ
+     */
+    SharedEventWriter(const std::string& name, size_t capacity, uint64_t schemaId = 0)
+        : _memory(SharedMemory::Create(name, LayoutBytes(RoundUp(capacity)))) {
+        using namespace SharedEventLayout;
+        _header = reinterpret_cast<Header*>(_memory.Data());
+        _header->magic = Magic;
+        _header->version = Version;
+        _header->eventBytes = sizeof(TEvent);
+        _header->eventAlign = alignof(TEvent);
+        _header->slotBytes = SlotBytes<TEvent>();
+        _header->capacity = RoundUp(capacity);
+        _header->schemaId = schemaId;
+        _header->slotsOffset = Align(sizeof(Header));
+        _header->totalBytes = _memory.Size();
+        _mask = _header->capacity - 1;
+        _slots = _memory.Data() + _header->slotsOffset;
+        _header->ready.store(1, std::memory_order_release);
+    }
+
+    SharedEventWriter(const SharedEventWriter&) = delete;
+    SharedEventWriter& operator=(const SharedEventWriter&) = delete;
+
+    ~SharedEventWriter() {
+        Close();
+    }
+
+    /**
+     * һ¼
+     * @param event ¼
+     * @return ¼
+     */
+    uint64_t Publish(const TEvent& event) {
+        const uint64_t sequence = _next++;
+        char* slot = _slots + (sequence & _mask) * SharedEventLayout::SlotBytes<TEvent>();
+        std::atomic<uint64_t>& version = *reinterpret_cast<std::atomic<uint64_t>*>(slot);
+        version.store(2 * sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(slot + SharedEventLayout::PayloadOffset<TEvent>(), &event, sizeof(TEvent));
+        version.store(2 * sequence + 2, std::memory_order_release);
+        _header->head.store(sequence + 1, std::memory_order_release);
+        return sequence;
+    }
+
+    /**
+     * дѹرգȡ˶ʣ¼ɾݴ˳ظӰ
+     */
+    void Close() {
+        if (_header) _header->closed.store(1, std::memory_order_release);
+    }
+
+    /**
+     * ȡѷ¼
+     */
+    uint64_t PublishedCount() const {
+        return _next;
+    }
+
+    /**
+     * ȡλ
+     */
+    size_t Capacity() const {
+        return _mask + 1;
+    }
+
+private:
+    static size_t RoundUp(size_t capacity) {
+        if (capacity == 0) throw std::invalid_argument("capacity must be positive");
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        return size;
+    }
+
+    static size_t LayoutBytes(size_t capacity) {
+        using namespace SharedEventLayout;
+        return static_cast<size_t>(Align(sizeof(Header)) + uint64_t(capacity) * SlotBytes<TEvent>());
+    }
+
+    SharedMemory _memory;                 // ڴ
+    SharedEventLayout::Header* _header;   // ͷ
+    char* _slots;                         // λ
+    size_t _mask;                         // 
+    uint64_t _next = 0;                   // һ¼ţֻд̷߳
+};
+
+/**
+ * ¼Ķȡˣֻʽӳд˵ĶΣα걣ڱ
+ * ÿȡ˶ѡӰ죬Ҳдڴ棻̬¶ȡֻʲλûϵͳá
+ * 󳬹һȦʱɵδ¼ DroppedCount
+ * ȡ˶̰߳ȫ
+ * @tparam TEvent ¼ͣдһ
+ */
+template<typename TEvent>
+class SharedEventReader {
+    static_assert(SharedEventLayout::IsSharable<TEvent>(), "SharedEventReader event must be trivially copyable with standard layout");
+
+public:
+    /**
+     * ֻʽӳ¼
+     * @param name 
+     * @param schemaId ¼ʽʶдһ
+     * @param fromOldest Ϊ true ʱɵδ¼ʼֻ˺󷢲¼
+     */
+    explicit SharedEventReader(const std::string& name, uint64_t schemaId = 0, bool fromOldest = false)
+        : _memory(SharedMemory::OpenReadOnly(name)) {
+        using namespace SharedEventLayout;
+        if (_memory.Size() < sizeof(Header)) throw std::runtime_error("Invalid shared event ring: " + name);
+        _header = reinterpret_cast<const Header*>(_memory.Data());
+        const uint64_t capacity = _header->capacity;
+        if (_header->ready.load(std::memory_order_acquire) != 1 || _header->magic != Magic
+            || _header->version != Version || _header->totalBytes > _memory.Size()
+            || capacity == 0 || (capacity & (capacity - 1)) != 0
+            || _header->slotsOffset + capacity * _header->slotBytes > _header->totalBytes) {
+            throw std::runtime_error("Invalid shared event ring: " + name);
+        }
+        if (_header->eventBytes != sizeof(TEvent) || _header->eventAlign != alignof(TEvent)
+            || _header->slotBytes != SlotBytes<TEvent>() || _header->schemaId != schemaId) {
+            throw std::runtime_error("Shared event ring has a different event layout: " + name);
+        }
+        _mask = capacity - 1;
+        _slots = _memory.Data() + _header->slotsOffset;
+        _next = fromOldest ? Oldest(_header->head.load(std::memory_order_acquire)) : _header->head.load(std::memory_order_acquire);
+    }
+
+    SharedEventReader(const SharedEventReader&) = delete;
+    SharedEventReader& operator=(const SharedEventReader&) = delete;
+
+    /**
+     * ȡһ¼
+     * @param event ¼
+     * @return Ƿû¼ʱ false
+     */
+    bool TryRead(TEvent& event) {
+        for (;;) {
+            const char* slot = _slots + (_next & _mask) * SharedEventLayout::SlotBytes<TEvent>();
+            const std::atomic<uint64_t>& version = *reinterpret_cast<const std::atomic<uint64_t>*>(slot);
+            const uint64_t expected = 2 * _next + 2;
+            const uint64_t before = version.load(std::memory_order_acquire);
+            if (before < expected) return false; // δλһȦ¼д룩
+            if (before == expected) {
+                std::memcpy(&event, slot + SharedEventLayout::PayloadOffset<TEvent>(), sizeof(TEvent));
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (version.load(std::memory_order_relaxed) == expected) {
+                    ++_next;
+                    return true;
+                }
+            }
+            // λѱһȦǣɵδ¼
+            const uint64_t oldest = Oldest(_header->head.load(std::memory_order_acquire));
+            const uint64_t resume = oldest > _next ? oldest : _next + 1;
+            _dropped += resume - _next;
+            _next = resume;
+        }
+    }
+
+    /**
+     * ȡ maxCount ¼ص
+     * @param handler  void(const TEvent&) Ļصת̵ EventBus
+     * @param maxCount ȡ
+     * @return ȡ
+     */
+    template<typename Handler>
+    size_t Poll(Handler&& handler, size_t maxCount = SIZE_MAX) {
+        size_t count = 0;
+        TEvent event;
+        while (count < maxCount && TryRead(event)) {
+            handler(static_cast<const TEvent&>(event));
+            ++count;
+        }
+        return count;
+    }
+
+    /**
+     * ȡȡǶ¼
+     */
+    uint64_t DroppedCount() const {
+        return _dropped;
+    }
+
+    /**
+     * ȡδȡѷ¼ܳʱһѱǣ
+     */
+    uint64_t Lag() const {
+        const uint64_t head = _header->head.load(std::memory_order_acquire);
+        return head > _next ? head - _next : 0;
+    }
+
+    /**
+     * дǷѹرգ true ֮ TryRead ٷ false ʾѶ
+     */
+    bool IsClosed() const {
+        return _header->closed.load(std::memory_order_acquire) != 0;
+    }
+
+    /**
+     * ȡһȡ¼
+     */
+    uint64_t NextSequence() const {
+        return _next;
+    }
+
+private:
+    uint64_t Oldest(uint64_t head) const {
+        return head > _mask ? head - _mask - 1 : 0;
+    }
+
+    SharedMemory _memory;                     // ֻӳ
+    const SharedEventLayout::Header* _header; // ͷ
+    const char* _slots;                       // λ
+    size_t _mask;                             // 
+    uint64_t _next = 0;                       // һȡ¼
+    uint64_t _dropped = 0;                    // Ƕ¼
+};
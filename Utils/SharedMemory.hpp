@@ -0,0 +1,178 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * ڴΣʱԶӳ
+ * Զдʽӳ䣬ֻ̰ʽӳͬһڴ档
+ * Windows ʹҳļֵ֧ӳһرպͷţ
+ * POSIX ʹ shm_openʱɾƣӳĽ̲Ӱ
+ */
+class SharedMemory {
+public:
+    /**
+     * ڴΣͬľɶα滻¶
+     * @param name ƣPOSIX ϲ '/' ͷʱԶ
+     * @param size ֽ
+     * @return дӳĹڴ
+     */
+    static SharedMemory Create(const std::string& name, size_t size) {
+        SharedMemory memory;
+        memory._name = NormalizeName(name);
+        memory._size = size;
+        memory._owner = true;
+#ifdef _WIN32
+        const unsigned long long bytes = size;
+        memory._mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+            static_cast<DWORD>(bytes >> 32), static_cast<DWORD>(bytes), memory._name.c_str());
+        if (!memory._mapping) throw std::runtime_error("Failed to create shared memory: " + name);
+        if (GetLastError() == ERROR_ALREADY_EXISTS) {
+            throw std::runtime_error("Shared memory is still mapped by another process: " + name);
+        }
+        memory._data = static_cast<char*>(MapViewOfFile(memory._mapping, FILE_MAP_ALL_ACCESS, 0, 0, size));
+        if (!memory._data) throw std::runtime_error("Failed to map shared memory: " + name);
+#else
+        ::shm_unlink(memory._name.c_str());
+        memory._fd = ::shm_open(memory._name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (memory._fd < 0) throw std::runtime_error("Failed to create shared memory: " + name);
+        if (::ftruncate(memory._fd, static_cast<off_t>(size)) != 0) {
+            throw std::runtime_error("Failed to size shared memory: " + name);
+        }
+        void* data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, memory._fd, 0);
+        if (data == MAP_FAILED) throw std::runtime_error("Failed to map shared memory: " + name);
+        memory._data = static_cast<char*>(data);
+#endif
+        return memory;
+    }
+
+    /**
+     * ֻʽӳѴڵĹڴ
+     * @param name 
+     * @return ֻӳĹڴ
+     */
+    static SharedMemory OpenReadOnly(const std::string& name) {
+        SharedMemory memory;
+        memory._name = NormalizeName(name);
+#ifdef _WIN32
+        memory._mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, memory._name.c_str());
+        if (!memory._mapping) throw std::runtime_error("Failed to open shared memory: " + name);
+        memory._data = static_cast<char*>(MapViewOfFile(memory._mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!memory._data) throw std::runtime_error("Failed to map shared memory: " + name);
+        MEMORY_BASIC_INFORMATION info;
+        if (!VirtualQuery(memory._data, &info, sizeof(info))) {
+            throw std::runtime_error("Failed to stat shared memory: " + name);
+        }
+        memory._size = info.RegionSize;
+#else
+        memory._fd = ::shm_open(memory._name.c_str(), O_RDONLY, 0);
+        if (memory._fd < 0) throw std::runtime_error("Failed to open shared memory: " + name);
+        struct stat st;
+        if (::fstat(memory._fd, &st) != 0) throw std::runtime_error("Failed to stat shared memory: " + name);
+        memory._size = static_cast<size_t>(st.st_size);
+        if (memory._size == 0) throw std::runtime_error("Shared memory is empty: " + name);
+        void* data = ::mmap(nullptr, memory._size, PROT_READ, MAP_SHARED, memory._fd, 0);
+        if (data == MAP_FAILED) throw std::runtime_error("Failed to map shared memory: " + name);
+        memory._data = static_cast<char*>(data);
+#endif
+        return memory;
+    }
+
+    SharedMemory(SharedMemory&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    SharedMemory& operator=(SharedMemory&& other) noexcept {
+        if (this != &other) {
+            Close();
+            _name = std::move(other._name);
+            _data = other._data;
+            _size = other._size;
+            _owner = other._owner;
+#ifdef _WIN32
+            _mapping = other._mapping;
+            other._mapping = nullptr;
+#else
+            _fd = other._fd;
+            other._fd = -1;
+#endif
+            other._data = nullptr;
+            other._owner = false;
+        }
+        return *this;
+    }
+
+    SharedMemory(const SharedMemory&) = delete;
+    SharedMemory& operator=(const SharedMemory&) = delete;
+
+    ~SharedMemory() {
+        Close();
+    }
+
+    /**
+     * ȡӳʼַֻӳ䲻д
+     */
+    char* Data() const {
+        return _data;
+    }
+
+    /**
+     * ȡӳֽ
+     */
+    size_t Size() const {
+        return _size;
+    }
+
+private:
+    SharedMemory() = default;
+
+    static std::string NormalizeName(const std::string& name) {
+#ifdef _WIN32
+        return name;
+#else
+        return name.empty() || name[0] != '/' ? "/" + name : name;
+#endif
+    }
+
+    /**
+     * ӳ䲢رվͬʱɾ
+     */
+    void Close() {
+#ifdef _WIN32
+        if (_data) UnmapViewOfFile(_data);
+        if (_mapping) CloseHandle(_mapping);
+        _mapping = nullptr;
+#else
+        if (_data) ::munmap(_data, _size);
+        if (_fd >= 0) ::close(_fd);
+        if (_owner) ::shm_unlink(_name.c_str());
+        _fd = -1;
+#endif
+        _data = nullptr;
+        _owner = false;
+    }
+
+    std::string _name;      // 
+#ifdef _WIN32
+    HANDLE _mapping = nullptr; // ӳ
+#else
+    int _fd = -1;           // ڴ
+#endif
+    char* _data = nullptr;  // ӳʼַ
+    size_t _size = 0;       // ӳֽ
+    bool _owner = false;    // ǷΪ
+};
@@ -0,0 +1,373 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BinaryCodec.hpp"
+#include "SharedMemory.hpp"
+
+/**
+ * ״̬ѡ
+ */
+struct SharedStateOptions {
+    size_t capacity = size_t(1) << 20; // ɾļƬ
+    uint32_t keyBytes = 32;            // ֽļ
+    uint32_t stateCapacity = 256;      // ɷ״̬
+    uint32_t stateBytes = 56;          // ״ֽ̬״̬ΪĬֵ
+};
+
+/**
+ * ״̬Ĺ̶֣ͷ״̬ƬλеļĿְ64ֽڶ
+ * ԭֶζģɿʹãֻͷ¼ĳߴ磬ָ
+ */
+namespace SharedStateLayout {
+    constexpr uint64_t Magic = 0x3130544154534D53ull; // "SMSTAT01"
+    constexpr uint32_t Version = 1;
+
+    /**
+     * ͷдȫߴ ready Ϊ 1
+     */
+    struct Header {
+        uint64_t magic;           // ħ
+        uint32_t version;         // ְ汾
+        uint32_t shardCount;      // Ƭ
+        uint32_t slotsPerShard;   // ÿƬĲλ
+        uint32_t keyBytes;        // ÿĿļ
+        uint32_t entryBytes;      // Ŀ
+        uint32_t stateCapacity;   // ״̬
+        uint32_t stateBytes;      // ÿ״̬ı
+        uint32_t stateEntryBytes; // ״̬Ŀ
+        uint32_t versionBits;     // Ŀ汾ŵЧλ
+        uint32_t reserved;
+        uint64_t stateTableOffset; // ״̬ƫ
+        uint64_t entriesOffset;    // Ŀƫ
+        uint64_t totalBytes;       // εֽ
+        std::atomic<uint32_t> ready;      // 1 ʾͷд
+        std::atomic<uint32_t> stateCount; // ѷ״̬״̬ż±
+        std::atomic<uint64_t> unmirroredKeys; // λδļۼƣ
+    };
+
+    /**
+     * ״̬Ŀ stateBytes ֽڵı룻ֻдһΣ stateCount 
+     */
+    struct StateEntry {
+        uint32_t length; // ֽ0 ʾδܷ
+    };
+
+    /**
+     * Ŀ keyBytes ֽڵļ
+     * 볤Ϊʾд룬ǰζͬżŲһ£
+     * ״̬ԭַֻǰˣͬһ״̬辭
+     */
+    struct Entry {
+        std::atomic<uint32_t> sequence;  // 
+        std::atomic<uint32_t> keyLength; // ֽ0 ʾλ
+        std::atomic<uint64_t> state;     // 32λΪ汾ţ32λΪ״̬
+    };
+
+    static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+        "shared state table needs lock-free atomics");
+
+    inline uint64_t Align(uint64_t value) {
+        return (value + 63) & ~uint64_t(63);
+    }
+
+    inline uint64_t Pack(uint32_t version, uint32_t stateId) {
+        return (uint64_t(version) << 32) | stateId;
+    }
+}
+
+/**
+ * ״̬дˣӵ״̬Ľ̴
+ * ͬһƬλϵ Bind/Unbind ɵ÷лзƬдͬλɲ
+ * PublishState ֮˴˲汾ֻǰˣAddState ɵ÷л
+ * @tparam TKey ֧ͣ BinaryCodec
+ * @tparam TState ״̬֧ͣ BinaryCodec
+ */
+template<typename TKey, typename TState>
+class SharedStateWriter {
+public:
+    /**
+     * ڴβдͷ
+     * @param name 
+     * @param options ѡ
+     * @param shardCount Ƭ
+     * @param versionBits 汾ŵЧλ
+     */
+    SharedStateWriter(const std::string& name, const SharedStateOptions& options, uint32_t shardCount,
+        uint32_t versionBits)
+        : _memory(SharedMemory::Create(name, LayoutBytes(options, shardCount))) {
+        using namespace SharedStateLayout;
+        _versionMask = versionBits >= 32 ? UINT32_MAX : (uint32_t(1) << versionBits) - 1;
+        _header = reinterpret_cast<Header*>(_memory.Data());
+        _header->magic = Magic;
+        _header->version = Version;
+        _header->shardCount = shardCount;
+        _header->slotsPerShard = SlotsPerShard(options, shardCount);
+        _header->keyBytes = options.keyBytes;
+        _header->entryBytes = EntryBytes(options);
+        _header->stateCapacity = options.stateCapacity;
+        _header->stateBytes = options.stateBytes;
+        _header->stateEntryBytes = StateEntryBytes(options);
+        _header->versionBits = versionBits;
+        _header->stateTableOffset = Align(sizeof(Header));
+        _header->entriesOffset = _header->stateTableOffset + Align(uint64_t(options.stateCapacity) * _header->stateEntryBytes);
+        _header->totalBytes = _memory.Size();
+        _header->ready.store(1, std::memory_order_release);
+    }
+
+    SharedStateWriter(const SharedStateWriter&) = delete;
+    SharedStateWriter& operator=(const SharedStateWriter&) = delete;
+
+    /**
+     * Ѽ󶨵λ״̬λʱ
+     * @return ǷѾ
+     */
+    bool Bind(uint32_t shard, uint32_t slot, const TKey& key, uint32_t version, uint32_t stateId) {
+        SharedStateLayout::Entry* entry = EntryAt(shard, slot);
+        std::string encoded;
+        if (entry) BinaryCodec<TKey>::Write(encoded, key);
+        if (!entry || encoded.empty() || encoded.size() > _header->keyBytes) {
+            if (entry) Unbind(shard, slot);
+            _header->unmirroredKeys.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        const uint32_t sequence = entry->sequence.load(std::memory_order_relaxed);
+        entry->sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        entry->keyLength.store(static_cast<uint32_t>(encoded.size()), std::memory_order_relaxed);
+        std::memcpy(KeyOf(entry), encoded.data(), encoded.size());
+        Advance(*entry, version, stateId);
+        entry->sequence.store(sequence + 2, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * λϵļߴ˺󿴲òλ
+     */
+    void Unbind(uint32_t shard, uint32_t slot) {
+        SharedStateLayout::Entry* entry = EntryAt(shard, slot);
+        if (!entry || entry->keyLength.load(std::memory_order_relaxed) == 0) return;
+        const uint32_t sequence = entry->sequence.load(std::memory_order_relaxed);
+        entry->sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        entry->keyLength.store(0, std::memory_order_relaxed);
+        entry->sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    /**
+     * λϵ״̬汾Ųѷʱ
+     */
+    void PublishState(uint32_t shard, uint32_t slot, uint32_t version, uint32_t stateId) {
+        if (SharedStateLayout::Entry* entry = EntryAt(shard, slot)) Advance(*entry, version, stateId);
+    }
+
+    /**
+     * ״̬Ƿ跢δ״̬δ
+     */
+    bool NeedsState(uint32_t stateId) const {
+        const uint32_t count = _header->stateCount.load(std::memory_order_relaxed);
+        return stateId >= count && count < _header->stateCapacity;
+    }
+
+    /**
+     * ȡѷ״̬
+     */
+    uint32_t StateCount() const {
+        return _header->stateCount.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * һ״̬ŶӦ״̬״̬ʱ
+     */
+    void AddState(const TState& state) {
+        using namespace SharedStateLayout;
+        const uint32_t id = _header->stateCount.load(std::memory_order_relaxed);
+        if (id >= _header->stateCapacity) return;
+        char* base = _memory.Data() + _header->stateTableOffset + uint64_t(id) * _header->stateEntryBytes;
+        StateEntry* entry = reinterpret_cast<StateEntry*>(base);
+        std::string encoded;
+        BinaryCodec<TState>::Write(encoded, state);
+        entry->length = encoded.size() <= _header->stateBytes ? static_cast<uint32_t>(encoded.size()) : 0;
+        std::memcpy(base + sizeof(StateEntry), encoded.data(), entry->length);
+        _header->stateCount.store(id + 1, std::memory_order_release);
+    }
+
+private:
+    static uint32_t SlotsPerShard(const SharedStateOptions& options, uint32_t shardCount) {
+        return static_cast<uint32_t>((options.capacity + shardCount - 1) / shardCount);
+    }
+
+    static uint32_t EntryBytes(const SharedStateOptions& options) {
+        return static_cast<uint32_t>((sizeof(SharedStateLayout::Entry) + options.keyBytes + 7) & ~size_t(7));
+    }
+
+    static uint32_t StateEntryBytes(const SharedStateOptions& options) {
+        return static_cast<uint32_t>((sizeof(SharedStateLayout::StateEntry) + options.stateBytes + 7) & ~size_t(7));
+    }
+
+    static size_t LayoutBytes(const SharedStateOptions& options, uint32_t shardCount) {
+        using namespace SharedStateLayout;
+        return static_cast<size_t>(Align(sizeof(Header))
+            + Align(uint64_t(options.stateCapacity) * StateEntryBytes(options))
+            + uint64_t(shardCount) * SlotsPerShard(options, shardCount) * EntryBytes(options));
+    }
+
+    SharedStateLayout::Entry* EntryAt(uint32_t shard, uint32_t slot) const {
+        if (slot >= _header->slotsPerShard) return nullptr;
+        const uint64_t index = uint64_t(shard) * _header->slotsPerShard + slot;
+        return reinterpret_cast<SharedStateLayout::Entry*>(
+            _memory.Data() + _header->entriesOffset + index * _header->entryBytes);
+    }
+
+    static char* KeyOf(SharedStateLayout::Entry* entry) {
+        return reinterpret_cast<char*>(entry) + sizeof(SharedStateLayout::Entry);
+    }
+
+    /**
+     * 汾ǰƺĲֵǰȦʱΪڵǰֵ
+     */
+    void Advance(SharedStateLayout::Entry& entry, uint32_t version, uint32_t stateId) {
+        const uint64_t desired = SharedStateLayout::Pack(version, stateId);
+        uint64_t current = entry.state.load(std::memory_order_relaxed);
+        while (((version - static_cast<uint32_t>(current >> 32)) & _versionMask) <= (_versionMask >> 1)
+            && current != desired
+            && !entry.state.compare_exchange_weak(current, desired, std::memory_order_release, std::memory_order_relaxed)) {}
+    }
+
+    SharedMemory _memory;                  // ڴ
+    SharedStateLayout::Header* _header;    // ͷ
+    uint32_t _versionMask;                 // 汾
+};
+
+/**
+ * ״ֻ̬ˣ̣ر߳ӳͬһڴȡĵǰ״̬
+ * ȡҲдڴ棬дûκӰ죻ȡ˶̰߳ȫ
+ * @tparam TKey ͣдһ
+ * @tparam TState ״̬ͣдһ
+ */
+template<typename TKey, typename TState>
+class SharedStateReader {
+public:
+    /**
+     * ֻʽӳ乲״̬
+     * @param name 
+     */
+    explicit SharedStateReader(const std::string& name)
+        : _memory(SharedMemory::OpenReadOnly(name)) {
+        using namespace SharedStateLayout;
+        if (_memory.Size() < sizeof(Header)) throw std::runtime_error("Invalid shared state table: " + name);
+        _header = reinterpret_cast<const Header*>(_memory.Data());
+        if (_header->ready.load(std::memory_order_acquire) != 1 || _header->magic != Magic
+            || _header->version != Version || _header->totalBytes > _memory.Size()
+            || _header->entriesOffset + SlotCount() * _header->entryBytes > _header->totalBytes) {
+            throw std::runtime_error("Invalid shared state table: " + name);
+        }
+    }
+
+    /**
+     * ȡλƬ  ÿƬĲλ
+     */
+    uint64_t SlotCount() const {
+        return uint64_t(_header->shardCount) * _header->slotsPerShard;
+    }
+
+    /**
+     * ȡдδܾļۼƣ
+     */
+    uint64_t UnmirroredKeys() const {
+        return _header->unmirroredKeys.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * һµضȡһλ
+     * @param index λ±꣬ȡֵ [0, SlotCount())
+     * @param key ڴ洢
+     * @param state ڴ洢״̬
+     * @param version ڴ洢״̬汾ŵ
+     * @return λǷмд˳дͬһλʱҲԴþ false
+     */
+    bool TryRead(uint64_t index, TKey& key, TState& state, uint64_t& version) {
+        using namespace SharedStateLayout;
+        const Entry* entry = reinterpret_cast<const Entry*>(
+            _memory.Data() + _header->entriesOffset + index * _header->entryBytes);
+        const char* keyBytes = reinterpret_cast<const char*>(entry) + sizeof(Entry);
+        _buffer.resize(_header->keyBytes);
+        for (int attempt = 0; attempt < MaxAttempts; ++attempt) {
+            const uint32_t before = entry->sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+            const uint32_t length = entry->keyLength.load(std::memory_order_relaxed);
+            if (length > _header->keyBytes) continue;
+            std::memcpy(&_buffer[0], keyBytes, length);
+            const uint64_t packed = entry->state.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (entry->sequence.load(std::memory_order_relaxed) != before) continue;
+            if (length == 0) return false;
+
+            const char* p = _buffer.data();
+            if (!BinaryCodec<TKey>::Read(p, p + length, key)) return false;
+            state = ResolveState(static_cast<uint32_t>(packed));
+            version = packed >> 32;
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * Ѿļÿһ£岻ͬһʱ̵Ŀ
+     * @param callback  void(const TKey&, const TState&, uint64_t version) Ļص
+     * @return ļ
+     */
+    template<typename Callback>
+    size_t ForEach(Callback&& callback) {
+        TKey key{};
+        TState state{};
+        uint64_t version;
+        size_t count = 0;
+        const uint64_t slots = SlotCount();
+        for (uint64_t i = 0; i < slots; ++i) {
+            if (!TryRead(i, key, state, version)) continue;
+            callback(key, state, version);
+            ++count;
+        }
+        return count;
+    }
+
+private:
+    static constexpr int MaxAttempts = 64; // λԴ
+
+    /**
+     * ȡ״̬·״̬Ŀ
+     */
+    const TState& ResolveState(uint32_t stateId) {
+        using namespace SharedStateLayout;
+        if (stateId >= _states.size()) {
+            const uint32_t count = _header->stateCount.load(std::memory_order_acquire);
+            for (uint32_t id = static_cast<uint32_t>(_states.size()); id < count; ++id) {
+                const char* base = _memory.Data() + _header->stateTableOffset + uint64_t(id) * _header->stateEntryBytes;
+                const StateEntry* entry = reinterpret_cast<const StateEntry*>(base);
+                TState state{};
+                const char* p = base + sizeof(StateEntry);
+                if (entry->length > _header->stateBytes || !BinaryCodec<TState>::Read(p, p + entry->length, state)) {
+                    state = TState{};
+                }
+                _states.push_back(state);
+            }
+            if (stateId >= _states.size()) return _unknown;
+        }
+        return _states[stateId];
+    }
+
+    SharedMemory _memory;                     // ֻӳ
+    const SharedStateLayout::Header* _header; // ͷ
+    std::vector<TState> _states;              // ѽ״̬
+    TState _unknown{};                        // δ״̬ŶΪĬֵ
+    std::string _buffer;                      // Ķȡ
+};
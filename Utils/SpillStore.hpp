@@ -0,0 +1,310 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "BinaryCodec.hpp"
+
+/**
+ * 洢Ѵڴлļ¼׷дϵĶļȡ
+ * ļÿ¼ĸʽΪ [¼ֽ u32][ u32][][غ]ڴֻ¼λõ
+ * ¼ȡءɾ򸲸ǺΪԾݲһĶ CompactStep ǨǰΣ
+ * պɾļÿֻ޵ֽ洢ֻڴ죬ʱɾжļ
+ * ̰߳ȫвڲִ
+ * @tparam TKey ͣɹϣɱȽϲ֧ BinaryCodec
+ */
+template<typename TKey>
+class SpillStore {
+    /**
+     * ¼ڶļеλ
+     */
+    struct Location {
+        uint32_t segment; // α
+        uint32_t size;    // ¼ֽ¼ͷ
+        uint64_t offset;  // ¼ڶļеƫ
+    };
+
+    /**
+     * һļ
+     */
+    struct Segment {
+        std::fstream file;          // д
+        std::string path;           // ļ·
+        uint64_t bytes = 0;         // дֽ
+        uint64_t liveBytes = 0;     // Աõֽ
+        uint64_t compactOffset = 0; // Ķȡλ
+    };
+
+public:
+    /**
+     * 캯
+     * @param path ļ·ǰ׺ļΪ path.<α>
+     * @param partitionCount ÷ɰ
+     * @param segmentBytes ļĿСдл¶
+     */
+    SpillStore(const std::string& path, uint32_t partitionCount, uint64_t segmentBytes = uint64_t(64) << 20)
+        : _path(path), _segmentBytes(segmentBytes), _partitions(partitionCount) {
+        OpenSegmentLocked();
+    }
+
+    SpillStore(const SpillStore&) = delete;
+    SpillStore& operator=(const SpillStore&) = delete;
+
+    ~SpillStore() {
+        for (auto& segment : _segments) {
+            segment.second->file.close();
+            std::error_code ignored;
+            std::filesystem::remove(segment.second->path, ignored);
+        }
+    }
+
+    /**
+     * ȡļ·ǰ׺
+     */
+    const std::string& Path() const {
+        return _path;
+    }
+
+    /**
+     * дһ¼Ѵڵͬ¼
+     * @param partition 
+     * @param key 
+     * @param payload غ
+     */
+    void Put(uint32_t partition, const TKey& key, const std::string& payload) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto& index = _partitions.at(partition);
+        auto it = index.find(key);
+        if (it != index.end()) {
+            DiscardLocked(it->second);
+            index.erase(it);
+        }
+        index.emplace(key, AppendLocked(partition, key, payload));
+    }
+
+    /**
+     * ȡزɾһ¼
+     * @param partition 
+     * @param key 
+     * @param payload ڴ洢غɵ
+     * @return ¼Ƿ
+     */
+    bool Take(uint32_t partition, const TKey& key, std::string& payload) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto& index = _partitions.at(partition);
+        auto it = index.find(key);
+        if (it == index.end()) return false;
+        const Location location = it->second;
+        uint32_t recordPartition;
+        TKey recordKey;
+        ReadLocked(location, recordPartition, recordKey, payload);
+        index.erase(it);
+        DiscardLocked(location);
+        return true;
+    }
+
+    /**
+     * ɾһ¼
+     * @param partition 
+     * @param key 
+     * @return ¼Ƿ
+     */
+    bool Erase(uint32_t partition, const TKey& key) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto& index = _partitions.at(partition);
+        auto it = index.find(key);
+        if (it == index.end()) return false;
+        const Location location = it->second;
+        index.erase(it);
+        DiscardLocked(location);
+        return true;
+    }
+
+    /**
+     * ڵм¼صڼд洢
+     * @param partition 
+     * @param callback  void(const TKey&, const std::string&) Ļص
+     * @return ļ¼
+     */
+    template<typename Callback>
+    size_t ForEach(uint32_t partition, Callback&& callback) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        uint32_t recordPartition;
+        TKey key;
+        std::string payload;
+        for (const auto& entry : _partitions.at(partition)) {
+            ReadLocked(entry.second, recordPartition, key, payload);
+            callback(entry.first, payload);
+        }
+        return _partitions[partition].size();
+    }
+
+    /**
+     * ӻԾݱ͵ľɶ˳ȡ¼Աõļ¼ᵽǰ
+     * @param maxBytes ȡֽ
+     * @return ǷдĶ
+     */
+    bool CompactStep(uint64_t maxBytes) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        Segment* victim = nullptr;
+        uint32_t victimId = 0;
+        for (auto& segment : _segments) {
+            Segment& candidate = *segment.second;
+            if (segment.first == _activeSegment || candidate.liveBytes * 2 >= candidate.bytes) continue;
+            if (!victim || candidate.liveBytes * victim->bytes < victim->liveBytes * candidate.bytes) {
+                victim = &candidate;
+                victimId = segment.first;
+            }
+        }
+        if (!victim) return false;
+
+        uint32_t partition;
+        TKey key;
+        std::string payload;
+        uint64_t processed = 0;
+        while (processed < maxBytes && victim->compactOffset < victim->bytes) {
+            const uint64_t offset = victim->compactOffset;
+            const uint32_t size = ReadAtLocked(*victim, offset, partition, key, payload);
+            victim->compactOffset += size;
+            processed += size;
+            auto& index = _partitions.at(partition);
+            auto it = index.find(key);
+            if (it == index.end() || it->second.segment != victimId || it->second.offset != offset) continue;
+            it->second = AppendLocked(partition, key, payload);
+            // պ DiscardLocked ɾöΣvictim ֮ʧЧ
+            if (DiscardLocked(Location{ victimId, size, offset })) return true;
+        }
+        return true;
+    }
+
+    /**
+     * ȡ¼
+     */
+    size_t Size() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _count;
+    }
+
+    /**
+     * ȡжļֽ
+     */
+    uint64_t DiskBytes() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        uint64_t bytes = 0;
+        for (const auto& segment : _segments) bytes += segment.second->bytes;
+        return bytes;
+    }
+
+private:
+    /**
+     * ¶βΪǰ
+     */
+    void OpenSegmentLocked() {
+        const uint32_t id = _nextSegment++;
+        std::unique_ptr<Segment> segment(new Segment());
+        segment->path = _path + "." + std::to_string(id);
+        segment->file.open(segment->path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!segment->file.is_open()) throw std::runtime_error("Failed to create spill file: " + segment->path);
+        _segments.emplace(id, std::move(segment));
+        _activeSegment = id;
+    }
+
+    /**
+     * Ѽ¼׷ӵǰΣǰдʱл¶
+     */
+    Location AppendLocked(uint32_t partition, const TKey& key, const std::string& payload) {
+        if (_segments.at(_activeSegment)->bytes >= _segmentBytes) {
+            const uint32_t previous = _activeSegment;
+            OpenSegmentLocked();
+            Segment& old = *_segments.at(previous);
+            if (old.liveBytes == 0) RemoveSegmentLocked(previous);
+        }
+        _buffer.clear();
+        BinaryCodec<uint32_t>::Write(_buffer, 0);
+        BinaryCodec<uint32_t>::Write(_buffer, partition);
+        BinaryCodec<TKey>::Write(_buffer, key);
+        _buffer.append(payload);
+        const uint32_t size = static_cast<uint32_t>(_buffer.size());
+        std::memcpy(&_buffer[0], &size, sizeof(size));
+
+        Segment& segment = *_segments.at(_activeSegment);
+        segment.file.seekp(static_cast<std::streamoff>(segment.bytes));
+        segment.file.write(_buffer.data(), static_cast<std::streamsize>(_buffer.size()));
+        if (!segment.file) throw std::runtime_error("Failed to write spill file: " + segment.path);
+        const Location location{ _activeSegment, size, segment.bytes };
+        segment.bytes += size;
+        segment.liveBytes += size;
+        ++_count;
+        return location;
+    }
+
+    /**
+     * ȡָļ¼
+     */
+    void ReadLocked(const Location& location, uint32_t& partition, TKey& key, std::string& payload) {
+        ReadAtLocked(*_segments.at(location.segment), location.offset, partition, key, payload);
+    }
+
+    /**
+     * ȡָƫƴļ¼
+     * @return ¼ֽ
+     */
+    uint32_t ReadAtLocked(Segment& segment, uint64_t offset, uint32_t& partition, TKey& key, std::string& payload) {
+        using BinaryCodecUtils::ReadOrThrow;
+        uint32_t size = 0;
+        segment.file.seekg(static_cast<std::streamoff>(offset));
+        segment.file.read(reinterpret_cast<char*>(&size), sizeof(size));
+        if (!segment.file || size < sizeof(uint32_t) * 2 || offset + size > segment.bytes) {
+            throw std::runtime_error("Corrupted spill file: " + segment.path);
+        }
+        _buffer.resize(size - sizeof(size));
+        segment.file.read(&_buffer[0], static_cast<std::streamsize>(_buffer.size()));
+        if (!segment.file) throw std::runtime_error("Failed to read spill file: " + segment.path);
+
+        const char* p = _buffer.data();
+        const char* end = p + _buffer.size();
+        partition = ReadOrThrow<uint32_t>(p, end, "spill file");
+        key = ReadOrThrow<TKey>(p, end, "spill file");
+        payload.assign(p, end);
+        return size;
+    }
+
+    /**
+     * һ¼ΪǵǰεĻԾݹʱɾö
+     * @return Ƿɾ˶
+     */
+    bool DiscardLocked(const Location& location) {
+        --_count;
+        Segment& segment = *_segments.at(location.segment);
+        segment.liveBytes -= location.size;
+        if (segment.liveBytes != 0 || location.segment == _activeSegment) return false;
+        RemoveSegmentLocked(location.segment);
+        return true;
+    }
+
+    void RemoveSegmentLocked(uint32_t id) {
+        auto it = _segments.find(id);
+        it->second->file.close();
+        std::error_code ignored;
+        std::filesystem::remove(it->second->path, ignored);
+        _segments.erase(it);
+    }
+
+    std::string _path;                                          // ļ·ǰ׺
+    uint64_t _segmentBytes;                                     // ļĿС
+    std::vector<std::unordered_map<TKey, Location>> _partitions; // ļ
+    std::map<uint32_t, std::unique_ptr<Segment>> _segments;     // еĶ
+    uint32_t _activeSegment = 0;                                // ǰ׷дĶ
+    uint32_t _nextSegment = 0;                                  // һα
+    size_t _count = 0;                                          // ¼
+    std::string _buffer;                                        // д¼õĻ
+    mutable std::mutex _mutex;                                  // гԱ
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <unordered_map>
+#include <unordered_set>
 #include <queue>
 #include <mutex>
 #include <thread>
@@ -9,32 +10,164 @@
 #include <atomic>
 #include <functional>
 #include <memory>
+#include <iterator>
 #include <shared_mutex>
+#include <string>
+#include <vector>
+#include <type_traits>
+#include <fstream>
+#include <exception>
+#include <algorithm>
+#include <filesystem>
+#include <deque>
+#include <optional>
+#include <coroutine>
+#include <condition_variable>
+#include "BinaryCodec.hpp"
+#include "BroadcastRing.hpp"
+#include "ChunkedArray.hpp"
+#include "CounterTable.hpp"
+#include "EpochReclaimer.hpp"
+#include "FlatHashIndex.hpp"
+#include "HistoryArchive.hpp"
+#include "InplaceFunction.hpp"
+#include "InternTable.hpp"
+#include "LatencyHistogram.hpp"
+#include "NumaTopology.hpp"
+#include "SharedStateTable.hpp"
+#include "SpillStore.hpp"
+#include "StateSnapshot.hpp"
+#include "Task.hpp"
+#include "TransitionLog.hpp"
 
 /**
  * ͨ״̬ģֵּ֧࣬Թ״̬ʵ̰߳ȫ
+ * ״̬תԭפΪ32λţÿƬѼڰλŵУ
+ * ÿѰַλλʵǰλеĶ¼
+ * ʵƳɺ̨ɨ̭ѡ̣ճĲλ¼ã
+ * Ƭڴɰ NUMA ڵò渺¾⣻תصɸΪר̳߳첽Ͷݣ
+ * ĵǰ״̬ɾ񵽹ڴ棬ֻ
  * @tparam TKey ״̬ʵļ
  * @tparam TState ״ֱ̬֧ͣȽϲ
+ * @tparam THandler صĴ洢ͣǩʵ std::function
+ *                  ̶ InplaceFunction ֻƶ
  */
-template<typename TKey, typename TState>
+template<typename TKey, typename TState, template<typename> class THandler = std::function>
 class StateMachine {
 private:
+    static constexpr size_t ShardBits = 6;                    // Ƭλ
+    static constexpr size_t ShardCount = size_t(1) << ShardBits; // Ƭ
+    static constexpr uint32_t MaxSlotsPerShard = uint32_t(1) << (32 - ShardBits); // ƬĲλ
+    static constexpr uint32_t NoSlot = UINT32_MAX;            // ղλ
+    static constexpr uint32_t NoKeyId = UINT32_MAX;           // δ֪
+    static constexpr uint32_t NoStateId = UINT32_MAX;         // δ֪״̬ţʱʧ¼
+    static constexpr uint32_t NoTimeout = UINT32_MAX;         // δóʱ
+    // ״ֲ̬֣32λΪǰ״̬ţ32~34λΪ־λΪ汾
+    static constexpr uint64_t StateIdMask = 0xFFFFFFFFull;
+    static constexpr uint64_t SlowPathBit = uint64_t(1) << 32; // ˳ʱ첽תռṷֻ̂߼·
+    static constexpr uint64_t AccessedBit = uint64_t(1) << 33; // ʹ̭ɨʱָ뾭ʱ
+    static constexpr uint64_t EvictedBit = uint64_t(1) << 34;  // ʵƳλȴ
+    static constexpr uint64_t VersionUnit = uint64_t(1) << 35; // ÿ״̬汾żһ
+    static constexpr uint32_t VersionBits = 64 - 35;           // 汾ŵλ
+
+    /**
+     * ״̬ʵļ¼32ֽڣ״̬פűʾ
+     */
+    struct ContextRecord {
+        int64_t lastUpdated = 0;          // ʱ䣨system_clock 
+        uint32_t stateId = 0;             // ״̬״̬ţǰ״̬״̬Ϊ׼ӳٻſպһ
+        uint32_t timeoutMs = NoTimeout;   // ״̬ʱ
+        uint32_t fallbackStateId = 0;     // ʱĻ״̬
+        // ״̬ʽ˫ͷλڷƬ stateHeads
+        uint32_t prevInState = NoSlot;    // ͬ״̬ǰһλ
+        uint32_t nextInState = NoSlot;    // ͬ״̬ĺһλ
+        uint32_t generation = 0;          // λõĴ־ݴʶƳļ
+    };
+
+    /**
+     * յ״̬ʷĿ
+     */
+    struct HistoryEntry {
+        int64_t time;      // ʱ䣨system_clock 
+        uint32_t stateId;  // ״̬
+        uint32_t reasonId; // ԭ
+    };
+
+    /**
+     * ʵ״̬ʷﵽ HistoryLimit Ϊλ帲Ŀ
+     */
+    struct HistoryBuffer {
+        std::vector<HistoryEntry> entries; // ʷĿ
+        uint32_t oldest = 0;               // ʱĿλ
+
+        void Push(const HistoryEntry& entry, size_t limit) {
+            if (!entries.empty() && entry.time < Newest().time) {
+                InsertOrdered(entry, limit);
+                return;
+            }
+            if (entries.size() < limit) {
+                entries.push_back(entry);
+                return;
+            }
+            entries[oldest] = entry;
+            oldest = static_cast<uint32_t>((oldest + 1) % entries.size());
+        }
+
+        const HistoryEntry& Newest() const {
+            return entries[(oldest + entries.size() - 1) % entries.size()];
+        }
+
+        /**
+         * ʱǵĿӳٻ壩ʱɵĿ
+         */
+        void InsertOrdered(const HistoryEntry& entry, size_t limit) {
+            std::rotate(entries.begin(), entries.begin() + oldest, entries.end());
+            oldest = 0;
+            auto position = std::upper_bound(entries.begin(), entries.end(), entry.time,
+                [](int64_t time, const HistoryEntry& other) { return time < other.time; });
+            if (entries.size() >= limit) {
+                if (position == entries.begin()) return; // ȱĿ
+                position = entries.erase(entries.begin()) + (position - entries.begin() - 1);
+            }
+            entries.insert(position, entry);
+        }
+
+        template<typename Callback>
+        void ForEach(Callback&& callback) const {
+            for (size_t i = 0; i < entries.size(); ++i) {
+                callback(entries[(oldest + i) % entries.size()]);
+            }
+        }
+    };
+
     /**
-     * ״̬ʵϢ
+     * ״̬ƬÿƬӵжĶдͰλ洢ʵ
      */
-    struct StateContext {
-        TState currentState;                      // ǰ״̬
-        std::list<std::tuple<TState, std::chrono::system_clock::time_point, std::string>> history; // ״̬ʷ
-        std::chrono::system_clock::time_point lastUpdated; // ʱ
-        std::unique_ptr<std::chrono::milliseconds> timeout; // ״̬ʱʱ
-        std::unique_ptr<TState> fallbackState;     // ʱĻ״̬
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;            // Ƭд
+        uint32_t index = 0;                         // Ƭ
+        FlatHashIndex slots;                        // ϣλ
+        ChunkedArray<TKey> keys;                    // λ洢ļַȶ־·ɲȡ
+        ChunkedArray<std::atomic<uint64_t>> stateWords; // λ洢״̬֣·һ CAS ޸
+        std::vector<ContextRecord, NumaAllocator<ContextRecord>> records; // λ洢ļ¼
+        std::vector<std::unique_ptr<HistoryBuffer>> histories; // λ洢ʷ״תʱ
+        // ִ첽תĲλֵΪŶӵȴüЭ
+        std::unordered_map<uint32_t, std::deque<std::coroutine_handle<>>> reservations;
+        // ״̬ʵͷ״̬
+        std::vector<uint32_t> stateHeads;
+        // ƳʵĲλۼԪȫ뿪ӳٻſպת freeSlots
+        std::deque<std::pair<uint64_t, uint32_t>> retiredSlots;
+        std::deque<uint32_t> freeSlots;             // ɸõĲλȽȳԾƳٸ
+        uint32_t evictionCursor = 0;                // ̭ɨʱָ
+        std::atomic<int> node{ -1 };                // Ƭڴڵ NUMA ڵ㣬-1 ʾδ
+        std::atomic<uint64_t> callbackSequence{ 0 }; // 첽ص¼ķƬ
     };
 
     /**
      * ʱṹȼ
      */
     struct TimeoutTask {
-        TKey key;                              // ״̬
+        uint32_t keyId;                        // ״̬
         std::chrono::system_clock::time_point expireTime; // ʱ
         // رȽʹȼаʱ
         bool operator<(const TimeoutTask& other) const {
@@ -42,6 +175,130 @@ private:
         }
     };
 
+    /**
+     * ƻеĽռ¼״̬ʹϢפűʾ
+     */
+    struct AuditRecord {
+        int64_t timestamp;   // system_clock 
+        uint32_t keyId;      // 
+        uint32_t fromState;  // Դ״̬
+        uint32_t toState;    // Ŀ״̬
+        uint32_t errorId;    // Ϣţ0 ʾ޴
+        uint32_t reasonId;   // תԭţ0 ʾԭ
+        uint32_t generation; // ¼ʱλĸô
+        bool success;        // תǷɹ
+    };
+
+    /**
+     * ·ӳٲǵһת
+     */
+    struct DeferredTransition {
+        int64_t time;    // תʱ䣨system_clock 
+        uint32_t keyId;  // 
+        uint32_t fromId; // Դ״̬
+        uint32_t toId;   // Ŀ״̬
+    };
+
+    /**
+     * ̵߳ӳٻ壺߳д롢ſ߶ȡĵߵ߻
+     * ſ֮ drainMutex 
+     */
+    struct alignas(64) DeferredBuffer {
+        static constexpr uint32_t Capacity = 1024;
+        std::atomic<uint32_t> head{ 0 };          // ſ߶ȡλ
+        alignas(64) std::atomic<uint32_t> tail{ 0 }; // ߳дλ
+        std::mutex drainMutex;                    // ſջ
+        DeferredTransition entries[Capacity];     // ǵת
+    };
+
+    /**
+     * ȴ첽Ͷݵһת¼״̬Ϣפűʾ
+     * ڷƬͶ߳̾ݴ˻ָͬһƬͬһ¼ķ˳
+     */
+    struct CallbackRecord {
+        TKey key;           // ״̬
+        uint64_t sequence;  // Ƭ
+        int64_t timestamp;  // ʱ䣨system_clock 
+        uint32_t shard;     // Ƭ
+        uint32_t fromId;    // Դ״̬ţNoStateId ʾ
+        uint32_t toId;      // Ŀ״̬
+        uint32_t errorId;   // ʧʱĴϢ
+        bool success;       // Ƿύ
+    };
+
+    /**
+     * ̵߳Ļص¼壺߳д롢Ͷ̶߳ȡĵߵ߻
+     */
+    struct alignas(64) CallbackBuffer {
+        static constexpr uint32_t Capacity = 1024;
+        std::atomic<uint32_t> head{ 0 };             // Ͷ̶߳ȡλ
+        alignas(64) std::atomic<uint32_t> tail{ 0 }; // ߳дλ
+        CallbackRecord records[Capacity];            // Ͷݵ¼
+    };
+
+    /**
+     * Ϸ״̬תԴ״̬Ŀ״̬бֻ
+     * ״̬ͨ٣ֻһ±ʺһбڵĲ
+     */
+    struct TransitionTable {
+        std::vector<std::vector<uint32_t>> targets; // Դ״̬ -> Ŀ״̬б
+
+        bool Allows(uint32_t fromId, uint32_t toId) const {
+            if (fromId >= targets.size()) return false;
+            const auto& list = targets[fromId];
+            return std::binary_search(list.begin(), list.end(), toId);
+        }
+
+        bool Add(uint32_t fromId, uint32_t toId) {
+            if (fromId >= targets.size()) targets.resize(fromId + 1);
+            auto& list = targets[fromId];
+            auto it = std::lower_bound(list.begin(), list.end(), toId);
+            if (it != list.end() && *it == toId) return false;
+            list.insert(it, toId);
+            return true;
+        }
+
+        bool Remove(uint32_t fromId, uint32_t toId) {
+            if (fromId >= targets.size()) return false;
+            auto& list = targets[fromId];
+            auto it = std::lower_bound(list.begin(), list.end(), toId);
+            if (it == list.end() || *it != toId) return false;
+            list.erase(it);
+            return true;
+        }
+    };
+
+    /**
+     * ӿսʵƬǰݴ
+     */
+    struct DecodedContext {
+        TKey key;                               // ״̬
+        size_t hash = 0;                        // Ĺϣ
+        ContextRecord record;                   // ļ¼
+        std::unique_ptr<HistoryBuffer> history; // ״̬ʷ
+    };
+
+    /**
+     * תһ߳ϵͳ
+     */
+    struct EdgeMetrics {
+        LatencyHistogram latency;              // ·ϳɹתĺʱ룩
+        std::atomic<uint64_t> fastPath{ 0 };   // ·ϳɹתĴ
+        std::atomic<uint64_t> failures{ 0 };   // ʧܴ
+    };
+
+    /**
+     * ̵߳ͳƣֻ߳д룬ȡʱ̺߳ϲ·ûйļ
+     */
+    struct alignas(64) ThreadMetrics {
+        std::atomic<uint64_t> total{ 0 };      // ״̬ת
+        std::atomic<uint64_t> successful{ 0 }; // ɹת
+        std::atomic<uint64_t> failed{ 0 };     // ʧת
+        ChunkedArray<EdgeMetrics, 4> edges;    // ת߱
+        ChunkedArray<LatencyHistogram, 4> dwell; // ״̬ͣʱ룩
+    };
+
+public:
     /**
      * ־Ŀṹ
      */
@@ -54,32 +311,217 @@ private:
         std::string error;      // ϢУ
     };
 
+    // ־ȡα꣬ÿ߸һ
+    typedef typename BroadcastRing<AuditRecord>::Cursor AuditCursor;
+
+    /**
+     * 첽תѱ첽תռʱĴʽ
+     */
+    enum class ReservationPolicy {
+        FailFast, // ʧ
+        Queue     // Ŷӣռ̣߳ǰһ첽תɺ
+    };
+
+    /**
+     * תͳƿգ GetMetrics ̺߳ϲõ
+     */
+    struct TransitionMetrics {
+        /**
+         * һתߣԴ״̬Ŀ״̬ͳ
+         */
+        struct Edge {
+            TState from;               // Դ״̬
+            TState to;                 // Ŀ״̬
+            HistogramSnapshot latency; // ·ϳɹתĺʱ룩תȴԤд־
+            uint64_t fastPath = 0;     // ·ϳɹתĴƺʱǺ룩
+            uint64_t failures = 0;     // ת׳쳣ύĴ
+        };
+
+        /**
+         * һ״̬ͣʱͳ
+         */
+        struct Dwell {
+            TState state;              // ״̬
+            HistogramSnapshot dwell;   // ʵ뿪״̬ǰͣʱ룩
+        };
+
+        uint64_t totalTransitions = 0;      // ״̬ת
+        uint64_t successfulTransitions = 0; // ɹת
+        uint64_t failedTransitions = 0;     // ʧת
+        uint64_t evictedKeys = 0;           // ̭ʵ
+        uint64_t reloadedKeys = 0;          // ļʵ
+        std::vector<Edge> edges;            // йתı
+        std::vector<Dwell> states;          // ʵ뿪״̬
+    };
+
+    /**
+     * ʵ̭ѡ
+     */
+    struct EvictionOptions {
+        // ̬б̬ҿг terminalTtl ʵ̭
+        std::vector<TState> terminalStates;
+        // ̬ʵĿʱ0 ʾʱ̭
+        std::chrono::milliseconds terminalTtl{ 0 };
+        // פʵޣʱ LRUʱ㷨̭0 ʾ
+        size_t maxResidentKeys = 0;
+        // ļ·ǰ׺̭ʵдļ´ηʱ룻ΪʱֱӶ
+        std::string spillPath;
+        // ɨļ
+        std::chrono::milliseconds scanInterval{ 100 };
+        // ÿɨĲλ̯ƬÿƬÿֻһд
+        size_t scanBatch = 4096;
+    };
+
+    /**
+     * һУʼ״̬ѡĳʱ
+     */
+    struct BulkLoadEntry {
+        TKey key;                                // ״̬
+        TState state;                            // ʼ״̬
+        std::chrono::milliseconds timeout{ -1 }; // ״̬ʱʾ
+        TState fallbackState{};                  // ʱĻ״̬
+    };
+
+    /**
+     * дŵݣаж룬ڴɵ÷
+     */
+    struct BulkLoadColumns {
+        const TKey* keys = nullptr;             // 
+        const TState* states = nullptr;         // ʼ״̬
+        const int64_t* timeoutsMs = nullptr;    // ѡʱУʾвóʱ
+        const TState* fallbackStates = nullptr; // ѡ״̬Уṩʱʱṩ
+        size_t count = 0;                       // 
+    };
+
+    /**
+     * NUMA ѡ
+     */
+    struct NumaOptions {
+        // õĽڵ㣬Ϊʱʹȫڵ
+        std::vector<uint32_t> nodes;
+        // ¾Ľڵ䳣פʵ֮ռÿڵƽʵı
+        double rebalanceTolerance = 0.1;
+    };
+
+    /**
+     * 첽Ͷݸߵһת¼
+     */
+    struct TransitionEvent {
+        TKey key;                                        // ״̬
+        TState fromState;                                // Դ״̬ʱΪĬֵ
+        TState toState;                                  // Ŀ״̬
+        bool success;                                    // Ƿύ
+        std::string error;                               // ʧʱ쳣Ϣ
+        std::chrono::system_clock::time_point timestamp; // ʱ
+    };
+
+    /**
+     * 첽صѡ
+     */
+    struct CallbackOptions {
+        size_t maxBatchSize = 1024; // νߵ¼
+        // Ͷ̵߳ȴʱ䣬ĳ̵߳¼ʱǰ
+        std::chrono::milliseconds flushInterval{ 10 };
+    };
+
+private:
+    static constexpr size_t AuditLogCapacity = 16384; // ƻ
+    static constexpr size_t MaxAuditMessages = 4096;  // פĴϢ
+    static constexpr size_t HistoryLimit = 100;       // ÿʷ¼
+    static constexpr uint64_t SpillCompactBytes = uint64_t(4) << 20; // ÿɨļֽ
+
     // ݽṹ
-    std::unordered_map<TKey, StateContext> _states; // ״̬ʵӳ
-    std::unordered_map<TKey, std::shared_mutex> _keyLocks; // ÿĶд
-    std::unordered_map<TState, std::unordered_set<TState>> _transitions; // Ϸ״̬ת
-    std::queue<AuditLogEntry> _auditLog; // ־
-    std::mutex _auditLogMutex; // ־
+    std::unique_ptr<Shard[]> _shards{ new Shard[ShardCount] }; // ״̬ʵƬ
+    std::atomic<const TransitionTable*> _transitions{ new TransitionTable() }; // ǰתգ߲
+    std::mutex _transitionsWriteMutex; // лת滻
+    mutable EpochReclaimer _reclaimer; // ձ滻תƬľͰ
+    BroadcastRing<AuditRecord> _auditLog{ AuditLogCapacity }; // ־
+    InternTable<TState> _stateIds; // ״̬פ
+    InternTable<std::string> _messageIds; // Ϣפ
+    InternTable<std::string> _reasonIds; // תԭפʷ¼Ԥд־ʹ
+    CounterTable _stateCounts; // ״̬ͳƵʵ
+    std::unique_ptr<TransitionLog<TKey, TState>> _wal; // ״̬תԤд־δʱΪգ
+    std::unique_ptr<SharedStateWriter<TKey, TState>> _sharedState; // ״̬δʱΪգ
+    std::mutex _sharedStateMutex; // л״̬״̬ķ
+    AuditCursor _defaultAuditCursor; // GetAuditLogs() ʹõĬα
+    std::mutex _defaultAuditCursorMutex; // Ĭα껥
+    std::thread _auditStreamer; // ־߳
+    std::atomic<bool> _stopAuditStreamer{ false }; // ֹ߳ͣ־
+    std::thread _historyArchiver; // ʷ鵵߳
+    std::atomic<bool> _stopHistoryArchiver{ false }; // 鵵ֹ߳ͣ־
     std::priority_queue<TimeoutTask> _timeoutQueue; // ʱȼ
     std::mutex _timeoutQueueMutex; // ʱл
     std::thread _timeoutScanner; // ʱɨ߳
     std::atomic<bool> _stopScanner{ false }; // ɨֹ߳ͣ־
 
+    ChunkedArray<DeferredBuffer, 2> _deferred; // ̱߳Ŀ·ӳٻ
+    std::atomic<uint32_t> _deferredCount{ 0 }; // ʹõӳٻ
+    std::once_flag _drainerStarted; // ״ʹÿ·ʱſ߳
+    std::thread _drainer; // ӳٻſ߳
+    std::mutex _drainerMutex; // ſ̵߳ȴû
+    std::condition_variable _drainerWake; // ʱſ߳
+    bool _stopDrainer = false; // ſֹ߳ͣ־ _drainerMutex 
+
+    std::unique_ptr<SpillStore<TKey>> _spill; // ̭ʵ洢δʱΪգ
+    EvictionOptions _evictionOptions; // ̭ѡ̶ֻ̭߳ȡ
+    std::vector<uint32_t> _terminalIds; // ̬ţ
+    std::atomic<size_t> _residentKeys{ 0 }; // פʵ
+    std::thread _evictor; // ̭ɨ߳
+    std::mutex _evictorMutex; // ̵̭߳ȴû
+    std::condition_variable _evictorWake; // ֹͣʱ̭߳
+    bool _stopEvictor = false; // ֹ̭߳ͣ־ _evictorMutex 
+
     // ܼ
-    std::atomic<uint64_t> _totalTransitions{ 0 }; // ״̬ת
-    std::atomic<uint64_t> _successfulTransitions{ 0 }; // ɹת
-    std::atomic<uint64_t> _failedTransitions{ 0 }; // ʧת
+    ChunkedArray<ThreadMetrics, 2> _metrics; // ̱߳ͳ
+    std::atomic<uint32_t> _metricsCount{ 0 }; // ʹõͳƲ
+    InternTable<uint64_t> _edgeIds; // תߣԴ״̬ << 32 | Ŀ״̬ţפ
+    std::atomic<uint64_t> _evictedKeys{ 0 }; // ̭ʵ
+    std::atomic<uint64_t> _reloadedKeys{ 0 }; // ļʵ
+
+    std::mutex _numaMutex; // л NUMA ¾
+    std::vector<int> _numaNodes; // õĽڵ㣬δʱΪ
+    double _numaTolerance = 0.1; // ¾ݲ
+
+    std::atomic<bool> _asyncCallbacks{ false }; // Ƿ첽Ͷתص
+    ChunkedArray<CallbackBuffer, 2> _callbackBuffers; // ̱߳Ļص¼
+    std::atomic<uint32_t> _callbackBufferCount{ 0 }; // ʹõĻص¼
+    std::mutex _callbackControlMutex; // л첽صͣ
+    CallbackOptions _callbackOptions; // 첽صѡͶ߳ڼֻ
+    std::thread _callbackExecutor; // صͶ߳
+    std::mutex _callbackWakeMutex; // Ͷ̵߳ȴû
+    std::condition_variable _callbackWake; // дʱͶ߳
+    bool _stopCallbacks = false; // Ͷֹ߳ͣ־ _callbackWakeMutex 
+    // ֻͶ̣߳ͣúĵ÷
+    std::vector<uint64_t> _callbackNext; // ƬһͶ
+    std::vector<std::vector<CallbackRecord>> _callbackHeld; // Ƭݴ桢ȴǰ¼¼
 
 public:
     // ״̬ת¼Ͷ
-    typedef std::function<void(const TKey&, const TState&, const TState&)> TransitionEventHandler;
+    typedef THandler<void(const TKey&, const TState&, const TState&)> TransitionEventHandler;
     // ״̬תʧܴͶ
-    typedef std::function<void(const TKey&, const TState&, const TState&, const std::exception&)> TransitionFailedHandler;
+    typedef THandler<void(const TKey&, const TState&, const TState&, const std::exception&)> TransitionFailedHandler;
+    // ת¼Ͷ
+    typedef THandler<void(const std::vector<TransitionEvent>&)> TransitionBatchHandler;
+
+private:
+    // 䡢б֮乲滻бʱҪɸ
+    typedef std::vector<std::pair<uint64_t, std::shared_ptr<const TransitionBatchHandler>>> SubscriberList;
+    std::shared_ptr<const SubscriberList> _subscribers{ std::make_shared<SubscriberList>() }; // ¼ߣ滻
+    uint64_t _nextSubscriberId = 1; // һı
+    std::mutex _subscriberMutex; // бָ붩ı
+
+public:
 
     /**
      * 캯ʼʱɨ߳
      */
     StateMachine() {
+        for (size_t i = 0; i < ShardCount; ++i) {
+            _shards[i].index = static_cast<uint32_t>(i);
+            _shards[i].slots.SetReclaimer(&_reclaimer);
+        }
+        _messageIds.Intern(std::string()); // 0޴
+        _reasonIds.Intern(std::string()); // 0Ϊԭ򣬿·ʹ
         _timeoutScanner = std::thread(&StateMachine::CheckTimeouts, this);
     }
 
@@ -87,10 +529,23 @@ public:
      * ֹͣʱɨ̲߳ȴ
      */
     ~StateMachine() {
+        DisableAsyncCallbacks();
+        StopAuditStream();
+        StopHistoryArchive();
+        DisableEviction();
+        {
+            std::lock_guard<std::mutex> lock(_drainerMutex);
+            _stopDrainer = true;
+        }
+        _drainerWake.notify_one();
+        if (_drainer.joinable()) {
+            _drainer.join();
+        }
         _stopScanner.store(true);
         if (_timeoutScanner.joinable()) {
             _timeoutScanner.join();
         }
+        delete _transitions.load();
     }
 
     /**
@@ -99,20 +554,127 @@ public:
      * @param initialState ʼ״̬
      */
     void InitializeState(const TKey& key, const TState& initialState) {
-        std::lock_guard<std::mutex> lock(GetKeyLock(key));
-        StateContext context;
-        context.currentState = initialState;
-        context.lastUpdated = std::chrono::system_clock::now();
-        _states[key] = context;
+        ContextRecord record;
+        record.stateId = _stateIds.Intern(initialState);
+        record.lastUpdated = std::chrono::system_clock::now().time_since_epoch().count();
+        const size_t hash = std::hash<TKey>{}(key);
+        Shard& shard = ShardOf(hash);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        UpsertContextLocked(shard, key, hash, record, nullptr);
+    }
+
+    /**
+     * ʼ״̬ʵʱݿ
+     * Ȳмϣ밴Ƭȶ֣סȫƬƬд룻дʵȶأ
+     * ȫƬдͳһҿͷκζҪôݣҪôȫ
+     * ͬһֶʱһΪ׼Ѵڵļǣдڼ״̬ȴ
+     * @param first ʼԪΪ BulkLoadEntryʵȸһ
+     * @param last 
+     * @param threadCount ߳0 ʾʹӲ
+     * @return 
+     */
+    template<typename Iterator>
+    size_t BulkLoad(Iterator first, Iterator last, size_t threadCount = 0) {
+        using Traits = std::iterator_traits<Iterator>;
+        if constexpr (std::is_base_of_v<std::random_access_iterator_tag, typename Traits::iterator_category>
+            && std::is_lvalue_reference_v<typename Traits::reference>) {
+            return BulkLoadRows(static_cast<size_t>(last - first), threadCount,
+                [&](size_t row) -> const TKey& { return first[row].key; },
+                [&](size_t row, ContextRecord& record) {
+                    const BulkLoadEntry& entry = first[row];
+                    FillBulkRecord(record, entry.state, entry.timeout.count(), &entry.fallbackState);
+                });
+        }
+        else {
+            std::vector<BulkLoadEntry> entries(first, last);
+            return BulkLoad(entries.cbegin(), entries.cend(), threadCount);
+        }
+    }
+
+    /**
+     * Ӱдŵʼ״̬ʵͬ汾
+     * @param columns 
+     * @param threadCount ߳0 ʾʹӲ
+     * @return 
+     */
+    size_t BulkLoad(const BulkLoadColumns& columns, size_t threadCount = 0) {
+        if (columns.count && (!columns.keys || !columns.states)) {
+            throw std::invalid_argument("Bulk load requires key and state columns");
+        }
+        if (columns.timeoutsMs && !columns.fallbackStates) {
+            throw std::invalid_argument("Bulk load timeouts require a fallback state column");
+        }
+        return BulkLoadRows(columns.count, threadCount,
+            [&](size_t row) -> const TKey& { return columns.keys[row]; },
+            [&](size_t row, ContextRecord& record) {
+                const int64_t timeout = columns.timeoutsMs ? columns.timeoutsMs[row] : -1;
+                FillBulkRecord(record, columns.states[row], timeout,
+                    columns.fallbackStates ? &columns.fallbackStates[row] : nullptr);
+            });
     }
 
     /**
-     * ӺϷ״̬ת
+     * ӺϷ״̬ת򣬿ڼת
      * @param from Դ״̬
      * @param to Ŀ״̬
      */
     void AddTransition(const TState& from, const TState& to) {
-        _transitions[from].insert(to);
+        const uint32_t fromId = _stateIds.Intern(from);
+        const uint32_t toId = _stateIds.Intern(to);
+        std::lock_guard<std::mutex> lock(_transitionsWriteMutex);
+        const TransitionTable* current = _transitions.load();
+        if (current->Allows(fromId, toId)) return;
+        std::unique_ptr<TransitionTable> table(new TransitionTable(*current));
+        table->Add(fromId, toId);
+        PublishTransitionsLocked(std::move(table));
+    }
+
+    /**
+     * Ƴһ״̬ת򣬿ڼת
+     * ͨϷԼ顢ִжתӰ
+     * @param from Դ״̬
+     * @param to Ŀ״̬
+     * @return Ƿ
+     */
+    bool RemoveTransition(const TState& from, const TState& to) {
+        uint32_t fromId, toId;
+        if (!_stateIds.TryGetId(from, fromId) || !_stateIds.TryGetId(to, toId)) return false;
+        std::lock_guard<std::mutex> lock(_transitionsWriteMutex);
+        const TransitionTable* current = _transitions.load();
+        if (!current->Allows(fromId, toId)) return false;
+        std::unique_ptr<TransitionTable> table(new TransitionTable(*current));
+        table->Remove(fromId, toId);
+        PublishTransitionsLocked(std::move(table));
+        return true;
+    }
+
+    /**
+     * һ滻תһԭӷתῴ¾ɹϵм״̬
+     * @param transitions (Դ״̬, Ŀ״̬) б
+     */
+    void ReplaceTransitions(const std::vector<std::pair<TState, TState>>& transitions) {
+        std::unique_ptr<TransitionTable> table(new TransitionTable());
+        for (const auto& transition : transitions) {
+            table->Add(_stateIds.Intern(transition.first), _stateIds.Intern(transition.second));
+        }
+        std::lock_guard<std::mutex> lock(_transitionsWriteMutex);
+        PublishTransitionsLocked(std::move(table));
+    }
+
+    /**
+     * ȡǰȫ״̬ת
+     * @return (Դ״̬, Ŀ״̬) б
+     */
+    std::vector<std::pair<TState, TState>> GetTransitions() const {
+        std::vector<std::pair<TState, TState>> transitions;
+        auto guard = _reclaimer.Pin();
+        const TransitionTable* table = _transitions.load();
+        for (uint32_t fromId = 0; fromId < table->targets.size(); ++fromId) {
+            for (const uint32_t toId : table->targets[fromId]) {
+                transitions.emplace_back(_stateIds.Resolve(fromId), _stateIds.Resolve(toId));
+            }
+        }
+        return transitions;
     }
 
     /**
@@ -128,26 +690,35 @@ public:
     bool Transition(const TKey& key, const TState& toState,
         TransitionAction&& transitionAction,
         const std::string& reason = "") {
-        auto startTime = std::chrono::high_resolution_clock::now();
-        _totalTransitions++;
+        const auto startTime = std::chrono::steady_clock::now();
+        ThreadMetrics& metrics = LocalMetrics();
+        LatencyHistogram::Increment(metrics.total);
+        // Ŀ״̬δתʱܺϷ
+        uint32_t toId;
+        if (!_stateIds.TryGetId(toState, toId)) return false;
+
+        const size_t hash = std::hash<TKey>{}(key);
+        Shard& shard = ShardOf(hash);
+        uint64_t keyRef = NoKeyId;
+        uint32_t fromId = 0;
 
         try {
             // Ȼȡ״̬
-            std::shared_lock<std::shared_mutex> lock(GetKeyLock(key));
-            auto it = _states.find(key);
-            if (it == _states.end()) return false;
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            uint32_t slot;
+            if (!FindOrReload(shard, key, hash, slot, lock) || IsReserved(shard, slot)) return false;
 
-            StateContext& context = it->second;
-            const TState originalState = context.currentState;
+            keyRef = MakeKeyRef(shard, slot);
+            uint64_t observed = shard.stateWords[slot].load();
+            fromId = StateOf(observed);
 
             // ǷΪϷת
-            if (!_transitions.count(originalState) ||
-                _transitions[originalState].count(toState) == 0) {
-                return false;
-            }
+            if (!IsAllowed(fromId, toId)) return false;
 
             lock.unlock();
 
+            const TState& originalState = _stateIds.Resolve(fromId);
+
             // ִǰûصУ
             if (_onBeforeTransition) _onBeforeTransition(key, originalState, toState);
 
@@ -156,60 +727,185 @@ public:
                 transitionAction(key, originalState, toState);
             }
             catch (const std::exception& ex) {
-                _failedTransitions++;
-                RecordAudit(key, originalState, toState, false, ex.what());
-                if (_onTransitionFailed) _onTransitionFailed(key, originalState, toState, ex);
+                LatencyHistogram::Increment(metrics.failed);
+                RecordEdgeFailure(metrics, fromId, toId);
+                RecordAudit(keyRef, fromId, toId, false, ex.what());
+                NotifyFailure(shard, key, fromId, toId, ex);
                 return false;
             }
 
-            // ˫ؼȡ״̬
-            std::unique_lock<std::shared_mutex> ulock(GetKeyLock(key));
-            // ״̬Ƿ߳޸
-            if (it->second.currentState != originalState) return false;
-
-            // ¼״̬ʷ
-            context.history.emplace_back(toState, std::chrono::system_clock::now(), reason);
-            // µǰ״̬
-            context.currentState = toState;
-            // ʱ
-            context.lastUpdated = std::chrono::system_clock::now();
-
-            // ˳ʱųʱ
-            if (context.timeout) {
-                ScheduleTimeout(key, *context.timeout);
+            // ˫ؼȡ״̬£״ֵ̬İ汾仯˵ڼ䱻߳޸Ĺ
+            std::unique_lock<std::shared_mutex> ulock(shard.mutex);
+            uint64_t lsn = 0;
+            if (!RelocateEvictedLocked(shard, key, hash, slot, observed) || IsReserved(shard, slot)
+                || !CommitTransitionLocked(shard, slot, key, observed, toId, reason, lsn)) {
+                return false;
             }
 
-            // ¼־
-            RecordAudit(key, originalState, toState, true, "");
+            // 첽صʱдȡ¼ţͷд¼壻ִкûصУ
+            std::optional<CallbackRecord> event;
+            if (_asyncCallbacks.load(std::memory_order_relaxed)) event = MakeCallbackRecord(shard, key, fromId, toId, true);
+            else if (_onAfterTransition) _onAfterTransition(key, originalState, toState);
 
-            // ִкûصУ
-            if (_onAfterTransition) _onAfterTransition(key, originalState, toState);
+            // ͷŷƬٵȴύ̣ȴ maxCommitLatency
+            ulock.unlock();
+            if (event) EnqueueCallback(std::move(*event));
+            if (lsn) _wal->WaitDurable(lsn);
 
-            _successfulTransitions++;
+            LatencyHistogram::Increment(metrics.successful);
+            RecordEdgeLatency(metrics, fromId, toId, startTime);
             return true;
         }
         catch (const std::exception& ex) {
-            _failedTransitions++;
-            RecordAudit(key, {}, toState, false, ex.what());
-            if (_onTransitionFailed) _onTransitionFailed(key, {}, toState, ex);
+            LatencyHistogram::Increment(metrics.failed);
+            const bool known = keyRef != NoKeyId;
+            if (known) RecordEdgeFailure(metrics, fromId, toId);
+            RecordAudit(keyRef, fromId, toId, false, ex.what());
+            NotifyFailure(shard, key, known ? fromId : NoStateId, toId, ex);
             return false;
         }
     }
 
+    /**
+     * ִвת״̬ת
+     * δǰûصδ첽صԤд־δóʱδ첽תռʱ·
+     * λϷԼ״̬һ CAS лʷơ״̬
+     * д뱾̵߳ӳٻ壬ɺ̨ſ̲߳ǣдʱɱ̲߳ǣҲɵ FlushDeferredTransitions
+     * ˻ؼ·
+     * @param key ״̬
+     * @param toState Ŀ״̬
+     * @return תǷɹ
+     */
+    bool Transition(const TKey& key, const TState& toState) {
+        if (!_wal && !_onBeforeTransition && !_onAfterTransition && !_asyncCallbacks.load(std::memory_order_relaxed)) {
+            switch (TryFastTransition(key, toState)) {
+            case FastPathResult::Committed: return true;
+            case FastPathResult::Rejected: return false;
+            case FastPathResult::Fallback: break;
+            }
+        }
+        return Transition(key, toState, [](auto&&...) {});
+    }
+
+    /**
+     * ߳ӳٻеĿ·תʷơ״̬
+     */
+    void FlushDeferredTransitions() {
+        const uint32_t count = _deferredCount.load();
+        for (uint32_t i = 0; i < count; ++i) {
+            // ̱߳ڽڷ䣬ŽС߳δù״̬
+            if (_deferred.IsAllocated(i)) DrainDeferredBuffer(_deferred[i]);
+        }
+    }
+
+    /**
+     * ִ첽״̬תתǿ co_await Э̣ȴ I/O
+     * ִڼ߼ռãͬ Transition ʧܣ첽ת policy ʧܻŶӣ
+     * ڼ䲻ռκ̡߳ͬ汾һ£쳣ᴥʧܻص false
+     * ȴԤд־̣Ҫʱɵ FlushWal
+     * @tparam AsyncAction  Task<void>(const TKey&, const TState&, const TState&) Ķ
+     * @param key ״̬
+     * @param toState Ŀ״̬
+     * @param action 첽ת
+     * @param reason ״̬תԭڼ¼ʷ
+     * @param policy ѱռʱĴʽ
+     * @return ɵȴת
+     */
+    template<typename AsyncAction>
+    Task<bool> TransitionAsync(TKey key, TState toState, AsyncAction action,
+        std::string reason = "", ReservationPolicy policy = ReservationPolicy::FailFast) {
+        // Э̿߳ϻָÿμȡǰ̵߳ͳƲ
+        const auto startTime = std::chrono::steady_clock::now();
+        LatencyHistogram::Increment(LocalMetrics().total);
+        uint32_t toId;
+        if (!_stateIds.TryGetId(toState, toId)) co_return false;
+
+        const size_t hash = std::hash<TKey>{}(key);
+        Shard& shard = ShardOf(hash);
+        uint32_t slot, generation;
+        {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            if (!FindOrReload(shard, key, hash, slot, lock)) co_return false;
+            generation = shard.records[slot].generation;
+        }
+
+        if (!co_await ReservationAwaiter{ &shard, slot, generation, policy }) co_return false;
+
+        // ռøü·ѱ״̬ϵ·־ס̭ɨҲ鵱ǰ״̬תϷ
+        uint64_t observed, keyRef;
+        {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            observed = shard.stateWords[slot].load();
+            keyRef = MakeKeyRef(shard, slot);
+        }
+        const uint32_t fromId = StateOf(observed);
+        if (!IsAllowed(fromId, toId)) {
+            ReleaseReservation(shard, slot);
+            co_return false;
+        }
+        const TState& originalState = _stateIds.Resolve(fromId);
+
+        std::exception_ptr failure;
+        try {
+            if (_onBeforeTransition) _onBeforeTransition(key, originalState, toState);
+            co_await action(key, originalState, toState);
+        }
+        catch (...) {
+            failure = std::current_exception();
+        }
+
+        bool committed = false;
+        std::optional<CallbackRecord> event;
+        if (!failure) {
+            std::unique_lock<std::shared_mutex> ulock(shard.mutex);
+            try {
+                uint64_t lsn;
+                if (CommitTransitionLocked(shard, slot, key, observed, toId, reason, lsn)) {
+                    if (_asyncCallbacks.load(std::memory_order_relaxed)) event = MakeCallbackRecord(shard, key, fromId, toId, true);
+                    else if (_onAfterTransition) _onAfterTransition(key, originalState, toState);
+                    committed = true;
+                }
+            }
+            catch (...) {
+                failure = std::current_exception();
+            }
+        }
+        ReleaseReservation(shard, slot);
+        if (event) EnqueueCallback(std::move(*event));
+
+        ThreadMetrics& metrics = LocalMetrics();
+        if (failure) {
+            LatencyHistogram::Increment(metrics.failed);
+            RecordEdgeFailure(metrics, fromId, toId);
+            ReportFailure(shard, key, keyRef, fromId, toId, failure);
+            co_return false;
+        }
+        if (committed) {
+            LatencyHistogram::Increment(metrics.successful);
+            RecordEdgeLatency(metrics, fromId, toId, startTime);
+        }
+        co_return committed;
+    }
+
     /**
      * ״̬ʱ
      * @param key ״̬
-     * @param timeout ʱʱ
+     * @param timeout ʱʱ䣬Լ49ʱ޴
      * @param fallbackState ʱԶתĻ״̬
      */
     void SetTimeout(const TKey& key, std::chrono::milliseconds timeout, const TState& fallbackState) {
-        std::unique_lock<std::shared_mutex> lock(GetKeyLock(key));
-        auto it = _states.find(key);
-        if (it == _states.end()) throw std::out_of_range("Key not found");
+        const uint32_t fallbackId = _stateIds.Intern(fallbackState);
+        const size_t hash = std::hash<TKey>{}(key);
+        Shard& shard = ShardOf(hash);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        uint32_t slot;
+        if (!FindOrReloadLocked(shard, key, hash, slot)) throw std::out_of_range("Key not found");
 
-        it->second.timeout.reset(new std::chrono::milliseconds(timeout));
-        it->second.fallbackState.reset(new TState(fallbackState));
-        ScheduleTimeout(key, timeout);
+        ContextRecord& record = shard.records[slot];
+        record.timeoutMs = static_cast<uint32_t>(std::clamp<int64_t>(timeout.count(), 0, NoTimeout - 1));
+        record.fallbackStateId = fallbackId;
+        RefreshSlowPathLocked(shard, slot);
+        ScheduleTimeout(MakeKeyId(shard, slot), std::chrono::milliseconds(record.timeoutMs));
     }
 
     /**
@@ -218,158 +914,2070 @@ public:
      * @return ״̬ʷб
      */
     std::list<std::tuple<TState, std::chrono::system_clock::time_point, std::string>> GetStateHistory(const TKey& key) {
-        std::shared_lock<std::shared_mutex> lock(GetKeyLock(key));
-        auto it = _states.find(key);
-        if (it != _states.end()) {
-            return it->second.history;
-        }
-        return {};
+        using Clock = std::chrono::system_clock;
+        std::list<std::tuple<TState, Clock::time_point, std::string>> history;
+        FlushDeferredTransitions();
+        const size_t hash = std::hash<TKey>{}(key);
+        Shard& shard = ShardOf(hash);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        uint32_t slot;
+        if (!FindOrReload(shard, key, hash, slot, lock) || !shard.histories[slot]) return history;
+        shard.histories[slot]->ForEach([&](const HistoryEntry& entry) {
+            history.emplace_back(_stateIds.Resolve(entry.stateId), Clock::time_point(Clock::duration(entry.time)),
+                _reasonIds.Resolve(entry.reasonId));
+        });
+        return history;
     }
 
     /**
-     * ȡ־
+     * ȡ־ʹڲĬα꣬ÿ¼ֻһΣ
      * @return ־б
      */
     std::list<AuditLogEntry> GetAuditLogs() {
-        std::lock_guard<std::mutex> lock(_auditLogMutex);
-        std::list<AuditLogEntry> logs;
-        while (!_auditLog.empty()) {
-            logs.push_back(_auditLog.front());
-            _auditLog.pop();
-        }
-        return logs;
+        FlushDeferredTransitions();
+        std::lock_guard<std::mutex> lock(_defaultAuditCursorMutex);
+        return GetAuditLogs(_defaultAuditCursor);
     }
 
     /**
-     * Իȡǰ״̬
-     * @param key ״̬
-     * @param state ڴ洢״̬
-     * @return Ƿɹȡ״̬
+     * һ־α꣬ӵǰɵĿɶ¼ʼ
+     * @return ־α
      */
-    bool TryGetCurrentState(const TKey& key, TState& state) {
-        std::shared_lock<std::shared_mutex> lock(GetKeyLock(key));
-        auto it = _states.find(key);
-        if (it != _states.end()) {
-            state = it->second.currentState;
-            return true;
-        }
-        return false;
+    AuditCursor OpenAuditCursor() const {
+        return _auditLog.OpenCursor();
     }
 
-    // ¼ص
-    TransitionEventHandler _onBeforeTransition; // ״̬תǰص
-    TransitionEventHandler _onAfterTransition;  // ״̬תص
-    TransitionFailedHandler _onTransitionFailed; // ״̬תʧܻص
-
-private:
     /**
-     * ȡָĶд򷵻ȫ
-     * @param key ״̬
-     * @return д
+     * αȡ־Ӱȡ
+     * ·תӳٻ岹Ǻų־
+     * @param cursor ȡα꣬cursor.dropped ¼ȡǵ
+     * @param maxCount ȡ
+     * @return ־б
      */
-    std::shared_mutex& GetKeyLock(const TKey& key) {
-        static std::shared_mutex globalLock;
-        auto it = _keyLocks.find(key);
-        if (it != _keyLocks.end()) return it->second;
-        return globalLock;
+    std::list<AuditLogEntry> GetAuditLogs(AuditCursor& cursor, size_t maxCount = SIZE_MAX) const {
+        std::vector<AuditRecord> records;
+        _auditLog.Read(cursor, records, maxCount);
+
+        std::list<AuditLogEntry> logs;
+        for (const auto& record : records) {
+            logs.push_back(ExpandAuditRecord(record));
+        }
+        return logs;
     }
 
     /**
-     * ¼״̬ʷ
-     * @param context ״̬
-     * @param newState ״̬
-     * @param reason ԭ
+     * ־̣߳ʹöα׷дıļӰ״̬ת
+     * @param path ־ļ·
+     * @param interval ̼
      */
-    void RecordHistory(StateContext& context, const TState& newState, const std::string& reason) {
-        context.history.emplace_back(newState, std::chrono::system_clock::now(), reason);
-        // ʷ¼ֹڴ
-        while (context.history.size() > 100) {
-            context.history.pop_front();
-        }
+    void StartAuditStream(const std::string& path,
+        std::chrono::milliseconds interval = std::chrono::milliseconds(200)) {
+        StopAuditStream();
+        auto file = std::make_shared<std::ofstream>(path, std::ios::app);
+        if (!file->is_open()) throw std::runtime_error("Failed to open audit stream file: " + path);
+
+        _stopAuditStreamer.store(false);
+        _auditStreamer = std::thread([this, file, interval]() {
+            AuditCursor cursor = _auditLog.OpenCursorAtEnd();
+            std::vector<AuditRecord> records;
+            uint64_t reportedDropped = 0;
+            bool stopping = false;
+            while (!stopping) {
+                stopping = _stopAuditStreamer.load();
+                records.clear();
+                _auditLog.Read(cursor, records);
+
+                if (cursor.dropped != reportedDropped) {
+                    *file << "# dropped " << (cursor.dropped - reportedDropped) << " entries\n";
+                    reportedDropped = cursor.dropped;
+                }
+                for (const auto& record : records) {
+                    AuditLogEntry entry = ExpandAuditRecord(record);
+                    *file << record.timestamp << '\t' << entry.key << '\t'
+                        << entry.fromState << '\t' << entry.toState << '\t'
+                        << (entry.success ? 1 : 0) << '\t' << entry.error << '\n';
+                }
+                file->flush();
+                if (!stopping) std::this_thread::sleep_for(interval);
+            }
+        });
     }
 
     /**
-     * ųʱ
-     * @param key ״̬
-     * @param duration ʱʱ
+     * ֹͣ־̣߳˳ǰдѷļ¼
      */
-    void ScheduleTimeout(const TKey& key, std::chrono::milliseconds duration) {
-        std::lock_guard<std::mutex> lock(_timeoutQueueMutex);
-        auto expireTime = std::chrono::system_clock::now() + duration;
-        _timeoutQueue.emplace(TimeoutTask{ key, expireTime });
+    void StopAuditStream() {
+        _stopAuditStreamer.store(true);
+        if (_auditStreamer.joinable()) {
+            _auditStreamer.join();
+        }
     }
 
     /**
-     * ʱɨ߳ڼ鳬ʱ
+     * ʷ鵵̣߳ʹöαѳɹתѹ׷ӵ鵵ļƺ߷
+     * 鵵־ͬһȡǵļ¼ȱ֡鵵
+     * λڹ鵵ǰѱõļ¼޷ԭͬȱ
+     * @param path 鵵ļ·Ѵʱ׷
+     * @param options 鵵дѡ
+     * @param interval 鵵
      */
-    void CheckTimeouts() {
-        while (!_stopScanner.load()) {
-            std::this_thread::sleep_for(std::chrono::seconds(1)); // ÿһ
-            auto now = std::chrono::system_clock::now();
+    void StartHistoryArchive(const std::string& path,
+        const HistoryArchiveOptions& options = HistoryArchiveOptions(),
+        std::chrono::milliseconds interval = std::chrono::milliseconds(200)) {
+        StopHistoryArchive();
+        auto writer = std::make_shared<HistoryArchiveWriter<TKey, TState>>(path, options);
 
-            // ռѹڵļ
-            std::vector<TKey> expiredKeys;
-            {
-                std::lock_guard<std::mutex> lock(_timeoutQueueMutex);
-                while (!_timeoutQueue.empty() && _timeoutQueue.top().expireTime <= now) {
-                    expiredKeys.push_back(_timeoutQueue.top().key);
-                    _timeoutQueue.pop();
+        _stopHistoryArchiver.store(false);
+        _historyArchiver = std::thread([this, writer, interval]() {
+            AuditCursor cursor = _auditLog.OpenCursorAtEnd();
+            std::vector<AuditRecord> records;
+            uint64_t reportedDropped = 0;
+            bool stopping = false;
+            while (!stopping) {
+                stopping = _stopHistoryArchiver.load();
+                // ·תǺŽƻ
+                FlushDeferredTransitions();
+                records.clear();
+                _auditLog.Read(cursor, records);
+
+                uint64_t unresolved = 0;
+                TKey key;
+                for (const auto& record : records) {
+                    if (!record.success) continue;
+                    if (!TryResolveAuditKey(record, key)) {
+                        ++unresolved;
+                        continue;
+                    }
+                    writer->Append(key, _stateIds.Resolve(record.fromState), _stateIds.Resolve(record.toState),
+                        record.timestamp, _reasonIds.Resolve(record.reasonId));
                 }
+                writer->RecordGap(cursor.dropped - reportedDropped + unresolved);
+                reportedDropped = cursor.dropped;
+                if (stopping) writer->Flush();
+                else std::this_thread::sleep_for(interval);
             }
+        });
+    }
 
-            // йڵ״̬
-            for (const auto& key : expiredKeys) {
-                HandleTimeout(key);
-            }
+    /**
+     * ֹͣʷ鵵̣߳˳ǰ鵵ѷļ¼дδݿ
+     */
+    void StopHistoryArchive() {
+        _stopHistoryArchiver.store(true);
+        if (_historyArchiver.joinable()) {
+            _historyArchiver.join();
         }
     }
 
     /**
-     * ʱ״̬
+     * Իȡǰ״̬Ȳȡ״̬֣ݵ©ʱټز飬
+     * ʱ
      * @param key ״̬
+     * @param state ڴ洢״̬
+     * @return Ƿɹȡ״̬
      */
-    void HandleTimeout(const TKey& key) {
-        std::unique_lock<std::shared_mutex> lock(GetKeyLock(key));
-        auto it = _states.find(key);
-        if (it == _states.end()) return;
-
-        StateContext& context = it->second;
-        // Ƿ˳ʱͻ״̬
-        if (!context.timeout || !context.fallbackState) return;
-
-        // Ƿĳʱ
-        auto elapsed = std::chrono::system_clock::now() + *context.timeout - context.lastUpdated;
-        if (elapsed < *context.timeout) return;
-
-        // ִгʱ״̬ת
-        Transition(key, *context.fallbackState,
-            [](auto&&...) {},
-            "State timeout");
+    bool TryGetCurrentState(const TKey& key, TState& state) {
+        const size_t hash = std::hash<TKey>{}(key);
+        Shard& shard = ShardOf(hash);
+        uint32_t slot;
+        uint64_t word = EvictedBit;
+        {
+            auto guard = _reclaimer.Pin();
+            if (FindSlot(shard, key, hash, slot)) word = shard.stateWords[slot].load(std::memory_order_acquire);
+            if (word & EvictedBit) {
+                std::shared_lock<std::shared_mutex> lock(shard.mutex);
+                if (!FindOrReload(shard, key, hash, slot, lock)) return false;
+                word = shard.stateWords[slot].load(std::memory_order_acquire);
+            }
+            // ֻڱ־ȱʧʱд룬ļڻؾ
+            if (!(word & AccessedBit)) shard.stateWords[slot].fetch_or(AccessedBit, std::memory_order_relaxed);
+        }
+        state = _stateIds.Resolve(StateOf(word));
+        return true;
     }
 
     /**
-     * ¼־
+     * ȡָ״̬ļO(1)·תӳٻ岹Ǻ
+     * @param state ״̬
+     * @return 
+     */
+    size_t GetStateCount(const TState& state) const {
+        uint32_t stateId;
+        if (!_stateIds.TryGetId(state, stateId)) return 0;
+        return static_cast<size_t>(std::max<int64_t>(0, _stateCounts.Get(stateId)));
+    }
+
+    /**
+     * ȡгֹ״̬䵱ǰ
+     * @return ״̬ӳ
+     */
+    std::unordered_map<TState, size_t> GetStateCounts() const {
+        std::unordered_map<TState, size_t> counts;
+        const size_t stateCount = _stateIds.Size();
+        for (uint32_t id = 0; id < stateCount; ++id) {
+            const int64_t count = _stateCounts.Get(id);
+            if (count > 0) counts.emplace(_stateIds.Resolve(id), static_cast<size_t>(count));
+        }
+        return counts;
+    }
+
+    /**
+     * ָ״̬ļ
+     * Ƭڹ¸Ƹ״̬ļͷص
+     * дֻȴƬĸƣڷƬһ£
+     * ·תӳٻ岹Ǻŷӳ
+     * @param state ״̬
+     * @param callback  bool(const TKey&) Ļص false ʱֹͣ
+     * @return صļ
+     */
+    template<typename Callback>
+    size_t ForEachKeyInState(const TState& state, Callback&& callback) const {
+        uint32_t stateId;
+        if (!_stateIds.TryGetId(state, stateId)) return 0;
+
+        size_t visited = 0;
+        std::vector<TKey> batch;
+        for (size_t i = 0; i < ShardCount; ++i) {
+            const Shard& shard = _shards[i];
+            batch.clear();
+            {
+                std::shared_lock<std::shared_mutex> lock(shard.mutex);
+                if (stateId >= shard.stateHeads.size()) continue;
+                for (uint32_t slot = shard.stateHeads[stateId]; slot != NoSlot;
+                    slot = shard.records[slot].nextInState) {
+                    batch.push_back(shard.keys[slot]);
+                }
+            }
+            for (const auto& key : batch) {
+                ++visited;
+                if (!callback(key)) return visited;
+            }
+        }
+        return visited;
+    }
+
+    /**
+     * ȡָ״̬ļб
+     * @param state ״̬
+     * @param maxCount ෵صļ
+     * @return б
+     */
+    std::vector<TKey> GetKeysInState(const TState& state, size_t maxCount = SIZE_MAX) const {
+        std::vector<TKey> keys;
+        if (maxCount == 0) return keys;
+        ForEachKeyInState(state, [&](const TKey& key) {
+            keys.push_back(key);
+            return keys.size() < maxCount;
+        });
+        return keys;
+    }
+
+    /**
+     * Ƴָ״̬ʵ̵ģλ뿪
      * @param key ״̬
-     * @param from Դ״̬
-     * @param to Ŀ״̬
+     * @return ǷƳڻ첽תռʱ false
+     */
+    bool RemoveState(const TKey& key) {
+        const size_t hash = std::hash<TKey>{}(key);
+        Shard& shard = ShardOf(hash);
+        {
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            uint32_t slot;
+            if (!FindSlot(shard, key, hash, slot)) return _spill && _spill->Erase(shard.index, key);
+            if (IsReserved(shard, slot)) return false;
+            RemoveContextLocked(shard, slot, false);
+        }
+        ReleaseRetiredSlots(shard);
+        return true;
+    }
+
+    /**
+     * ʵ̨̭̰߳ʱ㷨ɨƬ̭гʱ̬ʵ
+     * פʵʱ̭δʵʵÿƬÿֻһдλ
+     * ͣ״̬˳ʱ첽תռõʵᱻ̭
+     *  spillPath ʱ̭ʵдļκΰʶڴ棻
+     * 洢һ״̬ڱڿʼ֮ǰ
+     * @param options ̭ѡ
+     */
+    void EnableEviction(const EvictionOptions& options) {
+        DisableEviction();
+        if (!options.spillPath.empty()) {
+            if (!_spill) _spill.reset(new SpillStore<TKey>(options.spillPath, static_cast<uint32_t>(ShardCount)));
+            else if (_spill->Path() != options.spillPath) {
+                throw std::invalid_argument("Spill path cannot be changed once set: " + _spill->Path());
+            }
+        }
+        _terminalIds.clear();
+        for (const auto& state : options.terminalStates) _terminalIds.push_back(_stateIds.Intern(state));
+        std::sort(_terminalIds.begin(), _terminalIds.end());
+        _evictionOptions = options;
+        _stopEvictor = false;
+        _evictor = std::thread(&StateMachine::RunEvictor, this);
+    }
+
+    /**
+     * ֹͣʵ̭ʵԿɰ
+     */
+    void DisableEviction() {
+        {
+            std::lock_guard<std::mutex> lock(_evictorMutex);
+            _stopEvictor = true;
+        }
+        _evictorWake.notify_one();
+        if (_evictor.joinable()) {
+            _evictor.join();
+        }
+    }
+
+    /**
+     * ȡתͳƿգϲ̵߳ļÿתߵĺʱֱͼ״̬ͣʱֱͼ
+     * ֻڶȡʱ߳ͣ벢ת֮û˴֮䲻֤ϸһ
+     * ·תͣʱӳٻ岹Ǻ
+     * @return ͳƿ
+     */
+    TransitionMetrics GetMetrics() const {
+        TransitionMetrics result;
+        const uint32_t threadCount = _metricsCount.load();
+        const uint32_t edgeCount = static_cast<uint32_t>(_edgeIds.Size());
+        const uint32_t stateCount = static_cast<uint32_t>(_stateIds.Size());
+        std::vector<typename TransitionMetrics::Edge> edges(edgeCount);
+        std::vector<HistogramSnapshot> dwell(stateCount);
+        for (uint32_t t = 0; t < threadCount; ++t) {
+            if (!_metrics.IsAllocated(t)) continue;
+            const ThreadMetrics& metrics = _metrics[t];
+            result.totalTransitions += metrics.total.load(std::memory_order_relaxed);
+            result.successfulTransitions += metrics.successful.load(std::memory_order_relaxed);
+            result.failedTransitions += metrics.failed.load(std::memory_order_relaxed);
+            for (uint32_t e = 0; e < edgeCount; ++e) {
+                if (!metrics.edges.IsAllocated(e)) continue;
+                metrics.edges[e].latency.AddTo(edges[e].latency);
+                edges[e].fastPath += metrics.edges[e].fastPath.load(std::memory_order_relaxed);
+                edges[e].failures += metrics.edges[e].failures.load(std::memory_order_relaxed);
+            }
+            for (uint32_t s = 0; s < stateCount; ++s) {
+                if (metrics.dwell.IsAllocated(s)) metrics.dwell[s].AddTo(dwell[s]);
+            }
+        }
+        result.evictedKeys = _evictedKeys.load();
+        result.reloadedKeys = _reloadedKeys.load();
+
+        for (uint32_t e = 0; e < edgeCount; ++e) {
+            if (edges[e].latency.count == 0 && edges[e].fastPath == 0 && edges[e].failures == 0) continue;
+            const uint64_t edge = _edgeIds.Resolve(e);
+            edges[e].from = _stateIds.Resolve(static_cast<uint32_t>(edge >> 32));
+            edges[e].to = _stateIds.Resolve(static_cast<uint32_t>(edge));
+            result.edges.push_back(std::move(edges[e]));
+        }
+        for (uint32_t s = 0; s < stateCount; ++s) {
+            if (dwell[s].count == 0) continue;
+            result.states.push_back(typename TransitionMetrics::Dwell{ _stateIds.Resolve(s), dwell[s] });
+        }
+        return result;
+    }
+
+    /**
+     * ȡפڴʵ
+     */
+    size_t GetResidentCount() const {
+        return _residentKeys.load();
+    }
+
+    /**
+     * ȡ̵ʵ
+     */
+    size_t GetSpilledCount() const {
+        return _spill ? _spill->Size() : 0;
+    }
+
+    /**
+     *  NUMA ãƬطָڵ㣬Ƭļ¼Ͱ״ַֿ̬
+     * ˺󶼷ڵϣڴ漴Ǩơ״ֿ̬ɱȡַܸı䣬
+     * зֻֿ Linux ϰҳǨƣƽֻ̨·ֿ½ڵ㣻ʷĶڴ治ڷ÷Χڡ
+     * ߳ NumaTopology::BindCurrentThread 󶨵ڵ㣬ٰ GetNodeOfKey ֻصļ
+     * תʵķƬڴ涼ڱءظԸڵ㼯
+     * @param options ѡ
+     */
+    void EnableNumaPlacement(const NumaOptions& options = NumaOptions()) {
+        const uint32_t nodeCount = NumaTopology::NodeCount();
+        std::vector<int> nodes;
+        for (const uint32_t node : options.nodes) {
+            if (node >= nodeCount) throw std::invalid_argument("NUMA node out of range: " + std::to_string(node));
+            if (std::find(nodes.begin(), nodes.end(), static_cast<int>(node)) == nodes.end()) {
+                nodes.push_back(static_cast<int>(node));
+            }
+        }
+        if (nodes.empty()) {
+            for (uint32_t node = 0; node < nodeCount; ++node) nodes.push_back(static_cast<int>(node));
+        }
+
+        std::lock_guard<std::mutex> guard(_numaMutex);
+        _numaNodes = nodes;
+        _numaTolerance = options.rebalanceTolerance;
+        for (size_t i = 0; i < ShardCount; ++i) {
+            Shard& shard = _shards[i];
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            PlaceShardLocked(shard, nodes[i * nodes.size() / ShardCount]);
+        }
+    }
+
+    /**
+     * Ƭĳפʵ¾Ƭڵӳ
+     * ؽڵСڵ㸺زƬƵڵ㣬ֱزݲ
+     * ֻƶҪķƬƶķƬдǨڴ
+     * @return ƶķƬδ NUMA ʱΪ 0
+     */
+    size_t RebalanceNumaPlacement() {
+        std::lock_guard<std::mutex> guard(_numaMutex);
+        if (_numaNodes.empty()) return 0;
+
+        std::vector<size_t> weights(ShardCount);
+        std::vector<size_t> owners(ShardCount);
+        std::vector<size_t> loads(_numaNodes.size(), 0);
+        size_t total = 0;
+        for (size_t i = 0; i < ShardCount; ++i) {
+            Shard& shard = _shards[i];
+            {
+                std::shared_lock<std::shared_mutex> lock(shard.mutex);
+                weights[i] = shard.records.size() - shard.freeSlots.size() - shard.retiredSlots.size();
+            }
+            owners[i] = static_cast<size_t>(std::find(_numaNodes.begin(), _numaNodes.end(), shard.node.load())
+                - _numaNodes.begin());
+            loads[owners[i]] += weights[i];
+            total += weights[i];
+        }
+
+        // ÿƶϸСصƽͣѭȻ
+        const double tolerance = _numaTolerance * static_cast<double>(total) / static_cast<double>(_numaNodes.size());
+        std::vector<size_t> targets(owners);
+        while (true) {
+            const size_t heavy = static_cast<size_t>(std::max_element(loads.begin(), loads.end()) - loads.begin());
+            const size_t light = static_cast<size_t>(std::min_element(loads.begin(), loads.end()) - loads.begin());
+            const size_t gap = loads[heavy] - loads[light];
+            if (static_cast<double>(gap) <= tolerance) break;
+            size_t best = ShardCount;
+            for (size_t i = 0; i < ShardCount; ++i) {
+                if (targets[i] != heavy || weights[i] == 0 || weights[i] >= gap) continue;
+                if (best == ShardCount || weights[i] > weights[best]) best = i;
+            }
+            if (best == ShardCount) break;
+            targets[best] = light;
+            loads[heavy] -= weights[best];
+            loads[light] += weights[best];
+        }
+
+        size_t moved = 0;
+        for (size_t i = 0; i < ShardCount; ++i) {
+            if (targets[i] == owners[i]) continue;
+            Shard& shard = _shards[i];
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            PlaceShardLocked(shard, _numaNodes[targets[i]]);
+            ++moved;
+        }
+        return moved;
+    }
+
+    /**
+     * ȡƬڵӳ䣬±ΪƬţδ NUMA ʱȫΪ -1
+     */
+    std::vector<int> GetShardNodes() const {
+        std::vector<int> nodes(ShardCount);
+        for (size_t i = 0; i < ShardCount; ++i) nodes[i] = _shards[i].node.load(std::memory_order_relaxed);
+        return nodes;
+    }
+
+    /**
+     * ȡڵķƬ
+     */
+    static size_t GetShardOfKey(const TKey& key) {
+        return std::hash<TKey>{}(key) % ShardCount;
+    }
+
+    /**
+     * ȡڷƬĽڵ㣬δ NUMA ʱΪ -1¾ܱ仯ڵ·ɵĵ÷Ӧ֮ˢ
+     */
+    int GetNodeOfKey(const TKey& key) const {
+        return ShardOf(std::hash<TKey>{}(key)).node.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * ״̬дƿļ
+     * Ƭڹ±ͷƬתӰ죬
+     * ͬһƬдֻڸ÷ƬڼȴڷƬһ¡
+     * ǰ״̬ȡ״̬֣δǵĿ·תʷУ̵ʵһд
+     * @param path ļ·дɺԭ滻ļ
+     * @return дļ
+     */
+    size_t SaveSnapshot(const std::string& path) const {
+        SnapshotWriter writer(path, static_cast<uint32_t>(ShardCount));
+        std::string block;
+        size_t total = 0;
+        for (size_t i = 0; i < ShardCount; ++i) {
+            const Shard& shard = _shards[i];
+            block.clear();
+            uint64_t count;
+            {
+                std::shared_lock<std::shared_mutex> lock(shard.mutex);
+                count = 0;
+                for (uint32_t slot = 0; slot < shard.records.size(); ++slot) {
+                    const uint64_t word = shard.stateWords[slot].load();
+                    if (word & EvictedBit) continue;
+                    EncodeContext(block, shard.keys[slot], StateOf(word), shard.records[slot], shard.histories[slot].get());
+                    ++count;
+                }
+                // ¼غɾǱ
+                if (_spill) {
+                    count += _spill->ForEach(shard.index, [&](const TKey&, const std::string& payload) {
+                        block.append(payload);
+                    });
+                }
+            }
+            writer.WriteShard(block, count);
+            total += count;
+        }
+        writer.Commit();
+        return total;
+    }
+
+    /**
+     * ӿļָ״̬ģļڴӳ䷽ʽȡƬݿ鲢н
+     * Ѵڵͬᱻݸǣ˳ʱļᰴʣʱ°ųʱ
+     * @param path ļ·
+     * @param threadCount ߳0 ʾʹӲ
+     * @return ָļ
+     */
+    size_t LoadSnapshot(const std::string& path, size_t threadCount = 0) {
+        SnapshotReader reader(path);
+        std::atomic<size_t> loaded{ 0 };
+        RunParallel(reader.ShardCount(), threadCount, [&](size_t block) {
+            const SnapshotShardIndex& index = reader.Index(block);
+            loaded += LoadSnapshotBlock(reader.ShardData(block), index.size, index.count);
+        });
+        return loaded.load();
+    }
+
+    /**
+     * ù״̬ĵǰ״̬񵽹̶ֵڴΣ̿ SharedStateReader
+     * ֻӳ䣬һµضȡÿơӰ챾̵תÿ״ֻ̬һζԹĿԭд
+     * ·ճãλļԼ̵̭ļڱС
+     * ڿʼת֮ǰãеļʱһ
+     * @param name ڴ
+     * @param options ѡ
+     */
+    void EnableSharedState(const std::string& name, const SharedStateOptions& options = SharedStateOptions()) {
+        _sharedState.reset();
+        _sharedState.reset(new SharedStateWriter<TKey, TState>(name, options, ShardCount, VersionBits));
+        for (size_t i = 0; i < ShardCount; ++i) {
+            Shard& shard = _shards[i];
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            const uint32_t size = static_cast<uint32_t>(shard.records.size());
+            for (uint32_t slot = 0; slot < size; ++slot) {
+                if (!(shard.stateWords[slot].load() & EvictedBit)) BindSharedLocked(shard, slot);
+            }
+        }
+    }
+
+    /**
+     * ͣù״̬ɾڴƣӳĶ߲Ӱ쵫ٿ£ڲת
+     */
+    void DisableSharedState() {
+        _sharedState.reset();
+    }
+
+    /**
+     * Ԥд־˺ÿγɹ״̬ת׷һ¼
+     * ڿʼת֮ǰ
+     * @param path ־ļ·Ѵʱĩβ׷
+     * @param options ύ̵ȴѡ
+     */
+    void EnableWal(const std::string& path, const TransitionLogOptions& options = TransitionLogOptions()) {
+        _wal.reset();
+        _wal.reset(new TransitionLog<TKey, TState>(path, options));
+    }
+
+    /**
+     * ˢʣ¼رԤд־ڲת
+     */
+    void DisableWal() {
+        _wal.reset();
+    }
+
+    /**
+     * ȴǰԤд־¼
+     */
+    void FlushWal() {
+        if (_wal) _wal->Flush();
+    }
+
+    /**
+     * طԤд־Ѽ¼תӦõǰ״̬
+     * ֻӦʱڼǰ lastUpdated ļ¼ڿ֮ظطݵȵ
+     * @param path ־ļ·
+     * @return ʵӦõת
+     */
+    size_t ReplayWal(const std::string& path) {
+        TransitionLogReader<TKey, TState> reader(path);
+        size_t applied = 0;
+        reader.ForEach([&](const TransitionLogRecord<TKey, TState>& record) {
+            if (ApplyLoggedTransition(record)) ++applied;
+        });
+        return applied;
+    }
+
+    /**
+     * ָȼһοգطԤд־
+     * @param snapshotPath ļ·ʱ
+     * @param walPath Ԥд־·ʱ
+     * @param threadCount ս߳0 ʾʹӲ
+     * @return Ԥд־Ӧõת
+     */
+    size_t Recover(const std::string& snapshotPath, const std::string& walPath, size_t threadCount = 0) {
+        if (std::filesystem::exists(snapshotPath)) LoadSnapshot(snapshotPath, threadCount);
+        if (std::filesystem::exists(walPath)) return ReplayWal(walPath);
+        return 0;
+    }
+
+    /**
+     * 첽صύɹʧܵתת߳ϻصдɽ¼뱾̵߳¼壬
+     * רͶ̳߳ߣͬһ¼˳Ͷݡתصʧܻص֮Ͷ߳
+     * ãʧܻصյ쳣ЯԭϢ std::runtime_errorǰûصڶ֮ǰִУͬá
+     * ڼ·رգԱÿ¼ڷƬдȡšĳ̵߳¼дʱ̵߳ȴͶ߳ڳռ䣬
+     * ʱзƬ߿Ե״̬κη
+     * @param options 첽صѡ
+     */
+    void EnableAsyncCallbacks(const CallbackOptions& options = CallbackOptions()) {
+        std::lock_guard<std::mutex> control(_callbackControlMutex);
+        if (_callbackExecutor.joinable()) return;
+        _callbackOptions = options;
+        if (_callbackOptions.maxBatchSize == 0) _callbackOptions.maxBatchSize = 1;
+        // ȼ¸Ƭĵǰţٿ첽ģʽ˺ȡõŶСڼµֵ
+        _callbackNext.resize(ShardCount);
+        _callbackHeld.resize(ShardCount);
+        for (size_t i = 0; i < ShardCount; ++i) _callbackNext[i] = _shards[i].callbackSequence.load();
+        _stopCallbacks = false;
+        _asyncCallbacks.store(true);
+        _callbackExecutor = std::thread(&StateMachine::RunCallbackExecutor, this);
+    }
+
+    /**
+     * ͣ첽صͶѻȫ¼󷵻أ˺صָתִ߳ͬ
+     */
+    void DisableAsyncCallbacks() {
+        std::lock_guard<std::mutex> control(_callbackControlMutex);
+        if (!_callbackExecutor.joinable()) return;
+        _asyncCallbacks.store(false);
+        {
+            std::lock_guard<std::mutex> lock(_callbackWakeMutex);
+            _stopCallbacks = true;
+        }
+        _callbackWake.notify_one();
+        _callbackExecutor.join();
+    }
+
+    /**
+     * ĳת¼ֻ첽صڼյ¼Ͷ߳ϵã׳쳣
+     * @param handler 
+     * @return ı
+     */
+    uint64_t SubscribeTransitions(TransitionBatchHandler handler) {
+        std::lock_guard<std::mutex> lock(_subscriberMutex);
+        auto subscribers = std::make_shared<SubscriberList>(*_subscribers);
+        const uint64_t id = _nextSubscriberId++;
+        subscribers->emplace_back(id, std::make_shared<const TransitionBatchHandler>(std::move(handler)));
+        _subscribers = std::move(subscribers);
+        return id;
+    }
+
+    /**
+     * ȡģʱͶ߳̿ڰѵǰһ¼ô
+     * @param id ı
+     * @return Ƿ
+     */
+    bool UnsubscribeTransitions(uint64_t id) {
+        std::lock_guard<std::mutex> lock(_subscriberMutex);
+        auto subscribers = std::make_shared<SubscriberList>(*_subscribers);
+        auto it = std::find_if(subscribers->begin(), subscribers->end(),
+            [id](const auto& subscriber) { return subscriber.first == id; });
+        if (it == subscribers->end()) return false;
+        subscribers->erase(it);
+        _subscribers = std::move(subscribers);
+        return true;
+    }
+
+    // ¼ص
+    TransitionEventHandler _onBeforeTransition; // ״̬תǰص
+    TransitionEventHandler _onAfterTransition;  // ״̬תص
+    TransitionFailedHandler _onTransitionFailed; // ״̬תʧܻص
+
+private:
+    /**
+     * ȡϣڵķƬ
+     * @param hash Ĺϣ
+     * @return Ƭ
+     */
+    Shard& ShardOf(size_t hash) const {
+        return _shards[hash % ShardCount];
+    }
+
+    /**
+     * ɷƬλȫּţ־볬ʱʹ
+     */
+    static uint32_t MakeKeyId(const Shard& shard, uint32_t slot) {
+        return (slot << ShardBits) | shard.index;
+    }
+
+    /**
+     * ɼλô־ã32λΪôзƬ
+     */
+    static uint64_t MakeKeyRef(const Shard& shard, uint32_t slot) {
+        return (uint64_t(shard.records[slot].generation) << 32) | MakeKeyId(shard, slot);
+    }
+
+    /**
+     * ж״̬תǷϷڼԪٽڶȡǰתգ
+     */
+    bool IsAllowed(uint32_t fromId, uint32_t toId) const {
+        auto guard = _reclaimer.Pin();
+        return _transitions.load()->Allows(fromId, toId);
+    }
+
+    /**
+     * µת۾ɱתд
+     */
+    void PublishTransitionsLocked(std::unique_ptr<TransitionTable> table) {
+        const TransitionTable* old = _transitions.exchange(table.release());
+        _reclaimer.Retire(old);
+    }
+
+    /**
+     * ·Ľ
+     */
+    enum class FastPathResult {
+        Committed, // ύ
+        Rejected,  // ڻתϷ
+        Fallback   // Ҫ߼·
+    };
+
+    /**
+     * ״̬е״̬
+     */
+    static uint32_t StateOf(uint64_t word) {
+        return static_cast<uint32_t>(word & StateIdMask);
+    }
+
+    /**
+     * л״̬״̬֣汾żһ·־Ϊ
+     */
+    static uint64_t NextWord(uint64_t word, uint32_t stateId) {
+        return ((word & ~StateIdMask) + VersionUnit) | AccessedBit | stateId;
+    }
+
+    /**
+     * ·ڼԪٽڲҲλתһ CAS л״̬֣
+     * ʷд뱾̵߳ӳٻ壻߼ڲʱУƺʱ
+     */
+    FastPathResult TryFastTransition(const TKey& key, const TState& toState) {
+        ThreadMetrics& metrics = LocalMetrics();
+        uint32_t toId;
+        if (!_stateIds.TryGetId(toState, toId)) {
+            LatencyHistogram::Increment(metrics.total);
+            return FastPathResult::Rejected;
+        }
+        const size_t hash = std::hash<TKey>{}(key);
+        Shard& shard = ShardOf(hash);
+
+        DeferredTransition entry;
+        {
+            auto guard = _reclaimer.Pin();
+            uint32_t slot;
+            if (!FindSlot(shard, key, hash, slot)) return FastPathResult::Fallback;
+            const TransitionTable* table = _transitions.load();
+            std::atomic<uint64_t>& word = shard.stateWords[slot];
+            uint64_t observed = word.load(std::memory_order_acquire);
+            do {
+                if (observed & SlowPathBit) return FastPathResult::Fallback;
+                if (!table->Allows(StateOf(observed), toId)) {
+                    LatencyHistogram::Increment(metrics.total);
+                    return FastPathResult::Rejected;
+                }
+            } while (!word.compare_exchange_weak(observed, NextWord(observed, toId), std::memory_order_acq_rel));
+            PublishSharedState(shard, slot, NextWord(observed, toId));
+            entry.keyId = MakeKeyId(shard, slot);
+            entry.fromId = StateOf(observed);
+            entry.toId = toId;
+            entry.time = std::chrono::system_clock::now().time_since_epoch().count();
+            // ٽдӳٻ壺λڶ뿪ſջ֮Żᱻ
+            DeferTransition(entry);
+        }
+        LatencyHistogram::Increment(metrics.total);
+        LatencyHistogram::Increment(metrics.successful);
+        return FastPathResult::Committed;
+    }
+
+    /**
+     * д뱾̵߳ӳٻ壻ʱſ̣߳ʱɱ߳ſԼĻ
+     */
+    void DeferTransition(const DeferredTransition& entry) {
+        const uint32_t index = EpochDetail::CurrentThreadIndex();
+        DeferredBuffer& buffer = _deferred.Ensure(index);
+        if (_deferredCount.load(std::memory_order_relaxed) <= index) {
+            uint32_t count = _deferredCount.load();
+            while (count <= index && !_deferredCount.compare_exchange_weak(count, index + 1)) {}
+            std::call_once(_drainerStarted, [this] { _drainer = std::thread(&StateMachine::RunDrainer, this); });
+        }
+
+        const uint32_t tail = buffer.tail.load(std::memory_order_relaxed);
+        const uint32_t size = tail - buffer.head.load(std::memory_order_acquire);
+        if (size == DeferredBuffer::Capacity) DrainDeferredBuffer(buffer);
+        buffer.entries[tail % DeferredBuffer::Capacity] = entry;
+        buffer.tail.store(tail + 1, std::memory_order_release);
+        if (size + 1 == DeferredBuffer::Capacity / 2) _drainerWake.notify_one();
+    }
+
+    /**
+     * ſ߳ʱѣÿ 100 ſһл
+     */
+    void RunDrainer() {
+        std::unique_lock<std::mutex> lock(_drainerMutex);
+        while (!_stopDrainer) {
+            _drainerWake.wait_for(lock, std::chrono::milliseconds(100));
+            lock.unlock();
+            FlushDeferredTransitions();
+            lock.lock();
+        }
+    }
+
+    /**
+     * ſһӳٻ壺ƬʱƬһдʷ״̬
+     */
+    void DrainDeferredBuffer(DeferredBuffer& buffer) {
+        std::lock_guard<std::mutex> drainLock(buffer.drainMutex);
+        const uint32_t head = buffer.head.load(std::memory_order_relaxed);
+        const uint32_t tail = buffer.tail.load(std::memory_order_acquire);
+        if (head == tail) return;
+        std::vector<DeferredTransition> drained;
+        drained.reserve(tail - head);
+        for (uint32_t position = head; position != tail; ++position) {
+            drained.push_back(buffer.entries[position % DeferredBuffer::Capacity]);
+        }
+        buffer.head.store(tail, std::memory_order_release);
+
+        ThreadMetrics& metrics = LocalMetrics();
+        std::sort(drained.begin(), drained.end(), [](const DeferredTransition& a, const DeferredTransition& b) {
+            const uint32_t shardA = a.keyId & (ShardCount - 1), shardB = b.keyId & (ShardCount - 1);
+            return shardA != shardB ? shardA < shardB : a.time < b.time;
+        });
+        for (size_t begin = 0; begin < drained.size();) {
+            const uint32_t shardIndex = drained[begin].keyId & (ShardCount - 1);
+            Shard& shard = _shards[shardIndex];
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            size_t end = begin;
+            for (; end < drained.size() && (drained[end].keyId & (ShardCount - 1)) == shardIndex; ++end) {
+                const DeferredTransition& entry = drained[end];
+                const uint32_t slot = entry.keyId >> ShardBits;
+                const uint64_t word = shard.stateWords[slot].load(std::memory_order_relaxed);
+                // ̭תڱ̭ʱ״̬Уֻ
+                if (!(word & EvictedBit)) {
+                    RecordHistory(shard, slot, entry.toId, 0, entry.time);
+                    ContextRecord& record = shard.records[slot];
+                    // ͬһƬڰʱ䲹ǣͣʱһα
+                    if (record.lastUpdated && entry.time > record.lastUpdated) {
+                        RecordDwell(entry.fromId, entry.time - record.lastUpdated);
+                    }
+                    record.lastUpdated = std::max(record.lastUpdated, entry.time);
+                    // ״ֱ̬Ӷ뵽״ֵ̬ĵǰֵ
+                    MoveToStateLocked(shard, slot, StateOf(word));
+                }
+                RecordAudit(MakeKeyRef(shard, slot), entry.fromId, entry.toId, true, nullptr, entry.time);
+                LatencyHistogram::Increment(LocalEdge(metrics, entry.fromId, entry.toId).fastPath);
+            }
+            begin = end;
+        }
+    }
+
+    /**
+     * ڷƬڲҼĲλзƬ _reclaimer ٽ
+     * ʱ򲢷©飬ҲҵձƳ״ִ̬ EvictedBitĲλ᷵Ĳλ
+     * @param shard Ƭ
+     * @param key ״̬
+     * @param hash Ĺϣ
+     * @param slot ڴ洢λ
+     * @return Ƿҵ
+     */
+    static bool FindSlot(const Shard& shard, const TKey& key, size_t hash, uint32_t& slot) {
+        return shard.slots.Find(FlatHashIndex::Fold(hash),
+            [&](uint32_t candidate) { return shard.keys[candidate] == key; }, slot);
+    }
+
+    /**
+     * ڷƬڲҼĲλʱ룬зƬд
+     */
+    bool FindOrReloadLocked(Shard& shard, const TKey& key, size_t hash, uint32_t& slot) {
+        return FindSlot(shard, key, hash, slot) || ReloadSpilledLocked(shard, key, hash, slot);
+    }
+
+    /**
+     * ڷƬڲҼĲλʱʱд룬ʱԳй
+     * ڼܱٴ̭ʱ
+     */
+    bool FindOrReload(Shard& shard, const TKey& key, size_t hash, uint32_t& slot,
+        std::shared_lock<std::shared_mutex>& lock) {
+        if (FindSlot(shard, key, hash, slot)) return true;
+        if (!_spill) return false;
+        while (true) {
+            lock.unlock();
+            bool found;
+            {
+                std::unique_lock<std::shared_mutex> ulock(shard.mutex);
+                found = FindOrReloadLocked(shard, key, hash, slot);
+            }
+            lock.lock();
+            if (!found) return false;
+            if (FindSlot(shard, key, hash, slot)) return true;
+        }
+    }
+
+    /**
+     * 洢ȡؼĲ·Ƭ˳ʱİʣʱ°ţзƬд
+     * @return Ƿ洢
+     */
+    bool ReloadSpilledLocked(Shard& shard, const TKey& key, size_t hash, uint32_t& slot) {
+        std::string payload;
+        if (!_spill || !_spill->Take(shard.index, key, payload)) return false;
+        const char* p = payload.data();
+        DecodedContext context;
+        DecodeContext(p, p + payload.size(), context);
+        slot = UpsertContextLocked(shard, key, hash, context.record, std::move(context.history));
+        _reloadedKeys++;
+        if (context.record.timeoutMs != NoTimeout) {
+            using Clock = std::chrono::system_clock;
+            const Clock::time_point lastUpdated{ Clock::duration(context.record.lastUpdated) };
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                lastUpdated + std::chrono::milliseconds(context.record.timeoutMs) - Clock::now());
+            ScheduleTimeout(MakeKeyId(shard, slot), std::max(remaining, std::chrono::milliseconds(0)));
+        }
+        return true;
+    }
+
+    /**
+     * һ״̬ı׷ӵݿ
+     * ֣ǰ״̬ʱ䡢ʱ־[ʱ롢״̬]ʷʷ¼
+     */
+    void EncodeContext(std::string& out, const TKey& key, uint32_t stateId, const ContextRecord& record,
+        const HistoryBuffer* history) const {
+        BinaryCodec<TKey>::Write(out, key);
+        BinaryCodec<TState>::Write(out, _stateIds.Resolve(stateId));
+        BinaryCodec<int64_t>::Write(out, record.lastUpdated);
+        const uint8_t hasTimeout = record.timeoutMs != NoTimeout ? 1 : 0;
+        BinaryCodec<uint8_t>::Write(out, hasTimeout);
+        if (hasTimeout) {
+            BinaryCodec<int64_t>::Write(out, record.timeoutMs);
+            BinaryCodec<TState>::Write(out, _stateIds.Resolve(record.fallbackStateId));
+        }
+        BinaryCodec<uint32_t>::Write(out, history ? static_cast<uint32_t>(history->entries.size()) : 0);
+        if (!history) return;
+        history->ForEach([&](const HistoryEntry& entry) {
+            BinaryCodec<TState>::Write(out, _stateIds.Resolve(entry.stateId));
+            BinaryCodec<int64_t>::Write(out, entry.time);
+            BinaryCodec<std::string>::Write(out, _reasonIds.Resolve(entry.reasonId));
+        });
+    }
+
+    /**
+     * ӿݿһ״̬ģ״̬ԭڴפ
+     */
+    void DecodeContext(const char*& p, const char* end, DecodedContext& context) {
+        using BinaryCodecUtils::ReadOrThrow;
+        const char* what = "state machine snapshot";
+        context.key = ReadOrThrow<TKey>(p, end, what);
+        context.record.stateId = _stateIds.Intern(ReadOrThrow<TState>(p, end, what));
+        context.record.lastUpdated = ReadOrThrow<int64_t>(p, end, what);
+        if (ReadOrThrow<uint8_t>(p, end, what)) {
+            const int64_t timeout = ReadOrThrow<int64_t>(p, end, what);
+            context.record.timeoutMs = static_cast<uint32_t>(std::clamp<int64_t>(timeout, 0, NoTimeout - 1));
+            context.record.fallbackStateId = _stateIds.Intern(ReadOrThrow<TState>(p, end, what));
+        }
+        const uint32_t historyCount = ReadOrThrow<uint32_t>(p, end, what);
+        if (historyCount) context.history.reset(new HistoryBuffer());
+        for (uint32_t i = 0; i < historyCount; ++i) {
+            HistoryEntry entry;
+            entry.stateId = _stateIds.Intern(ReadOrThrow<TState>(p, end, what));
+            entry.time = ReadOrThrow<int64_t>(p, end, what);
+            entry.reasonId = _reasonIds.Intern(ReadOrThrow<std::string>(p, end, what));
+            context.history->Push(entry, HistoryLimit);
+        }
+    }
+
+    /**
+     * ʱִ̲߳һ񣬸̴߳ӹȡ
+     * ׳ĵһ쳣߳̽׳
+     * @param taskCount 
+     * @param threadCount ߳0 ʾʹӲ
+     * @param task  void(size_t taskIndex) 
+     */
+    template<typename Task>
+    static void RunParallel(size_t taskCount, size_t threadCount, Task&& task) {
+        if (threadCount == 0) threadCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+        threadCount = std::min(threadCount, std::max<size_t>(1, taskCount));
+
+        std::atomic<size_t> nextTask{ 0 };
+        std::vector<std::exception_ptr> errors(threadCount);
+        auto worker = [&](size_t workerIndex) {
+            try {
+                size_t index;
+                while ((index = nextTask.fetch_add(1)) < taskCount) task(index);
+            }
+            catch (...) {
+                errors[workerIndex] = std::current_exception();
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (size_t i = 1; i < threadCount; ++i) workers.emplace_back(worker, i);
+        worker(0);
+        for (auto& t : workers) t.join();
+        for (auto& error : errors) {
+            if (error) std::rethrow_exception(error);
+        }
+    }
+
+    /**
+     * деļ¼פ״̬óʱ
+     * @param timeoutMs ʱʾ
+     * @param fallbackState ״̬óʱʱΪ
+     */
+    void FillBulkRecord(ContextRecord& record, const TState& state, int64_t timeoutMs, const TState* fallbackState) {
+        record.stateId = _stateIds.Intern(state);
+        if (timeoutMs < 0) return;
+        record.timeoutMs = static_cast<uint32_t>(std::min<int64_t>(timeoutMs, NoTimeout - 1));
+        record.fallbackStateId = _stateIds.Intern(*fallbackState);
+    }
+
+    /**
+     * ʵ֣кŷ
+     * ֣ÿ̸߳һУϣͳƸƬǰ׺Ͱкȶɢе order
+     * д룺סȫƬƬвصʵorder ек֮ɲλţ
+     * ȫƬдҿر־ͷٰųʱ
+     * @param count 
+     * @param threadCount ߳0 ʾʹӲ
+     * @param keyAt  const TKey&(size_t row) Ļص
+     * @param fillRecord  void(size_t row, ContextRecord&) Ļص
+     * @return 
+     */
+    template<typename KeyAt, typename FillRecord>
+    size_t BulkLoadRows(size_t count, size_t threadCount, KeyAt&& keyAt, FillRecord&& fillRecord) {
+        if (count == 0) return 0;
+        if (threadCount == 0) threadCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+
+        const size_t chunkCount = std::min(threadCount, count);
+        auto chunkBegin = [&](size_t chunk) { return count / chunkCount * chunk + std::min(chunk, count % chunkCount); };
+        std::vector<size_t> hashes(count);
+        std::vector<size_t> cursors(chunkCount * ShardCount, 0); // ȴθƬٻдλ
+        RunParallel(chunkCount, threadCount, [&](size_t chunk) {
+            size_t* counts = &cursors[chunk * ShardCount];
+            for (size_t row = chunkBegin(chunk); row < chunkBegin(chunk + 1); ++row) {
+                hashes[row] = std::hash<TKey>{}(keyAt(row));
+                ++counts[hashes[row] % ShardCount];
+            }
+        });
+        std::vector<size_t> shardBegin(ShardCount + 1);
+        size_t offset = 0;
+        for (size_t i = 0; i < ShardCount; ++i) {
+            shardBegin[i] = offset;
+            for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+                size_t& cursor = cursors[chunk * ShardCount + i];
+                const size_t rows = cursor;
+                cursor = offset;
+                offset += rows;
+            }
+        }
+        shardBegin[ShardCount] = offset;
+        std::vector<size_t> order(count);
+        RunParallel(chunkCount, threadCount, [&](size_t chunk) {
+            size_t* chunkCursors = &cursors[chunk * ShardCount];
+            for (size_t row = chunkBegin(chunk); row < chunkBegin(chunk + 1); ++row) {
+                order[chunkCursors[hashes[row] % ShardCount]++] = row;
+            }
+        });
+
+        const int64_t now = std::chrono::system_clock::now().time_since_epoch().count();
+        std::vector<std::vector<std::pair<uint32_t, std::chrono::milliseconds>>> timeouts(ShardCount);
+        std::vector<size_t> applied(ShardCount, 0);
+        std::vector<std::exception_ptr> errors(ShardCount);
+        {
+            std::vector<std::unique_lock<std::shared_mutex>> locks;
+            locks.reserve(ShardCount);
+            for (size_t i = 0; i < ShardCount; ++i) locks.emplace_back(_shards[i].mutex);
+
+            RunParallel(ShardCount, threadCount, [&](size_t i) {
+                Shard& shard = _shards[i];
+                const size_t begin = shardBegin[i];
+                const size_t end = shardBegin[i + 1];
+                if (begin == end) return;
+                // ƬʧʱҪҿдʵ쳣ͷ֮׳
+                try {
+                    shard.slots.Reserve(shard.slots.Size() + (end - begin));
+                    shard.records.reserve(shard.records.size() + (end - begin));
+                    shard.histories.reserve(shard.histories.size() + (end - begin));
+                    for (size_t j = begin; j < end; ++j) {
+                        const size_t row = order[j];
+                        ContextRecord record;
+                        record.lastUpdated = now;
+                        fillRecord(row, record);
+                        const uint32_t slot = UpsertContextLocked(shard, keyAt(row), hashes[row], record, nullptr, true);
+                        order[j] = slot;
+                        ++applied[i];
+                        if (record.timeoutMs != NoTimeout) {
+                            timeouts[i].emplace_back(MakeKeyId(shard, slot), std::chrono::milliseconds(record.timeoutMs));
+                        }
+                    }
+                }
+                catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            });
+            // ǰҵʵ߶˻ؼ·ڷƬϵȴ
+            RunParallel(ShardCount, threadCount, [&](size_t i) {
+                Shard& shard = _shards[i];
+                for (size_t j = shardBegin[i]; j < shardBegin[i] + applied[i]; ++j) {
+                    RevealLocked(shard, static_cast<uint32_t>(order[j]));
+                }
+            });
+        }
+
+        for (const auto& shardTimeouts : timeouts) {
+            for (const auto& timeout : shardTimeouts) ScheduleTimeout(timeout.first, timeout.second);
+        }
+        for (auto& error : errors) {
+            if (error) std::rethrow_exception(error);
+        }
+        return count;
+    }
+
+    /**
+     * һݿ鲢ӦƬ
+     * ȫ벢ĿƬ飬ƬһԼд
+     * @param data ݿʼַ
+     * @param size ݿֽ
+     * @param count ݿеļ¼
+     * @return ָļ
+     */
+    size_t LoadSnapshotBlock(const char* data, uint64_t size, uint64_t count) {
+        const char* p = data;
+        const char* end = data + size;
+        std::vector<std::vector<DecodedContext>> byShard(ShardCount);
+        for (uint64_t i = 0; i < count; ++i) {
+            DecodedContext context;
+            DecodeContext(p, end, context);
+            context.hash = std::hash<TKey>{}(context.key);
+            byShard[context.hash % ShardCount].push_back(std::move(context));
+        }
+        if (p != end) throw std::runtime_error("Trailing data in state machine snapshot block");
+
+        using Clock = std::chrono::system_clock;
+        const auto now = Clock::now();
+        for (size_t i = 0; i < ShardCount; ++i) {
+            if (byShard[i].empty()) continue;
+            Shard& shard = _shards[i];
+            std::vector<std::pair<uint32_t, std::chrono::milliseconds>> timeouts;
+            {
+                std::unique_lock<std::shared_mutex> lock(shard.mutex);
+                shard.slots.Reserve(shard.records.size() + byShard[i].size());
+                for (auto& context : byShard[i]) {
+                    const uint32_t slot = UpsertContextLocked(shard, context.key, context.hash,
+                        context.record, std::move(context.history));
+                    if (context.record.timeoutMs == NoTimeout) continue;
+                    const Clock::time_point lastUpdated{ Clock::duration(context.record.lastUpdated) };
+                    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        lastUpdated + std::chrono::milliseconds(context.record.timeoutMs) - now);
+                    timeouts.emplace_back(MakeKeyId(shard, slot), std::max(remaining, std::chrono::milliseconds(0)));
+                }
+            }
+            for (const auto& timeout : timeouts) {
+                ScheduleTimeout(timeout.first, timeout.second);
+            }
+        }
+        return static_cast<size_t>(count);
+    }
+
+    /**
+     * ڷƬдύһͨתдԤд־״̬֡ʷ״̬ʱ
+     * Ԥд־дʧʱ׳쳣״ֲ̬
+     * @param observed Ϸʱ״̬
+     * @param lsn ڴ洢Ԥд־ţδԤд־ʱΪ 0
+     * @return Ƿύ״̬ѱ߳޸ʱ falseֻзʱ־仯޸ģ
+     */
+    bool CommitTransitionLocked(Shard& shard, uint32_t slot, const TKey& key, uint64_t observed,
+        uint32_t toId, const std::string& reason, uint64_t& lsn) {
+        lsn = 0;
+        std::atomic<uint64_t>& word = shard.stateWords[slot];
+        uint64_t current = word.load();
+        if ((current ^ observed) & ~AccessedBit) return false;
+        const uint32_t fromId = StateOf(observed);
+        const int64_t now = std::chrono::system_clock::now().time_since_epoch().count();
+        const uint32_t reasonId = _reasonIds.Intern(reason);
+
+        // дԤд־дʧʱ״ֲ̬
+        if (_wal) {
+            lsn = _wal->Append(key, _stateIds.Resolve(fromId), _stateIds.Resolve(toId), now, reasonId, reason);
+        }
+        // Ԥд־ʱ·رգдڼ״ֲ̬ٱ䣬CAS ֻ·÷ʱ־
+        while (!word.compare_exchange_weak(current, NextWord(current, toId))) {
+            if ((current ^ observed) & ~AccessedBit) return false;
+        }
+        PublishSharedState(shard, slot, NextWord(current, toId));
+
+        // ¼״̬ʷ
+        RecordHistory(shard, slot, toId, reasonId, now);
+        // ״̬ʱ
+        MoveToStateLocked(shard, slot, toId);
+        ContextRecord& record = shard.records[slot];
+        if (record.lastUpdated && now > record.lastUpdated) RecordDwell(fromId, now - record.lastUpdated);
+        record.lastUpdated = now;
+
+        // ˳ʱųʱ
+        if (record.timeoutMs != NoTimeout) {
+            ScheduleTimeout(MakeKeyId(shard, slot), std::chrono::milliseconds(record.timeoutMs));
+        }
+
+        // ¼־
+        RecordAudit(MakeKeyRef(shard, slot), fromId, toId, true, nullptr, now, reasonId);
+        return true;
+    }
+
+    /**
+     * 򸲸һ״̬Ĳ״̬зƬд
+     * ¼ȸͷŵĲλͬ¼
+     * @param shard Ƭ
+     * @param key ״̬
+     * @param hash Ĺϣ
+     * @param record µļ¼ֶ븴ôԣ
+     * @param history µʷΪ
+     * @param hidden Ƿأ̭·־÷ͷдǰ RevealLocked ҿ
+     * @return ڵĲλ
+     */
+    uint32_t UpsertContextLocked(Shard& shard, const TKey& key, size_t hash,
+        const ContextRecord& record, std::unique_ptr<HistoryBuffer> history, bool hidden = false) {
+        const uint64_t hiddenBits = hidden ? (EvictedBit | SlowPathBit) : 0;
+        uint32_t slot;
+        if (FindSlot(shard, key, hash, slot)) {
+            // ٸǣ߿¾ݻϵм״̬
+            if (hidden) shard.stateWords[slot].fetch_or(hiddenBits);
+            UnlinkFromStateLocked(shard, slot);
+            const uint32_t generation = shard.records[slot].generation;
+            shard.records[slot] = record;
+            shard.records[slot].generation = generation;
+            SetStateWordLocked(shard, slot, record.stateId);
+        }
+        else {
+            // ״̬дãĲһҵλɶȡ
+            if (!shard.freeSlots.empty()) {
+                slot = shard.freeSlots.front();
+                shard.freeSlots.pop_front();
+                shard.keys[slot] = key;
+                const uint32_t generation = shard.records[slot].generation + 1;
+                shard.records[slot] = record;
+                shard.records[slot].generation = generation;
+                // 汾ֵо״ֵ̬ύ¼
+                std::atomic<uint64_t>& word = shard.stateWords[slot];
+                word.store(NextWord(word.load() & ~(EvictedBit | SlowPathBit), record.stateId) | hiddenBits);
+            }
+            else {
+                if (shard.records.size() >= MaxSlotsPerShard) throw std::length_error("StateMachine shard is full");
+                slot = static_cast<uint32_t>(shard.records.size());
+                shard.keys.Ensure(slot) = key;
+                shard.stateWords.Ensure(slot).store(record.stateId | AccessedBit | hiddenBits);
+                shard.records.push_back(record);
+                shard.records[slot].generation = 0;
+                shard.histories.emplace_back();
+            }
+            shard.slots.Insert(FlatHashIndex::Fold(hash), slot);
+            BindSharedLocked(shard, slot);
+            _residentKeys.fetch_add(1, std::memory_order_relaxed);
+            if (_spill) _spill->Erase(shard.index, key);
+        }
+        shard.histories[slot] = std::move(history);
+        if (!hidden) RefreshSlowPathLocked(shard, slot);
+        LinkToStateLocked(shard, slot);
+        return slot;
+    }
+
+    /**
+     * ƳһʵзƬдȷס״̬֣ÿ·˻ؼ·
+     * д洢ٴ״̬ժλۼԪ retiredSlots
+     * @param spill Ƿд洢
+     */
+    void RemoveContextLocked(Shard& shard, uint32_t slot, bool spill) {
+        const uint64_t word = shard.stateWords[slot].fetch_or(EvictedBit | SlowPathBit);
+        const TKey& key = shard.keys[slot];
+        ContextRecord& record = shard.records[slot];
+        if (spill && _spill) {
+            std::string payload;
+            EncodeContext(payload, key, StateOf(word), record, shard.histories[slot].get());
+            _spill->Put(shard.index, key, payload);
+        }
+        shard.slots.Erase(FlatHashIndex::Fold(std::hash<TKey>{}(key)),
+            [slot](uint32_t candidate) { return candidate == slot; });
+        if (_sharedState) _sharedState->Unbind(shard.index, slot);
+        UnlinkFromStateLocked(shard, slot);
+        shard.histories[slot].reset();
+        // λΪֹ־Կɰôԭ
+        const uint32_t generation = record.generation;
+        record = ContextRecord();
+        record.generation = generation;
+        shard.retiredSlots.emplace_back(_reclaimer.Advance(), slot);
+        _residentKeys.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * ·ڼύ̭֮ʱ²λύзƬд
+     * ֻ̭ǰ״̬δɱ߳ʱżڼܷת
+     * ѱ߳ļ޷жڼǷйתͻ
+     * @param slot ʱĲλ²λʱ֮
+     * @param observed ʱ״̬֣²λʱ֮
+     * @return Ƿύδ̭ʱ trueͻύʱİ汾ж
+     */
+    bool RelocateEvictedLocked(Shard& shard, const TKey& key, size_t hash, uint32_t& slot, uint64_t& observed) {
+        const uint64_t current = shard.stateWords[slot].load();
+        if (!(current & EvictedBit)) return true;
+        if ((current ^ observed) & ~(AccessedBit | EvictedBit | SlowPathBit)) return false;
+        if (FindSlot(shard, key, hash, slot) || !ReloadSpilledLocked(shard, key, hash, slot)) return false;
+        observed = shard.stateWords[slot].load();
+        return true;
+    }
+
+    /**
+     * Ѷȫ뿪۲λתΪɸãзƬд
+     * ÷ȡ safeEpoch ֮󡢵ñ֮ǰſӳٻ
+     * @param safeEpoch ſӳٻ֮ǰȡõ _reclaimer.SafeEpoch()
+     */
+    static void ReleaseRetiredSlotsLocked(Shard& shard, uint64_t safeEpoch) {
+        while (!shard.retiredSlots.empty() && shard.retiredSlots.front().first <= safeEpoch) {
+            shard.freeSlots.push_back(shard.retiredSlots.front().second);
+            shard.retiredSlots.pop_front();
+        }
+    }
+
+    /**
+     * ſӳٻͷŷƬпɸõ۲λ
+     */
+    void ReleaseRetiredSlots(Shard& shard) {
+        const uint64_t safeEpoch = _reclaimer.SafeEpoch();
+        FlushDeferredTransitions();
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        ReleaseRetiredSlotsLocked(shard, safeEpoch);
+    }
+
+    /**
+     * ̭߳ÿ scanInterval ִһɨ
+     */
+    void RunEvictor() {
+        std::unique_lock<std::mutex> lock(_evictorMutex);
+        while (!_stopEvictor) {
+            _evictorWake.wait_for(lock, _evictionOptions.scanInterval);
+            if (_stopEvictor) break;
+            lock.unlock();
+            RunEvictionPass();
+            lock.lock();
+        }
+    }
+
+    /**
+     * һ̭ɨ裺ſӳٻʹ lastUpdated ״̬״̬֣
+     * ƬһдͷſɸõĲλƽʱָ룬ļ
+     */
+    void RunEvictionPass() {
+        const uint64_t safeEpoch = _reclaimer.SafeEpoch();
+        FlushDeferredTransitions();
+        const int64_t now = std::chrono::system_clock::now().time_since_epoch().count();
+        const size_t budget = std::max<size_t>(1, _evictionOptions.scanBatch / ShardCount);
+        for (size_t i = 0; i < ShardCount; ++i) {
+            Shard& shard = _shards[i];
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            ReleaseRetiredSlotsLocked(shard, safeEpoch);
+            ScanShardLocked(shard, budget, now);
+        }
+        if (_spill) _spill->CompactStep(SpillCompactBytes);
+    }
+
+    /**
+     * ʱָ봦 budget λгʱ̬ʵֱ̭
+     * פʵʱʹʱ־̭зƬд
+     */
+    void ScanShardLocked(Shard& shard, size_t budget, int64_t now) {
+        const uint32_t size = static_cast<uint32_t>(shard.records.size());
+        const int64_t ttl = std::chrono::duration_cast<std::chrono::system_clock::duration>(
+            _evictionOptions.terminalTtl).count();
+        const size_t maxResident = _evictionOptions.maxResidentKeys;
+        for (size_t visited = 0; visited < budget && visited < size; ++visited) {
+            const uint32_t slot = shard.evictionCursor < size ? shard.evictionCursor : 0;
+            shard.evictionCursor = slot + 1;
+            std::atomic<uint64_t>& word = shard.stateWords[slot];
+            const uint64_t current = word.load();
+            // Ƴ˳ʱ첽תռõʵ·־
+            if (current & SlowPathBit) continue;
+
+            const bool expired = ttl > 0 && now - shard.records[slot].lastUpdated >= ttl &&
+                std::binary_search(_terminalIds.begin(), _terminalIds.end(), StateOf(current));
+            if (!expired) {
+                if (maxResident == 0 || _residentKeys.load(std::memory_order_relaxed) <= maxResident) continue;
+                if (current & AccessedBit) {
+                    word.fetch_and(~AccessedBit);
+                    continue;
+                }
+            }
+            RemoveContextLocked(shard, slot, true);
+            _evictedKeys++;
+        }
+    }
+
+    /**
+     * ڷƬдڰ״̬л״̬汾żһ· CAS ʱԱΪ׼
+     */
+    void SetStateWordLocked(Shard& shard, uint32_t slot, uint32_t stateId) {
+        std::atomic<uint64_t>& word = shard.stateWords[slot];
+        uint64_t observed = word.load();
+        while (!word.compare_exchange_weak(observed, NextWord(observed, stateId))) {}
+        PublishSharedState(shard, slot, NextWord(observed, stateId));
+    }
+
+    /**
+     * Ѳλϵļ뵱ǰ״̬񵽹״̬ãзƬд
+     */
+    void BindSharedLocked(const Shard& shard, uint32_t slot) {
+        if (!_sharedState) return;
+        const uint64_t word = shard.stateWords[slot].load();
+        PublishSharedStateName(StateOf(word));
+        _sharedState->Bind(shard.index, slot, shard.keys[slot], static_cast<uint32_t>(word / VersionUnit), StateOf(word));
+    }
+
+    /**
+     * Ѳλ״ַ̬״̬ãͬһλϵ汾Ͼɵı
+     */
+    void PublishSharedState(const Shard& shard, uint32_t slot, uint64_t word) {
+        if (!_sharedState) return;
+        PublishSharedStateName(StateOf(word));
+        _sharedState->PublishState(shard.index, slot, static_cast<uint32_t>(word / VersionUnit), StateOf(word));
+    }
+
+    /**
+     * ȷ״̬ż֮ǰ״̬д빲״̬״̬
+     */
+    void PublishSharedStateName(uint32_t stateId) {
+        if (!_sharedState->NeedsState(stateId)) return;
+        std::lock_guard<std::mutex> lock(_sharedStateMutex);
+        const uint32_t count = static_cast<uint32_t>(_stateIds.Size());
+        for (uint32_t id = _sharedState->StateCount(); id < count && _sharedState->NeedsState(id); ++id) {
+            _sharedState->AddState(_stateIds.Resolve(id));
+        }
+    }
+
+    /**
+     * ʱ첽ռ״̬ϵ·־зƬд
+     */
+    static void RefreshSlowPathLocked(Shard& shard, uint32_t slot) {
+        const bool slow = shard.records[slot].timeoutMs != NoTimeout || IsReserved(shard, slot);
+        if (slow) shard.stateWords[slot].fetch_or(SlowPathBit);
+        else shard.stateWords[slot].fetch_and(~SlowPathBit);
+    }
+
+    /**
+     * ѷƬڴŵָڵ㣬зƬд
+     * ļ¼ֻд·ʣֱ½ڵ·䣻Ͱ龭滻
+     * ״ֿ̬ɱȡзֿ鰴ҳǨƣ˺·ֿ½ڵ
+     */
+    void PlaceShardLocked(Shard& shard, int node) {
+        shard.node.store(node);
+        if (shard.records.get_allocator().Node() != node) {
+            std::vector<ContextRecord, NumaAllocator<ContextRecord>> records{ NumaAllocator<ContextRecord>(node) };
+            records.reserve(shard.records.capacity());
+            records.assign(shard.records.begin(), shard.records.end());
+            shard.records.swap(records);
+        }
+        shard.slots.SetNode(node);
+        shard.slots.Relocate();
+        shard.keys.SetNode(node);
+        shard.keys.ForEachChunk([node](const TKey* data, size_t count) {
+            NumaTopology::Migrate(data, count * sizeof(TKey), node);
+        });
+        shard.stateWords.SetNode(node);
+        shard.stateWords.ForEachChunk([node](const std::atomic<uint64_t>* data, size_t count) {
+            NumaTopology::Migrate(data, count * sizeof(std::atomic<uint64_t>), node);
+        });
+    }
+
+    /**
+     * ҿ UpsertContextLocked õر־ʱ첽ռ·־зƬд
+     */
+    static void RevealLocked(Shard& shard, uint32_t slot) {
+        const bool slow = shard.records[slot].timeoutMs != NoTimeout || IsReserved(shard, slot);
+        shard.stateWords[slot].fetch_and(~(EvictedBit | (slow ? uint64_t(0) : SlowPathBit)));
+    }
+
+    /**
+     * ޸ʵĵǰ״̬ͬ״̬зƬд
+     */
+    void MoveToStateLocked(Shard& shard, uint32_t slot, uint32_t stateId) {
+        if (shard.records[slot].stateId == stateId) return;
+        UnlinkFromStateLocked(shard, slot);
+        shard.records[slot].stateId = stateId;
+        LinkToStateLocked(shard, slot);
+    }
+
+    /**
+     * ʵҵ״̬ͷӸ״̬ļ
+     */
+    void LinkToStateLocked(Shard& shard, uint32_t slot) {
+        ContextRecord& record = shard.records[slot];
+        if (record.stateId >= shard.stateHeads.size()) shard.stateHeads.resize(record.stateId + 1, NoSlot);
+        uint32_t& head = shard.stateHeads[record.stateId];
+        record.prevInState = NoSlot;
+        record.nextInState = head;
+        if (head != NoSlot) shard.records[head].prevInState = slot;
+        head = slot;
+        _stateCounts.At(record.stateId).fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * ʵ״̬ժٸ״̬ļ
+     */
+    void UnlinkFromStateLocked(Shard& shard, uint32_t slot) {
+        ContextRecord& record = shard.records[slot];
+        if (record.prevInState != NoSlot) {
+            shard.records[record.prevInState].nextInState = record.nextInState;
+        }
+        else {
+            if (record.stateId >= shard.stateHeads.size() || shard.stateHeads[record.stateId] != slot) return; // δ
+            shard.stateHeads[record.stateId] = record.nextInState;
+        }
+        if (record.nextInState != NoSlot) shard.records[record.nextInState].prevInState = record.prevInState;
+        record.prevInState = record.nextInState = NoSlot;
+        _stateCounts.At(record.stateId).fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * ¼ʧƲʧܻص
+     */
+    void ReportFailure(Shard& shard, const TKey& key, uint64_t keyRef, uint32_t fromId, uint32_t toId,
+        std::exception_ptr failure) {
+        try {
+            std::rethrow_exception(failure);
+        }
+        catch (const std::exception& ex) {
+            RecordAudit(keyRef, fromId, toId, false, ex.what());
+            NotifyFailure(shard, key, fromId, toId, ex);
+        }
+        catch (...) {
+            RecordAudit(keyRef, fromId, toId, false, "unknown exception");
+        }
+    }
+
+    /**
+     * ʧܻص첽صʱд¼壬ֱӵʧܻص
+     * @param fromId Դ״̬ţNoStateId ʾ
+     */
+    void NotifyFailure(Shard& shard, const TKey& key, uint32_t fromId, uint32_t toId, const std::exception& ex) {
+        if (_asyncCallbacks.load(std::memory_order_relaxed)) {
+            EnqueueCallback(MakeCallbackRecord(shard, key, fromId, toId, false, InternMessage(ex.what())));
+        }
+        else if (_onTransitionFailed) {
+            _onTransitionFailed(key, fromId == NoStateId ? TState() : _stateIds.Resolve(fromId), _stateIds.Resolve(toId), ex);
+        }
+    }
+
+    /**
+     * ɻص¼ȡ÷Ƭţύ¼ڷƬдɣʹύ˳һ
+     */
+    CallbackRecord MakeCallbackRecord(Shard& shard, const TKey& key, uint32_t fromId, uint32_t toId,
+        bool success, uint32_t errorId = 0) {
+        CallbackRecord record;
+        record.key = key;
+        record.sequence = shard.callbackSequence.fetch_add(1);
+        record.timestamp = std::chrono::system_clock::now().time_since_epoch().count();
+        record.shard = shard.index;
+        record.fromId = fromId;
+        record.toId = toId;
+        record.errorId = errorId;
+        record.success = success;
+        return record;
+    }
+
+    /**
+     * ǰ߳ǷΪ״̬ĻصͶ߳
+     */
+    bool OnCallbackExecutor() const {
+        return CallbackExecutorOwner() == this;
+    }
+
+    static const StateMachine*& CallbackExecutorOwner() {
+        thread_local const StateMachine* owner = nullptr;
+        return owner;
+    }
+
+    /**
+     * д뱾̵߳Ļص¼壬ܳзƬʱͶ̣߳ʱȴͶ߳ڳռ䡣
+     * Ͷ߳ԼڻصзתֱӰ¼ݴһͶ
+     */
+    void EnqueueCallback(CallbackRecord&& record) {
+        if (OnCallbackExecutor()) {
+            _callbackHeld[record.shard].push_back(std::move(record));
+            return;
+        }
+        const uint32_t index = EpochDetail::CurrentThreadIndex();
+        CallbackBuffer& buffer = _callbackBuffers.Ensure(index);
+        if (_callbackBufferCount.load(std::memory_order_relaxed) <= index) {
+            uint32_t count = _callbackBufferCount.load();
+            while (count <= index && !_callbackBufferCount.compare_exchange_weak(count, index + 1)) {}
+        }
+
+        const uint32_t tail = buffer.tail.load(std::memory_order_relaxed);
+        uint32_t size = tail - buffer.head.load(std::memory_order_acquire);
+        while (size == CallbackBuffer::Capacity) {
+            // 첽صͣãͶ߳̿Ѿ˳Ϊ͵Ͷһ¼
+            if (!_asyncCallbacks.load()) {
+                std::vector<TransitionEvent> batch;
+                batch.push_back(ExpandCallbackRecord(record));
+                PublishCallbacks(batch);
+                return;
+            }
+            _callbackWake.notify_one();
+            std::this_thread::yield();
+            size = tail - buffer.head.load(std::memory_order_acquire);
+        }
+        buffer.records[tail % CallbackBuffer::Capacity] = std::move(record);
+        buffer.tail.store(tail + 1, std::memory_order_release);
+        if (size + 1 == CallbackBuffer::Capacity / 2) _callbackWake.notify_one();
+    }
+
+    /**
+     * صͶ߳ÿ flushInterval 򱻻ʱͶһֹ֣ͣǰͶʣȫ¼
+     */
+    void RunCallbackExecutor() {
+        CallbackExecutorOwner() = this;
+        std::unique_lock<std::mutex> lock(_callbackWakeMutex);
+        while (!_stopCallbacks) {
+            _callbackWake.wait_for(lock, _callbackOptions.flushInterval);
+            lock.unlock();
+            DeliverCallbacks(false);
+            lock.lock();
+        }
+        lock.unlock();
+        DeliverCallbacks(true);
+        CallbackExecutorOwner() = nullptr;
+    }
+
+    /**
+     * Ͷһ¼ȡ̻߳е¼Ƭݴ
+     * ͶÿƬһͶſʼ¼ȱʱǰ¼ȡŵδд뻺壩
+     * ¼һ֡СڴͶŵͣڼ¼ֱͶ
+     * @param flushAll ǷȱͶȫݴ¼
+     */
+    void DeliverCallbacks(bool flushAll) {
+        const uint32_t count = _callbackBufferCount.load();
+        for (uint32_t i = 0; i < count; ++i) {
+            // ̱߳ڽڷ䣬ŽС߳δù״̬
+            if (!_callbackBuffers.IsAllocated(i)) continue;
+            CallbackBuffer& buffer = _callbackBuffers[i];
+            uint32_t head = buffer.head.load(std::memory_order_relaxed);
+            const uint32_t tail = buffer.tail.load(std::memory_order_acquire);
+            for (; head != tail; ++head) {
+                CallbackRecord& record = buffer.records[head % CallbackBuffer::Capacity];
+                _callbackHeld[record.shard].push_back(std::move(record));
+            }
+            buffer.head.store(head, std::memory_order_release);
+        }
+
+        std::vector<TransitionEvent> events;
+        for (size_t i = 0; i < ShardCount; ++i) {
+            auto& held = _callbackHeld[i];
+            if (held.empty()) continue;
+            std::sort(held.begin(), held.end(),
+                [](const CallbackRecord& a, const CallbackRecord& b) { return a.sequence < b.sequence; });
+            uint64_t& next = _callbackNext[i];
+            size_t ready = 0;
+            for (; ready < held.size() && (flushAll || held[ready].sequence <= next); ++ready) {
+                if (held[ready].sequence >= next) next = held[ready].sequence + 1;
+                events.push_back(ExpandCallbackRecord(held[ready]));
+            }
+            held.erase(held.begin(), held.begin() + ready);
+        }
+
+        // ݴϣڻصзת԰ȫطݴ
+        const size_t batchSize = _callbackOptions.maxBatchSize;
+        for (size_t offset = 0; offset < events.size(); offset += batchSize) {
+            const size_t end = std::min(events.size(), offset + batchSize);
+            if (offset == 0 && end == events.size()) {
+                PublishCallbacks(events);
+                break;
+            }
+            PublishCallbacks(std::vector<TransitionEvent>(
+                std::make_move_iterator(events.begin() + offset), std::make_move_iterator(events.begin() + end)));
+        }
+    }
+
+    /**
+     * һ¼ߣתصʧܻص׳쳣
+     */
+    void PublishCallbacks(const std::vector<TransitionEvent>& batch) {
+        std::shared_ptr<const SubscriberList> subscribers;
+        {
+            std::lock_guard<std::mutex> lock(_subscriberMutex);
+            subscribers = _subscribers;
+        }
+        for (const auto& subscriber : *subscribers) {
+            try {
+                (*subscriber.second)(batch);
+            }
+            catch (...) {}
+        }
+        if (!_onAfterTransition && !_onTransitionFailed) return;
+        for (const auto& event : batch) {
+            try {
+                if (event.success) {
+                    if (_onAfterTransition) _onAfterTransition(event.key, event.fromState, event.toState);
+                }
+                else if (_onTransitionFailed) {
+                    _onTransitionFailed(event.key, event.fromState, event.toState, std::runtime_error(event.error));
+                }
+            }
+            catch (...) {}
+        }
+    }
+
+    /**
+     * ѽ¼ԭΪߵ¼
+     */
+    TransitionEvent ExpandCallbackRecord(CallbackRecord& record) const {
+        TransitionEvent event;
+        event.key = std::move(record.key);
+        event.fromState = record.fromId == NoStateId ? TState() : _stateIds.Resolve(record.fromId);
+        event.toState = _stateIds.Resolve(record.toId);
+        event.success = record.success;
+        if (!event.success) event.error = _messageIds.Resolve(record.errorId);
+        event.timestamp = std::chrono::system_clock::time_point(std::chrono::system_clock::duration(record.timestamp));
+        return event;
+    }
+
+    /**
+     * ȡǰ̵߳ͳƲۣ״ʹʱǼ
+     */
+    ThreadMetrics& LocalMetrics() {
+        const uint32_t index = EpochDetail::CurrentThreadIndex();
+        ThreadMetrics& metrics = _metrics.Ensure(index);
+        if (_metricsCount.load(std::memory_order_relaxed) <= index) {
+            uint32_t count = _metricsCount.load();
+            while (count <= index && !_metricsCount.compare_exchange_weak(count, index + 1)) {}
+        }
+        return metrics;
+    }
+
+    /**
+     *  system_clock Ϊ
+     */
+    static uint64_t TicksToNanoseconds(int64_t ticks) {
+        return static_cast<uint64_t>(std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::duration(ticks)).count()));
+    }
+
+    /**
+     * ȡǰ߳ĳתߵͳ
+     */
+    EdgeMetrics& LocalEdge(ThreadMetrics& metrics, uint32_t fromId, uint32_t toId) {
+        return metrics.edges.Ensure(_edgeIds.Intern((uint64_t(fromId) << 32) | toId));
+    }
+
+    /**
+     * ¼һγɹתӿʼɵĺʱ
+     */
+    void RecordEdgeLatency(ThreadMetrics& metrics, uint32_t fromId, uint32_t toId,
+        std::chrono::steady_clock::time_point start) {
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        LocalEdge(metrics, fromId, toId).latency.Record(
+            static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+    /**
+     * ¼һתʧ
+     */
+    void RecordEdgeFailure(ThreadMetrics& metrics, uint32_t fromId, uint32_t toId) {
+        LatencyHistogram::Increment(LocalEdge(metrics, fromId, toId).failures);
+    }
+
+    /**
+     * ¼ʵ뿪ĳ״̬ǰͣʱ
+     * @param stateId 뿪״̬
+     * @param ticks ͣʱsystem_clock 
+     */
+    void RecordDwell(uint32_t stateId, int64_t ticks) {
+        LocalMetrics().dwell.Ensure(stateId).Record(TicksToNanoseconds(ticks));
+    }
+
+    /**
+     * жϲλǷ첽תռãзƬ
+     */
+    static bool IsReserved(const Shard& shard, uint32_t slot) {
+        return !shard.reservations.empty() && shard.reservations.count(slot) != 0;
+    }
+
+    /**
+     * ռüĵȴ壺ʱֱռãѱռʱʧܻЭ̹ȴУ
+     * ǰһռͷʱֱӰռȨƽҲλ֮ѱƳʱʧ
+     */
+    struct ReservationAwaiter {
+        Shard* shard;
+        uint32_t slot;
+        uint32_t generation; // Ҳλʱĸô
+        ReservationPolicy policy;
+        bool acquired = false;
+
+        bool await_ready() const noexcept { return false; }
+
+        bool await_suspend(std::coroutine_handle<> handle) {
+            std::unique_lock<std::shared_mutex> lock(shard->mutex);
+            if (shard->records[slot].generation != generation || (shard->stateWords[slot].load() & EvictedBit)) {
+                return false;
+            }
+            auto it = shard->reservations.find(slot);
+            if (it == shard->reservations.end()) {
+                shard->reservations.emplace(slot, std::deque<std::coroutine_handle<>>());
+                RefreshSlowPathLocked(*shard, slot);
+                acquired = true;
+                return false;
+            }
+            if (policy == ReservationPolicy::FailFast) return false;
+            // Ӻָ̱̻֮߳ٷʱ
+            acquired = true;
+            it->second.push_back(handle);
+            return true;
+        }
+
+        bool await_resume() const noexcept { return acquired; }
+    };
+
+    /**
+     * ͷżռãŶʱռȨƽЭָ̲
+     */
+    void ReleaseReservation(Shard& shard, uint32_t slot) {
+        std::coroutine_handle<> next;
+        {
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            auto it = shard.reservations.find(slot);
+            if (it == shard.reservations.end()) return;
+            if (it->second.empty()) {
+                shard.reservations.erase(it);
+                RefreshSlowPathLocked(shard, slot);
+            }
+            else {
+                next = it->second.front();
+                it->second.pop_front();
+            }
+        }
+        if (next) ResumeWaiter(next);
+    }
+
+    /**
+     * ָŶӵЭ̣ͬһ߳Ƕ׻ָʱΪѭִУŶջ޼
+     */
+    static void ResumeWaiter(std::coroutine_handle<> handle) {
+        thread_local std::deque<std::coroutine_handle<>>* pending = nullptr;
+        if (pending) {
+            pending->push_back(handle);
+            return;
+        }
+        std::deque<std::coroutine_handle<>> local{ handle };
+        pending = &local;
+        while (!local.empty()) {
+            auto next = local.front();
+            local.pop_front();
+            next.resume();
+        }
+        pending = nullptr;
+    }
+
+    /**
+     * ӦһԤд־¼ʱ¼ڵǰ״̬ʱ
+     * @param record ־¼
+     * @return ǷӦ
+     */
+    bool ApplyLoggedTransition(const TransitionLogRecord<TKey, TState>& record) {
+        const uint32_t toId = _stateIds.Intern(record.toState);
+        const uint32_t reasonId = _reasonIds.Intern(*record.reason);
+        const size_t hash = std::hash<TKey>{}(record.key);
+        Shard& shard = ShardOf(hash);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        uint32_t slot;
+        if (!FindOrReloadLocked(shard, record.key, hash, slot)) {
+            ContextRecord initial;
+            initial.stateId = _stateIds.Intern(record.fromState);
+            slot = UpsertContextLocked(shard, record.key, hash, initial, nullptr);
+        }
+        else if (record.timestamp <= shard.records[slot].lastUpdated) {
+            return false;
+        }
+
+        RecordHistory(shard, slot, toId, reasonId, record.timestamp);
+        SetStateWordLocked(shard, slot, toId);
+        MoveToStateLocked(shard, slot, toId);
+        shard.records[slot].lastUpdated = record.timestamp;
+        return true;
+    }
+
+    /**
+     * ¼״̬ʷ HistoryLimit ʱɵĿ
+     * @param shard Ƭ
+     * @param slot λ
+     * @param stateId ״̬
+     * @param reasonId ԭ
+     * @param time ʱ䣨system_clock 
+     */
+    void RecordHistory(Shard& shard, uint32_t slot, uint32_t stateId, uint32_t reasonId, int64_t time) {
+        std::unique_ptr<HistoryBuffer>& history = shard.histories[slot];
+        if (!history) history.reset(new HistoryBuffer());
+        history->Push(HistoryEntry{ time, stateId, reasonId }, HistoryLimit);
+    }
+
+    /**
+     * ųʱ
+     * @param keyId ״̬
+     * @param duration ʱʱ
+     */
+    void ScheduleTimeout(uint32_t keyId, std::chrono::milliseconds duration) {
+        std::lock_guard<std::mutex> lock(_timeoutQueueMutex);
+        auto expireTime = std::chrono::system_clock::now() + duration;
+        _timeoutQueue.emplace(TimeoutTask{ keyId, expireTime });
+    }
+
+    /**
+     * ʱɨ߳ڼ鳬ʱ
+     */
+    void CheckTimeouts() {
+        while (!_stopScanner.load()) {
+            std::this_thread::sleep_for(std::chrono::seconds(1)); // ÿһ
+            auto now = std::chrono::system_clock::now();
+
+            // ռѹڵļ
+            std::vector<uint32_t> expiredKeys;
+            {
+                std::lock_guard<std::mutex> lock(_timeoutQueueMutex);
+                while (!_timeoutQueue.empty() && _timeoutQueue.top().expireTime <= now) {
+                    expiredKeys.push_back(_timeoutQueue.top().keyId);
+                    _timeoutQueue.pop();
+                }
+            }
+
+            // йڵ״̬
+            for (const auto keyId : expiredKeys) {
+                HandleTimeout(keyId);
+            }
+        }
+    }
+
+    /**
+     * ʱ״̬
+     * @param keyId ״̬
+     */
+    void HandleTimeout(uint32_t keyId) {
+        TKey key;
+        uint32_t fallbackId;
+        {
+            Shard& shard = _shards[keyId & (ShardCount - 1)];
+            const uint32_t slot = keyId >> ShardBits;
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            if (slot >= shard.records.size()) return;
+
+            const ContextRecord& record = shard.records[slot];
+            // Ƿ˳ʱͻ״̬
+            if (record.timeoutMs == NoTimeout) return;
+
+            // Ƿĳʱڼ䷢תʱиĳʱ
+            const int64_t now = std::chrono::system_clock::now().time_since_epoch().count();
+            const auto timeout = std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                std::chrono::milliseconds(record.timeoutMs));
+            if (now - record.lastUpdated < timeout.count()) return;
+            key = shard.keys[slot];
+            fallbackId = record.fallbackStateId;
+        }
+
+        // ͷŷƬִгʱ״̬תTransition м
+        Transition(key, _stateIds.Resolve(fallbackId),
+            [](auto&&...) {},
+            "State timeout");
+    }
+
+    /**
+     * ¼־дɼ¼ɻԶ
+     * @param keyRef  MakeKeyRef ɵļãδ֪Ϊ NoKeyId
+     * @param fromId Դ״̬
+     * @param toId Ŀ״̬
      * @param success Ƿɹ
      * @param error ϢУ
+     * @param timestamp ʱ䣨system_clock 0 ʾǰʱ
+     * @param reasonId תԭ
      */
-    void RecordAudit(const TKey& key, const TState& from, const TState& to,
-        bool success, const std::string& error) {
-        std::lock_guard<std::mutex> lock(_auditLogMutex);
-        AuditLogEntry entry;
-        entry.timestamp = std::chrono::system_clock::now();
-        entry.key = key;
-        entry.fromState = from;
-        entry.toState = to;
-        entry.success = success;
-        entry.error = error;
-        _auditLog.push(entry);
+    void RecordAudit(uint64_t keyRef, uint32_t fromId, uint32_t toId,
+        bool success, const char* error, int64_t timestamp = 0, uint32_t reasonId = 0) {
+        AuditRecord record;
+        record.timestamp = timestamp ? timestamp : std::chrono::system_clock::now().time_since_epoch().count();
+        record.keyId = static_cast<uint32_t>(keyRef);
+        record.generation = static_cast<uint32_t>(keyRef >> 32);
+        record.fromState = fromId;
+        record.toState = toId;
+        record.errorId = error && *error ? InternMessage(error) : 0;
+        record.reasonId = reasonId;
+        record.success = success;
+        _auditLog.Append(record);
+    }
+
+    /**
+     * פϢ޺ͳһΪʾ
+     * @param message Ϣ
+     * @return Ϣ
+     */
+    uint32_t InternMessage(const std::string& message) {
+        uint32_t id;
+        if (_messageIds.TryGetId(message, id)) return id;
+        if (_messageIds.Size() >= MaxAuditMessages) {
+            return _messageIds.Intern("<too many distinct audit messages>");
+        }
+        return _messageIds.Intern(message);
+    }
 
-        // ־ֹڴ
-        while (_auditLog.size() > 10000) {
-            _auditLog.pop();
+    /**
+     * ڹ´ӷƬļȡƼ¼ļ
+     * @param record ռ¼
+     * @param key ڴ洢
+     * @return ǷԿɻԭڻλѱʱΪ false
+     */
+    bool TryResolveAuditKey(const AuditRecord& record, TKey& key) const {
+        if (record.keyId == NoKeyId) return false;
+        const Shard& shard = _shards[record.keyId & (ShardCount - 1)];
+        const uint32_t slot = record.keyId >> ShardBits;
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        if (shard.records[slot].generation != record.generation) return false;
+        key = shard.keys[slot];
+        return true;
+    }
+
+    /**
+     * ռ¼ԭΪ־Ŀ
+     * ڹ´ӷƬļȡλѱʱԭ޴ӻԭΪĬֵ
+     * @param record ռ¼
+     * @return ־Ŀ
+     */
+    AuditLogEntry ExpandAuditRecord(const AuditRecord& record) const {
+        AuditLogEntry entry;
+        entry.timestamp = std::chrono::system_clock::time_point(
+            std::chrono::system_clock::duration(record.timestamp));
+        if (record.keyId != NoKeyId) {
+            if (!TryResolveAuditKey(record, entry.key)) entry.key = TKey();
+            entry.fromState = _stateIds.Resolve(record.fromState);
+        }
+        else {
+            entry.key = TKey();
+            entry.fromState = TState();
         }
+        entry.toState = _stateIds.Resolve(record.toState);
+        entry.success = record.success;
+        entry.error = _messageIds.Resolve(record.errorId);
+        return entry;
     }
-};
\ No newline at end of file
+};
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "MappedFile.hpp"
+
+/**
+ * ״̬ļʽ
+ * [SnapshotHeader][Ƭݿ 0][Ƭݿ 1]...[SnapshotShardIndex x shardCount]
+ * ÿƬݿ״̬˳ƴӶɣɶн
+ */
+struct SnapshotHeader {
+    char magic[8];        // ļʶ "SMSNAP01"
+    uint32_t version;     // ʽ汾
+    uint32_t shardCount;  // Ƭݿ
+    uint64_t keyCount;    // 
+    uint64_t indexOffset; // ļеƫ
+    int64_t createdAt;    // մʱ䣨system_clock 
+};
+
+/**
+ * һƬݿ
+ */
+struct SnapshotShardIndex {
+    uint64_t offset; // ݿļеƫ
+    uint64_t size;   // ݿֽ
+    uint64_t count;  // ݿеļ¼
+};
+
+namespace SnapshotFormat {
+    constexpr char Magic[8] = { 'S', 'M', 'S', 'N', 'A', 'P', '0', '1' };
+    constexpr uint32_t Version = 1;
+}
+
+/**
+ * ддʱļύʱԭ滻Ŀļд;ʧܲƻɿ
+ */
+class SnapshotWriter {
+public:
+    /**
+     * 캯
+     * @param path ļ·
+     * @param shardCount Ƭݿ
+     */
+    SnapshotWriter(const std::string& path, uint32_t shardCount)
+        : _path(path), _tempPath(path + ".tmp"), _shardCount(shardCount) {
+        _file.open(_tempPath, std::ios::binary | std::ios::trunc);
+        if (!_file.is_open()) throw std::runtime_error("Failed to create snapshot file: " + _tempPath);
+        SnapshotHeader placeholder{};
+        _file.write(reinterpret_cast<const char*>(&placeholder), sizeof(placeholder));
+        _offset = sizeof(SnapshotHeader);
+    }
+
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+    ~SnapshotWriter() {
+        if (!_committed) {
+            _file.close();
+            std::error_code ec;
+            std::filesystem::remove(_tempPath, ec);
+        }
+    }
+
+    /**
+     * ׷һƬݿ飬밴Ƭ˳
+     * @param block 
+     * @param count ݿеļ¼
+     */
+    void WriteShard(const std::string& block, uint64_t count) {
+        if (_index.size() >= _shardCount) throw std::logic_error("Too many snapshot shards");
+        _index.push_back(SnapshotShardIndex{ _offset, block.size(), count });
+        _file.write(block.data(), static_cast<std::streamsize>(block.size()));
+        _offset += block.size();
+        _keyCount += count;
+    }
+
+    /**
+     * дļͷʱļ滻Ŀļ
+     */
+    void Commit() {
+        if (_index.size() != _shardCount) throw std::logic_error("Snapshot shards are incomplete");
+
+        SnapshotHeader header{};
+        std::memcpy(header.magic, SnapshotFormat::Magic, sizeof(header.magic));
+        header.version = SnapshotFormat::Version;
+        header.shardCount = _shardCount;
+        header.keyCount = _keyCount;
+        header.indexOffset = _offset;
+        header.createdAt = std::chrono::system_clock::now().time_since_epoch().count();
+
+        _file.write(reinterpret_cast<const char*>(_index.data()),
+            static_cast<std::streamsize>(_index.size() * sizeof(SnapshotShardIndex)));
+        _file.seekp(0);
+        _file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        _file.flush();
+        if (!_file) throw std::runtime_error("Failed to write snapshot file: " + _tempPath);
+        _file.close();
+
+        std::filesystem::rename(_tempPath, _path);
+        _committed = true;
+    }
+
+private:
+    std::string _path;                     // Ŀļ·
+    std::string _tempPath;                 // ʱļ·
+    uint32_t _shardCount;                  // Ƭݿ
+    std::ofstream _file;                   // ļ
+    uint64_t _offset = 0;                  // ǰдƫ
+    uint64_t _keyCount = 0;                // дļ
+    std::vector<SnapshotShardIndex> _index; // Ƭ
+    bool _committed = false;               // Ƿύ
+};
+
+/**
+ * նȡڴӳļУļͷƬݿɲн
+ */
+class SnapshotReader {
+public:
+    /**
+     * 캯
+     * @param path ļ·
+     */
+    explicit SnapshotReader(const std::string& path) : _file(path) {
+        if (_file.Size() < sizeof(SnapshotHeader)) throw std::runtime_error("Snapshot file too small: " + path);
+        std::memcpy(&_header, _file.Data(), sizeof(_header));
+        if (std::memcmp(_header.magic, SnapshotFormat::Magic, sizeof(_header.magic)) != 0 ||
+            _header.version != SnapshotFormat::Version) {
+            throw std::runtime_error("Not a supported snapshot file: " + path);
+        }
+
+        const uint64_t indexSize = uint64_t(_header.shardCount) * sizeof(SnapshotShardIndex);
+        if (_header.indexOffset < sizeof(SnapshotHeader) || _header.indexOffset + indexSize != _file.Size()) {
+            throw std::runtime_error("Corrupted snapshot index: " + path);
+        }
+        _index.resize(_header.shardCount);
+        std::memcpy(_index.data(), _file.Data() + _header.indexOffset, indexSize);
+        for (const auto& entry : _index) {
+            if (entry.offset < sizeof(SnapshotHeader) || entry.offset + entry.size > _header.indexOffset) {
+                throw std::runtime_error("Corrupted snapshot index: " + path);
+            }
+        }
+    }
+
+    /**
+     * ȡļͷ
+     */
+    const SnapshotHeader& Header() const {
+        return _header;
+    }
+
+    /**
+     * ȡƬݿ
+     */
+    size_t ShardCount() const {
+        return _index.size();
+    }
+
+    /**
+     * ȡƬ
+     * @param shard Ƭ
+     */
+    const SnapshotShardIndex& Index(size_t shard) const {
+        return _index.at(shard);
+    }
+
+    /**
+     * ȡƬݿʼַλӳڴУ㿽
+     * @param shard Ƭ
+     */
+    const char* ShardData(size_t shard) const {
+        return _file.Data() + _index.at(shard).offset;
+    }
+
+private:
+    MappedFile _file;                      // ӳĿļ
+    SnapshotHeader _header{};              // ļͷ
+    std::vector<SnapshotShardIndex> _index; // Ƭ
+};
@@ -0,0 +1,299 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+template<typename T>
+class Task;
+
+namespace TaskDetail {
+    /**
+     * Э̽ʱԳתƵȴߣûеȴʱյ
+     */
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+
+        template<typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            auto continuation = handle.promise().continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    /**
+     * Task ŵĹ
+     */
+    struct PromiseBase {
+        std::coroutine_handle<> continuation; // ȴЭɵЭ
+        std::exception_ptr exception;         // Э׳쳣
+
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        FinalAwaiter final_suspend() const noexcept { return {}; }
+        void unhandled_exception() noexcept { exception = std::current_exception(); }
+    };
+
+    /**
+     * Э̣ Task
+     */
+    struct DetachedCoroutine {
+        struct promise_type {
+            DetachedCoroutine get_return_object() noexcept { return {}; }
+            std::suspend_never initial_suspend() const noexcept { return {}; }
+            std::suspend_never final_suspend() const noexcept { return {}; }
+            void return_void() noexcept {}
+            void unhandled_exception() noexcept { std::terminate(); }
+        };
+    };
+}
+
+/**
+ * Э񣬱 co_await ʱſʼִУɺָȴ
+ * @tparam T Э̷ֵ
+ */
+template<typename T = void>
+class Task {
+public:
+    struct promise_type : TaskDetail::PromiseBase {
+        std::optional<T> value; // Э̷ֵ
+
+        Task get_return_object() noexcept {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        template<typename U>
+        void return_value(U&& result) {
+            value.emplace(std::forward<U>(result));
+        }
+    };
+
+    Task(Task&& other) noexcept : _handle(std::exchange(other._handle, nullptr)) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (_handle) _handle.destroy();
+            _handle = std::exchange(other._handle, nullptr);
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() {
+        if (_handle) _handle.destroy();
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        _handle.promise().continuation = awaiting;
+        return _handle;
+    }
+
+    T await_resume() {
+        if (_handle.promise().exception) std::rethrow_exception(_handle.promise().exception);
+        return std::move(*_handle.promise().value);
+    }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> handle) : _handle(handle) {}
+
+    std::coroutine_handle<promise_type> _handle; // Э̾
+};
+
+/**
+ * ޷ֵЭ
+ */
+template<>
+class Task<void> {
+public:
+    struct promise_type : TaskDetail::PromiseBase {
+        Task get_return_object() noexcept {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        void return_void() noexcept {}
+    };
+
+    Task(Task&& other) noexcept : _handle(std::exchange(other._handle, nullptr)) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (_handle) _handle.destroy();
+            _handle = std::exchange(other._handle, nullptr);
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() {
+        if (_handle) _handle.destroy();
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        _handle.promise().continuation = awaiting;
+        return _handle;
+    }
+
+    void await_resume() {
+        if (_handle.promise().exception) std::rethrow_exception(_handle.promise().exception);
+    }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> handle) : _handle(handle) {}
+
+    std::coroutine_handle<promise_type> _handle; // Э̾
+};
+
+/**
+ * Э̸
+ */
+namespace TaskUtils {
+    namespace Detail {
+        template<typename T>
+        TaskDetail::DetachedCoroutine RunAndSignal(Task<T> task, std::promise<T> result) {
+            try {
+                if constexpr (std::is_void<T>::value) {
+                    co_await task;
+                    result.set_value();
+                }
+                else {
+                    result.set_value(co_await task);
+                }
+            }
+            catch (...) {
+                result.set_exception(std::current_exception());
+            }
+        }
+
+        template<typename T>
+        TaskDetail::DetachedCoroutine RunDetached(Task<T> task) {
+            try {
+                co_await task;
+            }
+            catch (...) {
+                // еûеȴߣ쳣ڴ˶
+            }
+        }
+
+        /**
+         * ʱ̣߳ʱָЭ̣ Delay һ߳
+         */
+        class TimerQueue {
+        public:
+            static TimerQueue& Instance() {
+                static TimerQueue instance;
+                return instance;
+            }
+
+            void Schedule(std::chrono::steady_clock::time_point due, std::coroutine_handle<> handle) {
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    _timers.push(Timer{ due, _sequence++, handle });
+                }
+                _cv.notify_one();
+            }
+
+            ~TimerQueue() {
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    _stop = true;
+                }
+                _cv.notify_one();
+                if (_thread.joinable()) _thread.join();
+            }
+
+        private:
+            struct Timer {
+                std::chrono::steady_clock::time_point due;
+                uint64_t sequence;
+                std::coroutine_handle<> handle;
+                bool operator<(const Timer& other) const {
+                    return due != other.due ? due > other.due : sequence > other.sequence;
+                }
+            };
+
+            TimerQueue() : _thread([this] { Run(); }) {}
+
+            void Run() {
+                std::unique_lock<std::mutex> lock(_mutex);
+                while (!_stop) {
+                    if (_timers.empty()) {
+                        _cv.wait(lock);
+                        continue;
+                    }
+                    auto due = _timers.top().due;
+                    if (_cv.wait_until(lock, due) == std::cv_status::no_timeout &&
+                        std::chrono::steady_clock::now() < due) continue;
+                    std::vector<std::coroutine_handle<>> ready;
+                    const auto now = std::chrono::steady_clock::now();
+                    while (!_timers.empty() && _timers.top().due <= now) {
+                        ready.push_back(_timers.top().handle);
+                        _timers.pop();
+                    }
+                    lock.unlock();
+                    for (auto handle : ready) handle.resume();
+                    lock.lock();
+                }
+            }
+
+            std::mutex _mutex;
+            std::condition_variable _cv;
+            std::priority_queue<Timer> _timers;
+            uint64_t _sequence = 0;
+            bool _stop = false;
+            std::thread _thread;
+        };
+    }
+
+    /**
+     * ǰֱ߳ɣͨ mainЭ
+     * @param task ִе
+     * @return ķֵ׳쳣ڴ׳
+     */
+    template<typename T>
+    T SyncWait(Task<T> task) {
+        std::promise<T> result;
+        auto future = result.get_future();
+        Detail::RunAndSignal(std::move(task), std::move(result));
+        return future.get();
+    }
+
+    /**
+     * 񵫲ȴ
+     * @param task ִе
+     */
+    template<typename T>
+    void Spawn(Task<T> task) {
+        Detail::RunDetached(std::move(task));
+    }
+
+    /**
+     * ɵȴʱڼ䲻ռ̣߳ںڶʱ߳ϻָ
+     * @param duration ʱʱ
+     */
+    inline auto Delay(std::chrono::milliseconds duration) {
+        struct DelayAwaiter {
+            std::chrono::steady_clock::time_point due;
+            bool await_ready() const noexcept { return std::chrono::steady_clock::now() >= due; }
+            void await_suspend(std::coroutine_handle<> handle) const {
+                Detail::TimerQueue::Instance().Schedule(due, handle);
+            }
+            void await_resume() const noexcept {}
+        };
+        return DelayAwaiter{ std::chrono::steady_clock::now() + duration };
+    }
+}
@@ -0,0 +1,368 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "BinaryCodec.hpp"
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Ԥд־WALдѡ
+ */
+struct TransitionLogOptions {
+    // ˢ߳յһ¼ٵȴôԺϲ¼ͳһˢһ
+    std::chrono::microseconds groupCommitWindow{ 200 };
+    // Transition ȴ¼̵ʱ䣬0 ʾȴ첽־û
+    std::chrono::microseconds maxCommitLatency{ 2000 };
+    // ˢݴﵽֽʱˢ̣ٵȴϲ
+    size_t maxBatchBytes = 1 << 20;
+};
+
+/**
+ * Ԥд־еһ״̬ת¼
+ */
+template<typename TKey, typename TState>
+struct TransitionLogRecord {
+    TKey key;                 // ״̬
+    TState fromState;         // Դ״̬
+    TState toState;           // Ŀ״̬
+    int64_t timestamp;        // תʱ䣨system_clock 
+    uint32_t reasonId;        // תԭ
+    const std::string* reason; // תԭıָȡڲֵ
+};
+
+namespace TransitionLogFormat {
+    // ¼֡[u32 س][u32 У][]ֽΪ¼
+    constexpr uint8_t TransitionRecord = 1; // ״̬ת¼
+    constexpr uint8_t ReasonRecord = 2;     // ԭֵ¼ + ı
+    constexpr size_t FrameHeaderSize = 8;
+
+    /**
+     * FNV-1a Уͣʶдһβ¼
+     */
+    inline uint32_t Checksum(const char* data, size_t size) {
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= static_cast<uint8_t>(data[i]);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    /**
+     * Ϊ֡ͷ׷ӵ
+     */
+    inline void AppendFrame(std::string& out, const std::string& payload) {
+        BinaryCodec<uint32_t>::Write(out, static_cast<uint32_t>(payload.size()));
+        BinaryCodec<uint32_t>::Write(out, Checksum(payload.data(), payload.size()));
+        out.append(payload);
+    }
+}
+
+/**
+ * Ԥд־ȡ˳¼дһУʧܵβ¼ֹͣ
+ */
+template<typename TKey, typename TState>
+class TransitionLogReader {
+public:
+    /**
+     * 캯
+     * @param path ־ļ·
+     */
+    explicit TransitionLogReader(const std::string& path) : _file(path) {}
+
+    /**
+     * λصÿ״̬ת¼
+     * @param callback  void(const TransitionLogRecord<TKey, TState>&) Ļص
+     * @return ȡ״̬ת¼
+     */
+    template<typename Callback>
+    size_t ForEach(Callback&& callback) {
+        using namespace TransitionLogFormat;
+        const char* p = _file.Data();
+        const char* end = p + _file.Size();
+        size_t count = 0;
+        _validBytes = 0;
+
+        while (static_cast<size_t>(end - p) >= FrameHeaderSize) {
+            uint32_t length = 0, checksum = 0;
+            BinaryCodec<uint32_t>::Read(p, end, length);
+            BinaryCodec<uint32_t>::Read(p, end, checksum);
+            if (length == 0 || static_cast<size_t>(end - p) < length || Checksum(p, length) != checksum) break;
+
+            const char* payload = p;
+            const char* payloadEnd = p + length;
+            p = payloadEnd;
+            uint8_t type;
+            BinaryCodec<uint8_t>::Read(payload, payloadEnd, type);
+
+            if (type == ReasonRecord) {
+                uint32_t id;
+                std::string text;
+                if (!BinaryCodec<uint32_t>::Read(payload, payloadEnd, id) ||
+                    !BinaryCodec<std::string>::Read(payload, payloadEnd, text)) break;
+                _reasons[id] = std::move(text);
+            }
+            else if (type == TransitionRecord) {
+                TransitionLogRecord<TKey, TState> record;
+                if (!BinaryCodec<TKey>::Read(payload, payloadEnd, record.key) ||
+                    !BinaryCodec<TState>::Read(payload, payloadEnd, record.fromState) ||
+                    !BinaryCodec<TState>::Read(payload, payloadEnd, record.toState) ||
+                    !BinaryCodec<int64_t>::Read(payload, payloadEnd, record.timestamp) ||
+                    !BinaryCodec<uint32_t>::Read(payload, payloadEnd, record.reasonId)) break;
+                auto reason = _reasons.find(record.reasonId);
+                record.reason = reason != _reasons.end() ? &reason->second : &_emptyReason;
+                callback(static_cast<const TransitionLogRecord<TKey, TState>&>(record));
+                ++count;
+            }
+            else {
+                break;
+            }
+            _validBytes = static_cast<size_t>(p - _file.Data());
+        }
+        return count;
+    }
+
+    /**
+     * ȡһ ForEach ¼ռֽ֮Ϊ𻵵β
+     */
+    size_t ValidBytes() const {
+        return _validBytes;
+    }
+
+private:
+    MappedFile _file;                                 // ӳ־ļ
+    std::unordered_map<uint32_t, std::string> _reasons; // ԭֵ
+    std::string _emptyReason;                         // δԭʱʹõĿı
+    size_t _validBytes = 0;                           // ¼ֽ
+};
+
+/**
+ * ״̬תԤд־֧ύ
+ *  Append ֻѱļ¼׷ӵڴ滺ˢ̺߳ϲһд벢ֻһ fdatasync
+ */
+template<typename TKey, typename TState>
+class TransitionLog {
+public:
+    /**
+     * 캯򿪣򴴽־ļص𻵵β¼
+     * @param path ־ļ·
+     * @param options дѡ
+     */
+    TransitionLog(const std::string& path, const TransitionLogOptions& options = TransitionLogOptions())
+        : _path(path), _options(options) {
+        TruncateTornTail(path);
+#ifdef _WIN32
+        _fd = _open(path.c_str(), _O_WRONLY | _O_APPEND | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+        _fd = ::open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+#endif
+        if (_fd < 0) throw std::runtime_error("Failed to open transition log: " + path);
+        _flusher = std::thread(&TransitionLog::FlushLoop, this);
+    }
+
+    TransitionLog(const TransitionLog&) = delete;
+    TransitionLog& operator=(const TransitionLog&) = delete;
+
+    /**
+     * ˢʣ¼رļ
+     */
+    ~TransitionLog() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _pendingCv.notify_one();
+        if (_flusher.joinable()) _flusher.join();
+#ifdef _WIN32
+        _close(_fd);
+#else
+        ::close(_fd);
+#endif
+    }
+
+    /**
+     * ׷һ״̬ת¼ֻдڴ滺
+     * ͬһĵ÷б֤˳StateMachine ڷƬдڵã
+     * @return ¼־ţ WaitDurable
+     */
+    uint64_t Append(const TKey& key, const TState& from, const TState& to,
+        int64_t timestamp, uint32_t reasonId, const std::string& reason) {
+        std::string payload;
+        BinaryCodec<uint8_t>::Write(payload, TransitionLogFormat::TransitionRecord);
+        BinaryCodec<TKey>::Write(payload, key);
+        BinaryCodec<TState>::Write(payload, from);
+        BinaryCodec<TState>::Write(payload, to);
+        BinaryCodec<int64_t>::Write(payload, timestamp);
+        BinaryCodec<uint32_t>::Write(payload, reasonId);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_error.empty()) throw std::runtime_error(_error);
+        const bool wasEmpty = _pending.empty();
+
+        // ÿԭıڱļ״γʱдֵ¼
+        if (reasonId >= _definedReasons.size()) _definedReasons.resize(reasonId + 1, false);
+        if (!_definedReasons[reasonId]) {
+            std::string definition;
+            BinaryCodec<uint8_t>::Write(definition, TransitionLogFormat::ReasonRecord);
+            BinaryCodec<uint32_t>::Write(definition, reasonId);
+            BinaryCodec<std::string>::Write(definition, reason);
+            TransitionLogFormat::AppendFrame(_pending, definition);
+            _definedReasons[reasonId] = true;
+        }
+
+        TransitionLogFormat::AppendFrame(_pending, payload);
+        const uint64_t lsn = _nextLsn++;
+        if (wasEmpty || _pending.size() >= _options.maxBatchBytes) {
+            _pendingCv.notify_one();
+        }
+        return lsn;
+    }
+
+    /**
+     * ȴָŵļ¼̣ȴ maxCommitLatency
+     * @param lsn Append ص־
+     * @return ¼Ƿ
+     */
+    bool WaitDurable(uint64_t lsn) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (_durableLsn >= lsn) return true;
+        if (_options.maxCommitLatency.count() <= 0) return false;
+        return _durableCv.wait_for(lock, _options.maxCommitLatency, [&] {
+            return _durableLsn >= lsn || !_error.empty();
+        }) && _durableLsn >= lsn;
+    }
+
+    /**
+     * ȴǰ׷ӵȫ¼
+     */
+    void Flush() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        const uint64_t target = _nextLsn - 1;
+        _pendingCv.notify_one();
+        _durableCv.wait(lock, [&] { return _durableLsn >= target || !_error.empty(); });
+        if (!_error.empty()) throw std::runtime_error(_error);
+    }
+
+    /**
+     * ȡ־ļ·
+     */
+    const std::string& Path() const {
+        return _path;
+    }
+
+private:
+    /**
+     * ˢ̣߳ռһ¼һд룬һ fdatasyncȻеȴ
+     */
+    void FlushLoop() {
+        std::string batch;
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true) {
+            _pendingCv.wait(lock, [&] { return !_pending.empty() || _stop; });
+            if (_pending.empty() && _stop) break;
+
+            // ںϲڼռ¼
+            if (!_stop && _options.groupCommitWindow.count() > 0) {
+                _pendingCv.wait_for(lock, _options.groupCommitWindow, [&] {
+                    return _pending.size() >= _options.maxBatchBytes || _stop;
+                });
+            }
+
+            batch.swap(_pending);
+            _pending.clear();
+            const uint64_t batchLsn = _nextLsn - 1;
+            lock.unlock();
+
+            std::string error = WriteAndSync(batch);
+            batch.clear();
+
+            lock.lock();
+            if (!error.empty()) _error = error;
+            else _durableLsn = batchLsn;
+            _durableCv.notify_all();
+        }
+    }
+
+    /**
+     * дһݲͬ
+     * @return ϢɹʱΪ
+     */
+    std::string WriteAndSync(const std::string& batch) {
+        const char* p = batch.data();
+        size_t remaining = batch.size();
+        while (remaining > 0) {
+#ifdef _WIN32
+            int written = _write(_fd, p, static_cast<unsigned int>(remaining));
+#else
+            ssize_t written = ::write(_fd, p, remaining);
+#endif
+            if (written <= 0) return "Failed to write transition log: " + _path;
+            p += written;
+            remaining -= static_cast<size_t>(written);
+        }
+#ifdef _WIN32
+        if (_commit(_fd) != 0) return "Failed to sync transition log: " + _path;
+#elif defined(__APPLE__)
+        if (::fsync(_fd) != 0) return "Failed to sync transition log: " + _path;
+#else
+        if (::fdatasync(_fd) != 0) return "Failed to sync transition log: " + _path;
+#endif
+        return std::string();
+    }
+
+    /**
+     * صϴν̱ʱдһβ¼֤¼¼¼֮
+     */
+    static void TruncateTornTail(const std::string& path) {
+        struct stat st;
+        if (::stat(path.c_str(), &st) != 0 || st.st_size == 0) return;
+
+        size_t validBytes;
+        {
+            TransitionLogReader<TKey, TState> reader(path);
+            reader.ForEach([](const TransitionLogRecord<TKey, TState>&) {});
+            validBytes = reader.ValidBytes();
+        }
+        if (validBytes == static_cast<size_t>(st.st_size)) return;
+#ifdef _WIN32
+        int fd = _open(path.c_str(), _O_WRONLY | _O_BINARY);
+        bool ok = fd >= 0 && _chsize_s(fd, static_cast<long long>(validBytes)) == 0;
+        if (fd >= 0) _close(fd);
+#else
+        bool ok = ::truncate(path.c_str(), static_cast<off_t>(validBytes)) == 0;
+#endif
+        if (!ok) throw std::runtime_error("Failed to truncate transition log: " + path);
+    }
+
+    std::string _path;                   // ־ļ·
+    TransitionLogOptions _options;       // дѡ
+    int _fd = -1;                        // ļ
+    std::mutex _mutex;                   // 
+    std::condition_variable _pendingCv;  // ֪ͨˢ߳¼¼
+    std::condition_variable _durableCv;  // ֪ͨȴ߼¼
+    std::string _pending;                // ˢ̵ļ¼
+    uint64_t _nextLsn = 1;               // һ¼
+    uint64_t _durableLsn = 0;            // ̵
+    std::vector<bool> _definedReasons;   // д뱾ļֵԭ
+    std::string _error;                  // ˢʧʱĴϢ
+    bool _stop = false;                  // ˢֹ߳ͣ־
+    std::thread _flusher;                // ˢ߳
+};
@@ -0,0 +1,479 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "DispatchPriority.hpp"
+#include "LatencyHistogram.hpp"
+
+/**
+ * Chase-Lev ȡ˫˶У L ˵ C11 ڴ汾
+ * ߳ڵײѹ롢̴߳Ӷȡʱ̻߳СĻ飬
+ * Աȡ߶ȡʱͷ
+ * @tparam T Ԫָͣʽ
+ */
+template<typename T>
+class WorkStealingDeque {
+    /**
+     * Ϊ2ݵĻ
+     */
+    struct Ring {
+        explicit Ring(size_t capacity) : mask(capacity - 1), items(new std::atomic<T*>[capacity]) {}
+
+        size_t Capacity() const {
+            return mask + 1;
+        }
+
+        T* Get(int64_t index) const {
+            return items[static_cast<size_t>(index) & mask].load(std::memory_order_relaxed);
+        }
+
+        void Put(int64_t index, T* item) {
+            items[static_cast<size_t>(index) & mask].store(item, std::memory_order_relaxed);
+        }
+
+        size_t mask;
+        std::unique_ptr<std::atomic<T*>[]> items;
+    };
+
+public:
+    explicit WorkStealingDeque(size_t capacity = 256) {
+        size_t rounded = 1;
+        while (rounded < capacity) rounded <<= 1;
+        _rings.push_back(std::make_unique<Ring>(rounded));
+        _ring.store(_rings.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    /**
+     * ڵײѹԪأ̵ֻ߳
+     */
+    void Push(T* item) {
+        const int64_t bottom = _bottom.load(std::memory_order_relaxed);
+        const int64_t top = _top.load(std::memory_order_acquire);
+        Ring* ring = _ring.load(std::memory_order_relaxed);
+        if (bottom - top >= static_cast<int64_t>(ring->Capacity())) ring = Grow(ring, top, bottom);
+        ring->Put(bottom, item);
+        _bottom.store(bottom + 1, std::memory_order_release);
+    }
+
+    /**
+     * ӵײѹԪأ̵ֻ߳
+     * @return ԪأΪգһԪرȡʱΪָ
+     */
+    T* Pop() {
+        const int64_t bottom = _bottom.load(std::memory_order_relaxed) - 1;
+        Ring* ring = _ring.load(std::memory_order_relaxed);
+        _bottom.store(bottom, std::memory_order_seq_cst);
+        int64_t top = _top.load(std::memory_order_seq_cst);
+        if (top > bottom) {
+            _bottom.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        T* item = ring->Get(bottom);
+        if (top == bottom) {
+            // һԪأȡ߾
+            if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                item = nullptr;
+            }
+            _bottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    /**
+     * ӶȡѹԪأ̵߳
+     * @return ԪأΪջ߳̾ʧʱΪָ
+     */
+    T* Steal() {
+        int64_t top = _top.load(std::memory_order_seq_cst);
+        const int64_t bottom = _bottom.load(std::memory_order_seq_cst);
+        if (top >= bottom) return nullptr;
+        Ring* ring = _ring.load(std::memory_order_acquire);
+        T* item = ring->Get(top);
+        if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return item;
+    }
+
+    /**
+     * ǷԪأʾ
+     */
+    bool MaybeNonEmpty() const {
+        return _top.load(std::memory_order_seq_cst) < _bottom.load(std::memory_order_seq_cst);
+    }
+
+private:
+    Ring* Grow(Ring* ring, int64_t top, int64_t bottom) {
+        auto grown = std::make_unique<Ring>(ring->Capacity() * 2);
+        for (int64_t i = top; i < bottom; ++i) grown->Put(i, ring->Get(i));
+        Ring* result = grown.get();
+        _rings.push_back(std::move(grown));
+        _ring.store(result, std::memory_order_release);
+        return result;
+    }
+
+    alignas(64) std::atomic<int64_t> _top{ 0 };    // ȡ
+    alignas(64) std::atomic<int64_t> _bottom{ 0 }; // ̶߳
+    std::atomic<Ring*> _ring{ nullptr };           // ǰ
+    std::vector<std::unique_ptr<Ring>> _rings;     // ùĻ飬ֻ߳޸
+};
+
+/**
+ * ȡ̳߳
+ * ÿ̰߳ȼһ Chase-Lev ˫˶У߳ύѹԼĶвִ
+ * ʱȡȫעУⲿ߳ύ񣩣ȡ߳
+ * ȡʱߣύʱֻ߳ʱżѡ
+ * ȡʱȼӸߵβұ̶߳Сע̣߳񲻻֮ͨ
+ * ͨ͵ͨȼһȫּûʱֻС
+ * ÿ̰߳ȼ¼ύʼִеŶӳٺͳʱ޵Ĵɺϲȡ
+ * ȡʱӵĿ൱̨ͨȼʱ޵ÿ16ʱһ񶼼ʱ
+ * ֱΪ ThreadSafeEventNormal::Async ִoperator() ͬ Post
+ * ʱִύ˳
+ */
+class WorkStealingPool {
+    /**
+     * Ͳһη
+     */
+    struct TaskBase {
+        virtual ~TaskBase() = default;
+        virtual void Run() = 0;
+
+        int64_t enqueuedAt = 0;   // ύʱ䣨steady_clock 룩
+        int64_t due = INT64_MAX;  // ʼִеʱޣsteady_clock 룩ʱΪ INT64_MAX
+        uint8_t priority = 0;     // ȼ
+        bool timed = false;       // Ƿ¼ύʱ
+        bool dropExpired = false; // ʱʱǷ
+    };
+
+    template<typename F>
+    struct TaskImpl final : TaskBase {
+        template<typename G>
+        explicit TaskImpl(G&& function) : function(std::forward<G>(function)) {}
+        void Run() override { function(); }
+        F function;
+    };
+
+    /**
+     * ̵߳״̬ռ
+     */
+    struct alignas(64) Worker {
+        WorkStealingDeque<TaskBase> deques[DispatchPriorityCount];       // ȼ
+        LatencyHistogram queueLatency[DispatchPriorityCount];            // ȼŶӳ٣ֻɱ̼߳¼
+        std::atomic<uint64_t> deadlineMisses[DispatchPriorityCount]{};   // ʱ޲ſʼִеֻɱ߳д
+        std::atomic<uint64_t> expiredDrops[DispatchPriorityCount]{};     // ʱޱֻɱ߳д
+        std::thread thread;
+    };
+
+public:
+    /**
+     * ̳߳
+     * @param threadCount ߳0 ʾʹӲ
+     */
+    explicit WorkStealingPool(size_t threadCount = 0) {
+        if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+        _workers.reserve(threadCount);
+        for (size_t i = 0; i < threadCount; ++i) _workers.push_back(std::make_unique<Worker>());
+        for (size_t i = 0; i < threadCount; ++i) {
+            _workers[i]->thread = std::thread(&WorkStealingPool::RunWorker, this, i);
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    /**
+     * ִύֹͣ߳
+     */
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock(_parkMutex);
+            _stopping = true;
+            ++_wakeSignal;
+        }
+        _parkCondition.notify_all();
+        for (auto& worker : _workers) worker->thread.join();
+    }
+
+    /**
+     * ύ񣬲Ľ׳쳣
+     * @param function ޲οɵö
+     * @param options ѡĬΪͨȼʱ
+     */
+    template<typename F>
+    void Post(F&& function, const DispatchOptions& options = DispatchOptions()) {
+        TaskBase* task = new TaskImpl<std::decay_t<F>>(std::forward<F>(function));
+        task->priority = static_cast<uint8_t>(options.priority);
+        task->dropExpired = options.dropExpired;
+        if (options.priority < DispatchPriority::Normal || options.deadline.count() > 0 || SampleLatency()) {
+            task->timed = true;
+            task->enqueuedAt = Now();
+            if (options.deadline.count() > 0) task->due = task->enqueuedAt + options.deadline.count();
+        }
+        Enqueue(task);
+    }
+
+    /**
+     * ύ񣬵ͬ Postʹ̳߳ؿֱִ
+     */
+    template<typename F>
+    void operator()(F&& function) {
+        Post(std::forward<F>(function));
+    }
+
+    /**
+     * ѡύ񣬵ͬ Post ThreadSafeEventNormal::Async ݶĵȼʱ
+     */
+    template<typename F>
+    void operator()(F&& function, const DispatchOptions& options) {
+        Post(std::forward<F>(function), options);
+    }
+
+    /**
+     * ύȡý
+     * @param function ޲οɵö
+     * @param options ѡ񳬹ʱޱʱ get() ׳ std::future_errorbroken_promise
+     * @return ׳쳣 get() ʱ׳
+     */
+    template<typename F>
+    auto Submit(F&& function, const DispatchOptions& options = DispatchOptions())
+        -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+        std::packaged_task<std::invoke_result_t<std::decay_t<F>>()> task(std::forward<F>(function));
+        auto future = task.get_future();
+        Post(std::move(task), options);
+        return future;
+    }
+
+    /**
+     * ȡ߳
+     */
+    size_t ThreadCount() const {
+        return _workers.size();
+    }
+
+    /**
+     * ȡĳһȼύʼִеŶӳٷֲ룩ϲй߳
+     * ̨ͨȼΪԼΪ1/16
+     * @param priority ȼ
+     */
+    HistogramSnapshot QueueLatency(DispatchPriority priority) const {
+        HistogramSnapshot snapshot;
+        for (const auto& worker : _workers) worker->queueLatency[static_cast<size_t>(priority)].AddTo(snapshot);
+        return snapshot;
+    }
+
+    /**
+     * ȡĳһȼʱ޲ſʼִУ򱻶
+     * @param priority ȼ
+     */
+    uint64_t DeadlineMissCount(DispatchPriority priority) const {
+        uint64_t count = 0;
+        for (const auto& worker : _workers) {
+            count += worker->deadlineMisses[static_cast<size_t>(priority)].load(std::memory_order_relaxed);
+        }
+        return count;
+    }
+
+    /**
+     * ȡĳһȼ򳬹ʱޱûִе
+     * @param priority ȼ
+     */
+    uint64_t ExpiredDropCount(DispatchPriority priority) const {
+        uint64_t count = 0;
+        for (const auto& worker : _workers) {
+            count += worker->expiredDrops[static_cast<size_t>(priority)].load(std::memory_order_relaxed);
+        }
+        return count;
+    }
+
+private:
+    /**
+     * ǰ̳߳߳빤̱߳ţǹ߳Ϊ
+     */
+    struct CurrentWorker {
+        const WorkStealingPool* pool = nullptr;
+        size_t index = 0;
+    };
+
+    static CurrentWorker& Current() {
+        thread_local CurrentWorker current;
+        return current;
+    }
+
+    static int64_t Now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /**
+     * ύ߳ÿ16ηһ trueͨǷʱ
+     */
+    static bool SampleLatency() {
+        thread_local uint32_t tick = 0;
+        return (++tick & 15) == 0;
+    }
+
+    /**
+     * ͨȼǼȫּУʱݴûȼ
+     */
+    static bool Counted(size_t priority) {
+        return priority != static_cast<size_t>(DispatchPriority::Normal);
+    }
+
+    void Enqueue(TaskBase* task) {
+        const size_t priority = task->priority;
+        // ȵǼӣΪ0ʱһû
+        if (Counted(priority)) _queued[priority].fetch_add(1);
+        const CurrentWorker& current = Current();
+        if (current.pool == this) {
+            _workers[current.index]->deques[priority].Push(task);
+        }
+        else {
+            std::lock_guard<std::mutex> lock(_injectMutex);
+            _injected[priority].push_back(task);
+            _injectedCount[priority].store(_injected[priority].size());
+        }
+        // öд̵߳ĵǼҪô̶߲߳ѣ
+        // ҪôߵĵǼǶд룬Ӷڸʱ
+        if (_sleeping.fetch_add(0) > 0) {
+            {
+                std::lock_guard<std::mutex> lock(_parkMutex);
+                ++_wakeSignal;
+            }
+            _parkCondition.notify_one();
+        }
+    }
+
+    TaskBase* TakeInjected(size_t priority) {
+        if (_injectedCount[priority].load() == 0) return nullptr;
+        std::lock_guard<std::mutex> lock(_injectMutex);
+        std::deque<TaskBase*>& injected = _injected[priority];
+        if (injected.empty()) return nullptr;
+        TaskBase* task = injected.front();
+        injected.pop_front();
+        _injectedCount[priority].store(injected.size());
+        return task;
+    }
+
+    /**
+     * λÿʼγȡ߳ĳһȼ
+     */
+    TaskBase* StealFromOthers(size_t self, size_t priority, uint64_t& random) {
+        const size_t count = _workers.size();
+        random ^= random << 13;
+        random ^= random >> 7;
+        random ^= random << 17;
+        const size_t start = static_cast<size_t>(random % count);
+        for (size_t i = 0; i < count; ++i) {
+            const size_t victim = (start + i) % count;
+            if (victim == self) continue;
+            if (TaskBase* task = _workers[victim]->deques[priority].Steal()) return task;
+        }
+        return nullptr;
+    }
+
+    TaskBase* FindTask(size_t self, uint64_t& random) {
+        for (size_t priority = 0; priority < DispatchPriorityCount; ++priority) {
+            if (Counted(priority) && _queued[priority].load() == 0) continue;
+            TaskBase* task = _workers[self]->deques[priority].Pop();
+            if (!task) task = TakeInjected(priority);
+            if (!task) task = StealFromOthers(self, priority, random);
+            if (task) {
+                if (Counted(priority)) _queued[priority].fetch_sub(1);
+                return task;
+            }
+        }
+        return nullptr;
+    }
+
+    bool HasVisibleWork() const {
+        for (size_t priority = 0; priority < DispatchPriorityCount; ++priority) {
+            if (_injectedCount[priority].load() != 0) return true;
+            for (const auto& worker : _workers) {
+                if (worker->deques[priority].MaybeNonEmpty()) return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * ¼Ŷӳʱޣִ
+     */
+    void RunTask(Worker& worker, TaskBase* task) {
+        bool run = true;
+        if (task->timed) {
+            const int64_t now = Now();
+            const size_t priority = task->priority;
+            worker.queueLatency[priority].Record(static_cast<uint64_t>(std::max<int64_t>(now - task->enqueuedAt, 0)));
+            if (now > task->due) {
+                LatencyHistogram::Increment(worker.deadlineMisses[priority]);
+                if (task->dropExpired) {
+                    LatencyHistogram::Increment(worker.expiredDrops[priority]);
+                    run = false;
+                }
+            }
+        }
+        if (run) {
+            try {
+                task->Run();
+            }
+            catch (...) {}
+        }
+        delete task;
+    }
+
+    void RunWorker(size_t self) {
+        Current() = CurrentWorker{ this, self };
+        uint64_t random = 0x9E3779B97F4A7C15ull * (self + 1);
+        for (;;) {
+            TaskBase* task = FindTask(self, random);
+            // ȡʧܣǰԼ
+            for (int spin = 0; !task && spin < 64; ++spin) {
+                std::this_thread::yield();
+                task = FindTask(self, random);
+            }
+            if (task) {
+                RunTask(*_workers[self], task);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(_parkMutex);
+            _sleeping.fetch_add(1);
+            if (HasVisibleWork()) {
+                _sleeping.fetch_sub(1);
+                continue;
+            }
+            if (_stopping) {
+                _sleeping.fetch_sub(1);
+                return;
+            }
+            const uint64_t signal = _wakeSignal;
+            _parkCondition.wait(lock, [&] { return _wakeSignal != signal || _stopping; });
+            _sleeping.fetch_sub(1);
+        }
+    }
+
+    std::vector<std::unique_ptr<Worker>> _workers;                 // ߳
+    std::deque<TaskBase*> _injected[DispatchPriorityCount];        // ȼȫעУⲿ߳ύ
+    std::mutex _injectMutex;                                       // ע
+    std::atomic<size_t> _injectedCount[DispatchPriorityCount]{};   // עгȣп
+    std::atomic<uint32_t> _queued[DispatchPriorityCount]{};        // ͨȼύδȡ
+    std::atomic<uint32_t> _sleeping{ 0 };          // ѵǼߵĹ߳
+    std::mutex _parkMutex;                         // 뻽ѻ
+    std::condition_variable _parkCondition;        // ߵĹ߳ڴ˵ȴ
+    uint64_t _wakeSignal = 0;                      // Ѽ _parkMutex 
+    bool _stopping = false;                        // ֹͣ־ _parkMutex 
+};